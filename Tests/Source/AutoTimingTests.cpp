@@ -0,0 +1,78 @@
+#include <JuceHeader.h>
+#include "KcompTestHelpers.h"
+
+using namespace KcompTestHelpers;
+
+//==============================================================================
+class AutoTimingTests : public juce::UnitTest
+{
+public:
+
+    AutoTimingTests() : juce::UnitTest("Auto timing", "Kcomp") {}
+
+    void runTest() override
+    {
+        beginTest("Same gain reduction as the knobs on a steady sine");
+        {
+            const auto input = makeSignal<float>(2, 48000, [](int, int i) { return sine(1000.0, 0.5f, i); });
+
+            const auto manualDb = getRMSDb(run(input, false), 0, 24000, 24000);
+            const auto autoDb = getRMSDb(run(input, true), 0, 24000, 24000);
+            expectLessThan(manualDb, getRMSDb(input, 0, 24000, 24000) - 6.0, "compressing");
+            expectWithinAbsoluteError(autoDb, manualDb, 0.5, "auto against manual");
+        }
+
+        beginTest("Short bursts let go faster than long stretches");
+        {
+            const auto shortRecovery = getRecoverySamples(960, true);
+            const auto longRecovery = getRecoverySamples(96000, true);
+            logMessage("recovery after 20 ms: " + juce::String(shortRecovery) + " samples, after 2 s: " + juce::String(longRecovery) + " samples");
+            expectLessThan(shortRecovery * 2, longRecovery, "auto release");
+
+            //the knobs alone recover the same way whatever came before
+            const auto manualShort = getRecoverySamples(960, false);
+            const auto manualLong = getRecoverySamples(96000, false);
+            expectLessOrEqual(std::abs(manualShort - manualLong), periodSamples, "manual release");
+        }
+    }
+
+private:
+
+    static constexpr int periodSamples = 48;    //1 kHz
+
+    static juce::AudioBuffer<float> run(const juce::AudioBuffer<float>& input, bool autoTiming)
+    {
+        KcompEngine<float>::Parameters params;
+        params.thresholdDb = -20.0f;
+        params.attackMs = 5.0f;
+        params.releaseMs = 100.0f;
+        params.autoTiming = autoTiming;
+
+        KcompEngine<float> engine;
+        prepareEngine(engine, params, 2);
+        return process(engine, input);
+    }
+
+    //A loud 1 kHz sine for burstSamples, then the same sine 40 dB down, under the threshold: the samples until the
+    //quiet part comes back to within 1 dB of where it went in
+    static int getRecoverySamples(int burstSamples, bool autoTiming)
+    {
+        constexpr int quietSamples = 96000;
+        const auto input = makeSignal<float>(2, burstSamples + quietSamples, [burstSamples](int, int i)
+        {
+            return sine(1000.0, i < burstSamples ? 0.9f : 0.009f, i);
+        });
+
+        const auto output = run(input, autoTiming);
+        for (int start = burstSamples; start + periodSamples <= input.getNumSamples(); start += periodSamples)
+        {
+            if (getRMSDb(output, 0, start, periodSamples) > getRMSDb(input, 0, start, periodSamples) - 1.0)
+            {
+                return start - burstSamples;
+            }
+        }
+        return quietSamples;
+    }
+};
+
+static AutoTimingTests autoTimingTests;
@@ -0,0 +1,95 @@
+#include <JuceHeader.h>
+#include "KcompTestHelpers.h"
+
+using namespace KcompTestHelpers;
+
+//==============================================================================
+/*
+    Threshold automation through scheduleParameters(), the way the processor
+    hands it over: one value per host buffer, where the automation is at its
+    end. On DC the envelope sits still, so the output gives away the
+    threshold the engine used at every sample.
+*/
+class AutomationTests : public juce::UnitTest
+{
+public:
+
+    AutomationTests() : juce::UnitTest("Automation", "Kcomp") {}
+
+    void runTest() override
+    {
+        beginTest("2048 and 4096 sample buffers follow the same threshold automation");
+        {
+            const auto small = run(2048);
+            const auto large = run(4096);
+
+            expectLessOrEqual(getMaxDifference(small, large), 1.0e-4, "2048 against 4096");
+
+            //both are where the automation is at the end of every 2048 samples, not 50 ms behind it
+            auto worst = 0.0;
+            for (int end = 2048; end <= numSamples; end += 2048)
+            {
+                for (const auto* output : { &small, &large })
+                {
+                    worst = juce::jmax(worst, std::abs(getThresholdDb(output->getSample(0, end - 1)) - getAutomationDb(end)));
+                }
+            }
+            expectLessOrEqual(worst, 0.05, "threshold at the buffer ends");
+        }
+    }
+
+private:
+
+    static constexpr int settle = 24576;
+    static constexpr int sweep = 16384;
+    static constexpr int numSamples = settle + sweep + 8192;
+    static constexpr float level = 0.5f;
+
+    //-20 dB while the envelope settles, up to -10 dB over the sweep, then held
+    static double getAutomationDb(int sample)
+    {
+        return -20.0 + 10.0 * juce::jlimit(0.0, 1.0, double(sample - settle) / sweep);
+    }
+
+    //Hard knee at 4:1 with the DC over the threshold: reduction is 3/4 of the overshoot
+    static double getThresholdDb(float output)
+    {
+        const auto levelDb = juce::Decibels::gainToDecibels(double(level));
+        return levelDb + (juce::Decibels::gainToDecibels(double(output)) - levelDb) / 0.75;
+    }
+
+    static juce::AudioBuffer<float> run(int hostBlockSize)
+    {
+        KcompEngine<float>::Parameters params;
+        params.attackMs = 1.0f;
+        params.releaseMs = 10.0f;
+        params.thresholdDb = float(getAutomationDb(0));
+
+        KcompEngine<float> engine;
+        prepareEngine(engine, params, 2);
+
+        const auto input = makeSignal<float>(2, numSamples, [](int, int) { return level; });
+        juce::AudioBuffer<float> output(2, numSamples), block(2, hostBlockSize);
+        for (int start = 0; start < numSamples; start += hostBlockSize)
+        {
+            const auto num = juce::jmin(hostBlockSize, numSamples - start);
+            block.setSize(2, num, false, false, true);
+            for (int channel = 0; channel < 2; ++channel)
+            {
+                block.copyFrom(channel, 0, input, channel, start, num);
+            }
+
+            params.thresholdDb = float(getAutomationDb(start + num));
+            engine.scheduleParameters(params);
+            engine.process(block);
+
+            for (int channel = 0; channel < 2; ++channel)
+            {
+                output.copyFrom(channel, start, block, channel, 0, num);
+            }
+        }
+        return output;
+    }
+};
+
+static AutomationTests automationTests;
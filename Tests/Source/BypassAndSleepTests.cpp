@@ -0,0 +1,197 @@
+#include <JuceHeader.h>
+#include "KcompTestHelpers.h"
+
+using namespace KcompTestHelpers;
+
+//==============================================================================
+class BypassAndSleepTests : public juce::UnitTest
+{
+public:
+
+    BypassAndSleepTests() : juce::UnitTest("Bypass and sleep", "Kcomp") {}
+
+    void runTest() override
+    {
+        testBypassCrossfade();
+        testSleepAndWake();
+        testTail();
+    }
+
+private:
+
+    //DC in, so the wet side is a steady make-up times the input and every step of the crossfade shows. Coming
+    //back, the wet path starts over and the crossfade waits for its delay lines to refill.
+    void testBypassCrossfade()
+    {
+        beginTest("Bypass crossfades to the delayed dry signal and back");
+
+        constexpr float dc = 0.1f, makeUp = 4.0f;
+        constexpr int bypassBlock = 20, returnBlock = 60, numBlocks = 100;
+        const auto rampSamples = juce::roundToInt(KcompEngine<float>::rampLengthSeconds * sampleRate);
+
+        KcompEngine<float>::Parameters params;
+        params.makeUpGain = makeUp;
+        params.lookaheadMs = 2.0f;
+
+        KcompEngine<float> engine;
+        prepareEngine(engine, params, 2);
+        const auto latency = engine.getLatencySamples();
+
+        const auto input = makeSignal<float>(2, numBlocks * blockSize, [](int, int) { return dc; });
+        const auto output = process(engine, input, [&](int block)
+        {
+            if (block == bypassBlock || block == returnBlock)
+            {
+                params.bypassed = block == bypassBlock;
+                engine.setParameters(params);
+            }
+        });
+
+        const auto bypassStart = bypassBlock * blockSize, returnStart = returnBlock * blockSize;
+        const auto returnRampStart = returnStart + latency;
+        auto wetBefore = true, monotonic = true, dryAfter = true, wetAfter = true;
+        float largestStep = 0.0f;
+
+        for (int i = latency + 1; i < output.getNumSamples(); ++i)
+        {
+            const auto y = output.getSample(0, i), previous = output.getSample(0, i - 1);
+
+            if (i < bypassStart)
+            {
+                wetBefore = wetBefore && std::abs(y - dc * makeUp) < 1.0e-6f;
+            }
+            else if (i < bypassStart + rampSamples)
+            {
+                monotonic = monotonic && y <= previous;
+                largestStep = juce::jmax(largestStep, std::abs(y - previous));
+            }
+            else if (i < returnRampStart)
+            {
+                dryAfter = dryAfter && std::abs(y - dc) < 1.0e-6f;
+            }
+            else if (i < returnRampStart + rampSamples)
+            {
+                monotonic = monotonic && y >= previous;
+                largestStep = juce::jmax(largestStep, std::abs(y - previous));
+            }
+            else
+            {
+                wetAfter = wetAfter && std::abs(y - dc * makeUp) < 1.0e-6f;
+            }
+        }
+
+        expect(wetBefore, "compressed signal before the bypass");
+        expect(monotonic, "crossfades go one way");
+        expectLessOrEqual(largestStep, 1.01f * dc * (makeUp - 1.0f) / float(rampSamples), "crossfade steps are one ramp length's worth");
+        expect(dryAfter, "bypassed output is the delayed input until the wet path has refilled");
+        expect(wetAfter, "compressed signal after the bypass");
+    }
+
+    void testSleepAndWake()
+    {
+        beginTest("Sleeps on silence, wakes like a fresh engine");
+
+        constexpr int noiseBlocks = 40, silentBlocks = 200, numBlocks = 2 * noiseBlocks + silentBlocks;
+
+        KcompEngine<float>::Parameters params;
+        params.thresholdDb = -20.0f;
+        params.releaseMs = 50.0f;
+        params.lookaheadMs = 2.0f;
+        params.tameEnabled = true;
+
+        auto random = getRandom();
+        const auto input = makeSignal<float>(2, numBlocks * blockSize, [&random](int, int i)
+        {
+            const auto block = i / blockSize;
+            return block < noiseBlocks || block >= noiseBlocks + silentBlocks ? random.nextFloat() * 2.0f - 1.0f : 0.0f;
+        });
+
+        KcompEngine<float> engine;
+        prepareEngine(engine, params, 2);
+
+        auto sleptAt = -1;
+        auto sleepingWithSignal = false;
+        const auto output = process(engine, input, [&](int block)
+        {
+            if (block > 0 && engine.isSleeping())
+            {
+                sleptAt = sleptAt < 0 ? block - 1 : sleptAt;
+                sleepingWithSignal = sleepingWithSignal || block - 1 < noiseBlocks || block - 1 >= noiseBlocks + silentBlocks;
+            }
+        });
+
+        expectGreaterOrEqual(sleptAt, noiseBlocks, "went to sleep in the silence");
+        expect(! sleepingWithSignal, "never asleep while there's signal");
+
+        //the delayed end of the noise still comes out before the engine sleeps
+        const auto silenceStart = noiseBlocks * blockSize;
+        expectGreaterThan(output.getMagnitude(0, silenceStart, engine.getLatencySamples()), 0.0f, "lookahead tail is played out");
+
+        auto silentOutput = true;
+        for (int i = (sleptAt + 1) * blockSize; i < (noiseBlocks + silentBlocks) * blockSize; ++i)
+        {
+            silentOutput = silentOutput && output.getSample(0, i) == 0.0f && output.getSample(1, i) == 0.0f;
+        }
+        expect(silentOutput, "silence out while asleep");
+
+        //after waking up it carries on as if it had just been prepared
+        const auto wakeStart = (noiseBlocks + silentBlocks) * blockSize;
+        juce::AudioBuffer<float> lastNoise(2, noiseBlocks * blockSize);
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            lastNoise.copyFrom(channel, 0, input, channel, wakeStart, noiseBlocks * blockSize);
+        }
+
+        KcompEngine<float> fresh;
+        prepareEngine(fresh, params, 2);
+        const auto freshOutput = process(fresh, lastNoise);
+
+        auto difference = 0.0f;
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            for (int i = 0; i < freshOutput.getNumSamples(); ++i)
+            {
+                difference = juce::jmax(difference, std::abs(output.getSample(channel, wakeStart + i) - freshOutput.getSample(channel, i)));
+            }
+        }
+        expectLessOrEqual(difference, 1.0e-5f, "wakes without a click");
+    }
+
+    //Full-scale noise, then silence: the engine has to be asleep by the time getTailSeconds() says the tail is over
+    void testTail()
+    {
+        beginTest("Sleeps within getTailSeconds()");
+
+        for (auto releaseMs : { 20.0f, 100.0f, 400.0f })
+        {
+            KcompEngine<float>::Parameters params;
+            params.thresholdDb = -30.0f;
+            params.releaseMs = releaseMs;
+            params.lookaheadMs = 5.0f;
+
+            KcompEngine<float> engine;
+            prepareEngine(engine, params, 2);
+
+            const auto tailSamples = int(std::ceil(engine.getTailSeconds() * sampleRate));
+            constexpr int noiseSamples = 20 * blockSize;
+
+            auto random = getRandom();
+            const auto input = makeSignal<float>(2, noiseSamples + tailSamples + 4 * blockSize, [&random](int, int i)
+            {
+                return i < noiseSamples ? random.nextFloat() * 2.0f - 1.0f : 0.0f;
+            });
+
+            auto sleptAt = -1;
+            process(engine, input, [&](int block)
+            {
+                sleptAt = sleptAt < 0 && block > 0 && engine.isSleeping() ? block * blockSize : sleptAt;
+            });
+
+            expect(sleptAt >= noiseSamples, "asleep only after the input stopped");
+            //the engine decides at the start of a block and the test only looks between blocks
+            expectLessOrEqual(sleptAt, noiseSamples + tailSamples + 2 * blockSize, "asleep within the tail, release " + juce::String(releaseMs, 0) + " ms");
+        }
+    }
+};
+
+static BypassAndSleepTests bypassAndSleepTests;
@@ -0,0 +1,140 @@
+#include <JuceHeader.h>
+#include <numeric>
+#include "KcompDetector.h"
+
+//==============================================================================
+class DetectorTests : public juce::UnitTest
+{
+public:
+
+    DetectorTests() : juce::UnitTest("Detector", "Kcomp") {}
+
+    void runTest() override
+    {
+        testWindowLength();
+        testAgainstNaiveRMS();
+        testTruePeak();
+    }
+
+private:
+
+    using Detector = KcompDetector<float>;
+    using Vec = Detector::Vec;
+
+    static constexpr double sampleRate = 48000.0;
+
+    //The same value in every lane, lane 0 back out
+    static float process(Detector& detector, float key)
+    {
+        float out[Detector::lanes];
+        KcompSIMD::store(out, detector.process(0, Vec::expand(key)));
+        return out[0];
+    }
+
+    //A unit step fills the window one sample at a time: the RMS after n samples is sqrt(n / window)
+    void testWindowLength()
+    {
+        beginTest("RMS window length");
+
+        for (auto windowMs : { 1.0f, 10.0f, 300.0f })
+        {
+            Detector detector;
+            detector.setMode(Detector::Mode::rms);
+            detector.setWindow(windowMs);
+            detector.prepare(1, sampleRate);
+
+            const auto window = juce::roundToInt(windowMs * 0.001 * sampleRate);
+            auto worst = 0.0;
+            for (int n = 1; n <= 2 * window; ++n)
+            {
+                const auto expected = std::sqrt(double(juce::jmin(n, window)) / window);
+                worst = juce::jmax(worst, std::abs(process(detector, 1.0f) - expected));
+            }
+            expectLessOrEqual(worst, 1.0e-5, juce::String(windowMs) + " ms");
+        }
+    }
+
+    //Noise that drops by 60 dB, through window changes in both directions and many trips round the ring, against the
+    //plain sum of the last window's squares. Oversampled, so each ring entry is four frames.
+    void testAgainstNaiveRMS()
+    {
+        beginTest("RMS matches a plain sum through window changes");
+
+        constexpr int order = 2, framesPerSample = 1 << order, numSamples = 96000;
+
+        Detector detector;
+        detector.setMode(Detector::Mode::rms);
+        detector.setWindow(5.0f);
+        detector.prepare(1, sampleRate);
+        detector.setOversamplingOrder(order);
+
+        auto random = getRandom();
+        std::vector<double> squares;
+        auto windowMs = 5.0f;
+        auto worst = 0.0;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            //automation moves the window a little every block, and sometimes it jumps
+            if (i % 256 == 0)
+            {
+                windowMs = juce::jlimit(1.0f, 300.0f, i % 16384 == 0 ? random.nextFloat() * 300.0f : windowMs + (random.nextFloat() - 0.5f) * 4.0f);
+                detector.setWindow(windowMs);
+            }
+
+            const auto amplitude = i < numSamples / 2 ? 1.0f : 0.001f;
+            auto square = 0.0;
+            auto level = 0.0f;
+            for (int frame = 0; frame < framesPerSample; ++frame)
+            {
+                const auto key = (random.nextFloat() * 2.0f - 1.0f) * amplitude;
+                square += double(key) * key;
+                level = process(detector, key);
+            }
+            squares.push_back(square);
+
+            const auto window = juce::roundToInt(windowMs * 0.001 * sampleRate);
+            const auto sum = std::accumulate(squares.end() - juce::jmin(window, int(squares.size())), squares.end(), 0.0);
+            const auto expected = std::sqrt(sum / (double(window) * framesPerSample));
+
+            //the first window after the drop still holds the loud part
+            if (i > numSamples / 2 + int(0.3 * sampleRate) || i < numSamples / 2)
+            {
+                worst = juce::jmax(worst, std::abs(level - expected) / expected);
+            }
+        }
+
+        logMessage("worst relative error " + juce::String(worst));
+        expectLessOrEqual(worst, 1.0e-5, "relative error");
+    }
+
+    //A quarter of the sample rate at 45 degrees only ever samples at 0.707, the wave between them reaches 1
+    void testTruePeak()
+    {
+        beginTest("True peak finds the peak between samples");
+
+        Detector peakDetector, truePeakDetector;
+        truePeakDetector.setMode(Detector::Mode::truePeak);
+        peakDetector.prepare(1, sampleRate);
+        truePeakDetector.prepare(1, sampleRate);
+
+        auto peak = 0.0f, truePeak = 0.0f;
+        for (int i = 0; i < 256; ++i)
+        {
+            const auto x = float(std::sin(juce::MathConstants<double>::halfPi * i + juce::MathConstants<double>::pi / 4.0));
+            const auto p = process(peakDetector, x), tp = process(truePeakDetector, x);
+
+            //past the FIR's start-up
+            if (i >= 2 * KcompTruePeak<float>::tapsPerPhase)
+            {
+                peak = juce::jmax(peak, p);
+                truePeak = juce::jmax(truePeak, tp);
+            }
+        }
+
+        expectWithinAbsoluteError(juce::Decibels::gainToDecibels(peak), -3.01f, 0.01f, "sample peak");
+        expectWithinAbsoluteError(juce::Decibels::gainToDecibels(truePeak), 0.0f, 0.2f, "true peak");
+    }
+};
+
+static DetectorTests detectorTests;
@@ -0,0 +1,92 @@
+#include <JuceHeader.h>
+#include "KcompTestHelpers.h"
+
+using namespace KcompTestHelpers;
+
+//==============================================================================
+/*
+    KcompGainFifo as the engine fills it: every frame holds the lowest gain
+    the compressor applied over its samples, and a reader that falls behind
+    loses frames without the writer ever waiting.
+*/
+class GainFifoTests : public juce::UnitTest
+{
+public:
+
+    GainFifoTests() : juce::UnitTest("Gain Fifo", "Kcomp") {}
+
+    void runTest() override
+    {
+        beginTest("Frames hold the lowest of output / (input * make-up) over their samples");
+        {
+            KcompEngine<float>::Parameters params;
+            params.thresholdDb = -20.0f;
+            params.attackMs = 5.0f;
+            params.releaseMs = 50.0f;
+            params.makeUpGain = 2.0f;
+
+            //DC steps, so the ratio is defined at every sample and the gain moves through attack and release
+            const auto input = makeSignal<float>(2, 36000, [](int channel, int i)
+            {
+                const auto level = i < 12000 ? 0.1f : (i < 24000 ? 0.8f : 0.3f);
+                return channel == 0 ? level : level * 0.5f;
+            });
+
+            KcompGainFifo fifo;
+            KcompEngine<float> engine;
+            engine.setGainFifo(&fifo);
+            prepareEngine(engine, params, 2);
+            const auto output = process(engine, input);
+
+            auto start = 0;
+            auto worst = 0.0;
+            auto deepest = 1.0f;
+            auto channelsMatch = true;
+            fifo.read([&](const KcompGainFifo::Frame& frame)
+            {
+                channelsMatch = channelsMatch && frame.numChannels == 2;
+                for (int channel = 0; channel < 2; ++channel)
+                {
+                    auto lowest = 1.0;
+                    for (int i = start; i < start + frame.numSamples; ++i)
+                    {
+                        lowest = juce::jmin(lowest, double(output.getSample(channel, i)) / (double(input.getSample(channel, i)) * params.makeUpGain));
+                    }
+                    worst = juce::jmax(worst, std::abs(double(frame.gains[channel]) - lowest));
+                    deepest = juce::jmin(deepest, frame.gains[channel]);
+                }
+                start += frame.numSamples;
+            });
+
+            expect(channelsMatch, "two channels in every frame");
+            expectEquals(start, input.getNumSamples(), "frames cover every sample");
+            expectLessOrEqual(worst, 1.0e-5, "gain against output / (input * make-up)");
+            expectLessThan(deepest, 0.5f, "the 0.8 step is cut");
+            expectEquals(fifo.getAndClearNumDropped(), 0, "nothing dropped");
+        }
+
+        beginTest("A full fifo drops new frames and counts them");
+        {
+            //an AbstractFifo of 4 holds 3
+            KcompGainFifo fifo(4);
+            for (int i = 0; i < 10; ++i)
+            {
+                const float gain = float(i) / 10.0f;
+                expect(fifo.push(&gain, 1, 32) == (i < 3), "push " + juce::String(i));
+            }
+
+            expectEquals(fifo.getAndClearNumDropped(), 7, "dropped");
+            expectEquals(fifo.getAndClearNumDropped(), 0, "cleared");
+
+            //the oldest frames are kept, not the newest
+            std::vector<float> gains;
+            expectEquals(fifo.read([&gains](const KcompGainFifo::Frame& frame) { gains.push_back(frame.gains[0]); }), 3, "read");
+            expect(gains == std::vector<float>{ 0.0f, 0.1f, 0.2f }, "oldest first");
+
+            const float gain = 0.5f;
+            expect(fifo.push(&gain, 1, 32), "room again once read");
+        }
+    }
+};
+
+static GainFifoTests gainFifoTests;
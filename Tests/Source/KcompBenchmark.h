@@ -0,0 +1,782 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "KcompCompressor.h"
+#include "KcompEngine.h"
+#include "KcompMath.h"
+#include "KcompLevelStats.h"
+
+//==============================================================================
+/*
+    Micro-benchmarks for the DSP cores, run by KcompTests --benchmark. They
+    run on synthetic noise, so the numbers are comparable between machines
+    and builds without a host in the way. Only meaningful in a Release build.
+*/
+namespace KcompBenchmark
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 64;
+    constexpr int numChannels = 2;
+    constexpr int numBlocks = 20000;
+
+    //KcompCompressor has to beat juce::dsp::Compressor by this much, unlinked, or the run fails
+    constexpr double minCompressorSpeedUp = 3.0;
+
+    //Auto timing may cost at most this much per frame against fixed times, on any band count, or the run fails
+    constexpr double maxAutoTimingCost = 2.0;
+
+    //Average wall time of one call to processBlock, in nanoseconds
+    template <typename Function>
+    double measureNanoseconds(Function&& processBlock)
+    {
+        //warm up caches and branch predictors first
+        for (int block = 0; block < numBlocks / 10; ++block)
+        {
+            processBlock();
+        }
+
+        const auto start = juce::Time::getHighResolutionTicks();
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            processBlock();
+        }
+        const auto elapsed = juce::Time::getHighResolutionTicks() - start;
+
+        return juce::Time::highResolutionTicksToSeconds(elapsed) * 1.0e9 / numBlocks;
+    }
+
+    template <typename SampleType>
+    void fillWithNoise(juce::AudioBuffer<SampleType>& buffer)
+    {
+        juce::Random random(42);
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+        {
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+            {
+                buffer.setSample(channel, i, SampleType(random.nextFloat() * 2.0f - 1.0f));
+            }
+        }
+    }
+
+    template <typename CompressorType>
+    void setUpCompressor(CompressorType& comp, const juce::dsp::ProcessSpec& spec)
+    {
+        comp.setThreshold(-24.0f);
+        comp.setRatio(4.0f);
+        comp.setAttack(5.0f);
+        comp.setRelease(80.0f);
+        comp.prepare(spec);
+    }
+
+    //The engine's side of setUpCompressor: 4:1 with a hard knee on every band
+    template <typename SampleType>
+    void setUpCurves(KcompEngine<SampleType>& engine)
+    {
+        typename KcompTransferCurve<SampleType>::Settings curve;
+        curve.ratio = SampleType(4);
+        for (int band = 0; band < KcompEngine<SampleType>::maxBands; ++band)
+        {
+            engine.setTransferCurve(band, curve);
+        }
+    }
+
+    //Stereo, 64-sample blocks at 48 kHz: juce::dsp::Compressor against KcompCompressor. fastEnough is false when
+    //the unlinked speed-up is under minCompressorSpeedUp.
+    inline juce::String runCompressorBenchmark(bool& fastEnough)
+    {
+        juce::dsp::ProcessSpec spec{ sampleRate, juce::uint32(blockSize), juce::uint32(numChannels) };
+
+        juce::AudioBuffer<float> source(numChannels, blockSize), work(numChannels, blockSize);
+        fillWithNoise(source);
+
+        auto timeCompressor = [&](auto& comp)
+        {
+            return measureNanoseconds([&]
+            {
+                for (int channel = 0; channel < numChannels; ++channel)
+                {
+                    work.copyFrom(channel, 0, source, channel, 0, blockSize);
+                }
+
+                juce::dsp::AudioBlock<float> block(work);
+                comp.process(juce::dsp::ProcessContextReplacing<float>(block));
+            });
+        };
+
+        juce::dsp::Compressor<float> reference;
+        setUpCompressor(reference, spec);
+
+        KcompCompressor<float> kcomp;
+        setUpCompressor(kcomp, spec);
+
+        KcompCompressor<float> kcompLinked;
+        kcompLinked.setLinked(true);
+        setUpCompressor(kcompLinked, spec);
+
+        //copying the block in is part of every measurement, so time it on its own and take it out
+        const auto copyTime = measureNanoseconds([&]
+        {
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                work.copyFrom(channel, 0, source, channel, 0, blockSize);
+            }
+        });
+
+        const auto referenceTime = juce::jmax(1.0, timeCompressor(reference) - copyTime);
+        const auto kcompTime = juce::jmax(1.0, timeCompressor(kcomp) - copyTime);
+        const auto linkedTime = juce::jmax(1.0, timeCompressor(kcompLinked) - copyTime);
+
+        juce::String report;
+        report << "Stereo, " << blockSize << " samples @ " << int(sampleRate) << " Hz, " << KcompCompressor<float>::lanes << " SIMD lanes" << juce::NewLine::getDefault()
+               << "juce::dsp::Compressor: " << juce::String(referenceTime, 1) << " ns/block" << juce::NewLine::getDefault()
+               << "KcompCompressor: " << juce::String(kcompTime, 1) << " ns/block (x" << juce::String(referenceTime / kcompTime, 2) << ")" << juce::NewLine::getDefault()
+               << "KcompCompressor linked: " << juce::String(linkedTime, 1) << " ns/block (x" << juce::String(referenceTime / linkedTime, 2) << ")";
+
+        fastEnough = referenceTime / kcompTime >= minCompressorSpeedUp;
+        if (! fastEnough)
+        {
+            report << juce::NewLine::getDefault() << "FAILED: KcompCompressor is under x" << juce::String(minCompressorSpeedUp, 1);
+        }
+        return report;
+    }
+
+    //Whole engine per oversampling factor and filter type, with the cost relative to 1x
+    inline juce::String runOversamplingBenchmark()
+    {
+        juce::dsp::ProcessSpec spec{ sampleRate, juce::uint32(blockSize), juce::uint32(numChannels) };
+
+        juce::AudioBuffer<float> source(numChannels, blockSize), work(numChannels, blockSize);
+        fillWithNoise(source);
+
+        auto copyIn = [&]
+        {
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                work.copyFrom(channel, 0, source, channel, 0, blockSize);
+            }
+        };
+
+        const auto copyTime = measureNanoseconds(copyIn);
+
+        juce::String report;
+        report << "Stereo engine, " << blockSize << " samples @ " << int(sampleRate) << " Hz";
+
+        double baseTime = 1.0;
+        for (int type = 0; type < 2; ++type)
+        {
+            for (int order = type == 0 ? 0 : 1; order <= KcompEngine<float>::maxOversamplingOrder; ++order)
+            {
+                KcompEngine<float>::Parameters params;
+                params.thresholdDb = -24.0f;
+                params.attackMs = 5.0f;
+                params.releaseMs = 80.0f;
+                params.tameEnabled = true;
+                params.oversamplingOrder = order;
+                params.linearPhaseOversampling = type == 1;
+
+                KcompEngine<float> engine;
+                setUpCurves(engine);
+                engine.setParameters(params);
+                engine.prepare(spec);
+
+                const auto time = juce::jmax(1.0, measureNanoseconds([&]
+                {
+                    copyIn();
+                    engine.process(work);
+                }) - copyTime);
+
+                if (order == 0)
+                {
+                    baseTime = time;
+                }
+
+                report << juce::NewLine::getDefault()
+                       << (1 << order) << "x" << (order == 0 ? juce::String() : (type == 0 ? juce::String(" IIR") : juce::String(" FIR"))) << ": "
+                       << juce::String(time, 1) << " ns/block (x" << juce::String(time / baseTime, 2) << "), "
+                       << engine.getLatencySamples() << " samples latency";
+            }
+        }
+
+        return report;
+    }
+
+    //A 64-bit host block through the double engine, against converting it to float and back around the float engine
+    inline juce::String runPrecisionBenchmark()
+    {
+        juce::dsp::ProcessSpec spec{ sampleRate, juce::uint32(blockSize), juce::uint32(numChannels) };
+
+        juce::AudioBuffer<double> source(numChannels, blockSize), work(numChannels, blockSize);
+        juce::AudioBuffer<float> floatWork(numChannels, blockSize);
+        fillWithNoise(source);
+
+        KcompEngine<float>::Parameters floatParams;
+        floatParams.thresholdDb = -24.0f;
+        floatParams.attackMs = 5.0f;
+        floatParams.releaseMs = 80.0f;
+        floatParams.tameEnabled = true;
+
+        KcompEngine<double>::Parameters doubleParams;
+        doubleParams.thresholdDb = -24.0;
+        doubleParams.attackMs = 5.0;
+        doubleParams.releaseMs = 80.0;
+        doubleParams.tameEnabled = true;
+
+        KcompEngine<float> floatEngine;
+        setUpCurves(floatEngine);
+        floatEngine.setParameters(floatParams);
+        floatEngine.prepare(spec);
+
+        KcompEngine<double> doubleEngine;
+        setUpCurves(doubleEngine);
+        doubleEngine.setParameters(doubleParams);
+        doubleEngine.prepare(spec);
+
+        auto copyIn = [&]
+        {
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                work.copyFrom(channel, 0, source, channel, 0, blockSize);
+            }
+        };
+
+        const auto copyTime = measureNanoseconds(copyIn);
+
+        const auto convertedTime = juce::jmax(1.0, measureNanoseconds([&]
+        {
+            copyIn();
+            floatWork.makeCopyOf(work, true);
+            floatEngine.process(floatWork);
+            work.makeCopyOf(floatWork, true);
+        }) - copyTime);
+
+        const auto nativeTime = juce::jmax(1.0, measureNanoseconds([&]
+        {
+            copyIn();
+            doubleEngine.process(work);
+        }) - copyTime);
+
+        juce::String report;
+        report << "Stereo engine on a 64-bit host, " << blockSize << " samples @ " << int(sampleRate) << " Hz" << juce::NewLine::getDefault()
+               << "float engine + conversions: " << juce::String(convertedTime, 1) << " ns/block" << juce::NewLine::getDefault()
+               << "double engine: " << juce::String(nativeTime, 1) << " ns/block (x" << juce::String(convertedTime / nativeTime, 2) << ")";
+        return report;
+    }
+
+    //Engine cost per detector mode, RMS at both ends of the window range to show the sliding sum doesn't care
+    inline juce::String runDetectorBenchmark()
+    {
+        juce::dsp::ProcessSpec spec{ sampleRate, juce::uint32(blockSize), juce::uint32(numChannels) };
+
+        juce::AudioBuffer<float> noise(numChannels, blockSize), work(numChannels, blockSize);
+        fillWithNoise(noise);
+
+        KcompEngine<float>::Parameters params;
+        params.thresholdDb = -24.0f;
+        params.attackMs = 5.0f;
+        params.releaseMs = 80.0f;
+
+        auto measure = [&](int mode, float windowMs)
+        {
+            KcompEngine<float> engine;
+            params.detectorMode = mode;
+            params.rmsWindowMs = windowMs;
+            setUpCurves(engine);
+            engine.setParameters(params);
+            engine.prepare(spec);
+
+            auto copyIn = [&]
+            {
+                for (int channel = 0; channel < numChannels; ++channel)
+                {
+                    work.copyFrom(channel, 0, noise, channel, 0, blockSize);
+                }
+            };
+
+            const auto copyTime = measureNanoseconds(copyIn);
+            return juce::jmax(1.0, measureNanoseconds([&]
+            {
+                copyIn();
+                engine.process(work);
+            }) - copyTime);
+        };
+
+        const auto peakTime = measure(0, 10.0f);
+        const auto shortRMSTime = measure(1, 1.0f);
+        const auto longRMSTime = measure(1, 300.0f);
+        const auto truePeakTime = measure(2, 10.0f);
+
+        juce::String report;
+        report << "Stereo engine, " << blockSize << " samples @ " << int(sampleRate) << " Hz" << juce::NewLine::getDefault()
+               << "peak: " << juce::String(peakTime, 1) << " ns/block" << juce::NewLine::getDefault()
+               << "RMS 1 ms: " << juce::String(shortRMSTime, 1) << " ns/block (x" << juce::String(shortRMSTime / peakTime, 2) << ")" << juce::NewLine::getDefault()
+               << "RMS 300 ms: " << juce::String(longRMSTime, 1) << " ns/block (x" << juce::String(longRMSTime / peakTime, 2) << ")" << juce::NewLine::getDefault()
+               << "true peak: " << juce::String(truePeakTime, 1) << " ns/block (x" << juce::String(truePeakTime / peakTime, 2) << ")";
+        return report;
+    }
+
+    //Fixed against auto timing, single band and four bands. withinBudget is false when auto timing is over
+    //maxAutoTimingCost on either.
+    inline juce::String runAutoTimingBenchmark(bool& withinBudget)
+    {
+        juce::dsp::ProcessSpec spec{ sampleRate, juce::uint32(blockSize), juce::uint32(numChannels) };
+
+        juce::AudioBuffer<float> noise(numChannels, blockSize), work(numChannels, blockSize);
+        fillWithNoise(noise);
+
+        KcompEngine<float>::Parameters params;
+        params.thresholdDb = -24.0f;
+        params.attackMs = 5.0f;
+        params.releaseMs = 80.0f;
+        for (auto& band : params.bands)
+        {
+            band = { -24.0f, 5.0f, 80.0f };
+        }
+
+        auto measure = [&](bool autoTiming, int numBands)
+        {
+            KcompEngine<float> engine;
+            params.autoTiming = autoTiming;
+            params.numBands = numBands;
+            setUpCurves(engine);
+            engine.setParameters(params);
+            engine.prepare(spec);
+
+            auto copyIn = [&]
+            {
+                for (int channel = 0; channel < numChannels; ++channel)
+                {
+                    work.copyFrom(channel, 0, noise, channel, 0, blockSize);
+                }
+            };
+
+            const auto copyTime = measureNanoseconds(copyIn);
+            return juce::jmax(1.0, measureNanoseconds([&]
+            {
+                copyIn();
+                engine.process(work);
+            }) - copyTime);
+        };
+
+        const auto frames = double(blockSize);
+        juce::String report;
+        report << "Stereo engine, " << blockSize << " samples @ " << int(sampleRate) << " Hz";
+
+        withinBudget = true;
+
+        for (auto numBands : { 1, 4 })
+        {
+            const auto fixedTime = measure(false, numBands);
+            const auto autoTime = measure(true, numBands);
+
+            report << juce::NewLine::getDefault() << numBands << (numBands == 1 ? " band" : " bands")
+                   << " fixed: " << juce::String(fixedTime, 1) << " ns/block (" << juce::String(fixedTime / frames, 2) << " ns/frame)"
+                   << ", auto: " << juce::String(autoTime, 1) << " ns/block (" << juce::String(autoTime / frames, 2) << " ns/frame, x"
+                   << juce::String(autoTime / fixedTime, 2) << ")";
+
+            if (autoTime / fixedTime > maxAutoTimingCost)
+            {
+                withinBudget = false;
+                report << juce::NewLine::getDefault() << "FAILED: auto timing is over x" << juce::String(maxAutoTimingCost, 1) << " with " << numBands
+                       << (numBands == 1 ? " band" : " bands");
+            }
+        }
+        return report;
+    }
+
+    //The same engine on noise, on digital silence (asleep) and bypassed
+    inline juce::String runIdleBenchmark()
+    {
+        juce::dsp::ProcessSpec spec{ sampleRate, juce::uint32(blockSize), juce::uint32(numChannels) };
+
+        juce::AudioBuffer<float> noise(numChannels, blockSize), silence(numChannels, blockSize), work(numChannels, blockSize);
+        fillWithNoise(noise);
+        silence.clear();
+
+        KcompEngine<float>::Parameters params;
+        params.thresholdDb = -24.0f;
+        params.attackMs = 5.0f;
+        params.releaseMs = 80.0f;
+        params.lookaheadMs = 2.0f;
+        params.tameEnabled = true;
+
+        auto measure = [&](const juce::AudioBuffer<float>& source, bool bypassed)
+        {
+            KcompEngine<float> engine;
+            params.bypassed = bypassed;
+            setUpCurves(engine);
+            engine.setParameters(params);
+            engine.prepare(spec);
+
+            auto copyIn = [&]
+            {
+                for (int channel = 0; channel < numChannels; ++channel)
+                {
+                    work.copyFrom(channel, 0, source, channel, 0, blockSize);
+                }
+            };
+
+            const auto copyTime = measureNanoseconds(copyIn);
+            return juce::jmax(1.0, measureNanoseconds([&]
+            {
+                copyIn();
+                engine.process(work);
+            }) - copyTime);
+        };
+
+        const auto noiseTime = measure(noise, false);
+        const auto silenceTime = measure(silence, false);
+        const auto bypassedTime = measure(noise, true);
+
+        juce::String report;
+        report << "Stereo engine with 2 ms lookahead, " << blockSize << " samples @ " << int(sampleRate) << " Hz" << juce::NewLine::getDefault()
+               << "noise: " << juce::String(noiseTime, 1) << " ns/block" << juce::NewLine::getDefault()
+               << "silence: " << juce::String(silenceTime, 1) << " ns/block (x" << juce::String(noiseTime / silenceTime, 2) << ")" << juce::NewLine::getDefault()
+               << "bypassed: " << juce::String(bypassedTime, 1) << " ns/block (x" << juce::String(noiseTime / bypassedTime, 2) << ")";
+        return report;
+    }
+
+    //Cost per value of KcompMath::gainToDecibels against juce::Decibels. The accuracy is checked in KcompMathTests.
+    inline juce::String runMathBenchmark()
+    {
+        using Vec = KcompSIMD::Register<float>;
+        constexpr int lanes = int(Vec::SIMDNumElements);
+
+        using Coarse = std::integral_constant<KcompMath::Accuracy, KcompMath::Accuracy::coarse>;
+        using Fine = std::integral_constant<KcompMath::Accuracy, KcompMath::Accuracy::fine>;
+
+        //one block of meter-like levels, converted value by value and a register at a time
+        constexpr int numValues = numChannels * blockSize;
+        float levels[numValues], results[numValues];
+        juce::Random random(42);
+        for (auto& level : levels)
+        {
+            level = random.nextFloat();
+        }
+
+        float sink = 0.0f;
+        auto perValue = [&](auto&& convertBlock)
+        {
+            const auto time = measureNanoseconds([&]
+            {
+                convertBlock();
+                sink += results[0];
+            });
+            return time / numValues;
+        };
+
+        const auto libmTime = perValue([&]
+        {
+            for (int i = 0; i < numValues; ++i)
+            {
+                results[i] = juce::Decibels::gainToDecibels(levels[i]);
+            }
+        });
+
+        const auto scalarTime = perValue([&]
+        {
+            for (int i = 0; i < numValues; ++i)
+            {
+                results[i] = KcompMath::gainToDecibels<KcompMath::Accuracy::fine>(levels[i]);
+            }
+        });
+
+        auto simdTime = [&](auto accuracy)
+        {
+            return perValue([&]
+            {
+                for (int i = 0; i < numValues; i += lanes)
+                {
+                    KcompSIMD::store(results + i, KcompMath::gainToDecibels<decltype(accuracy)::value>(KcompSIMD::load(levels + i)));
+                }
+            });
+        };
+
+        const auto coarseTime = simdTime(Coarse());
+        const auto fineTime = simdTime(Fine());
+        juce::ignoreUnused(sink);
+
+        juce::String report;
+        report << "gainToDecibels per value, juce::Decibels: " << juce::String(libmTime, 2) << " ns" << juce::NewLine::getDefault()
+               << "fine, one at a time: " << juce::String(scalarTime, 2) << " ns (x" << juce::String(libmTime / scalarTime, 1) << ")" << juce::NewLine::getDefault()
+               << "fine, " << lanes << " lanes: " << juce::String(fineTime, 2) << " ns (x" << juce::String(libmTime / fineTime, 1) << ")" << juce::NewLine::getDefault()
+               << "coarse, " << lanes << " lanes: " << juce::String(coarseTime, 2) << " ns (x" << juce::String(libmTime / coarseTime, 1) << ")";
+        return report;
+    }
+
+    //Hard-knee 4:1 against a soft-knee two-stage curve, and against a new curve crossfading in on every block
+    inline juce::String runTransferCurveBenchmark()
+    {
+        juce::dsp::ProcessSpec spec{ sampleRate, juce::uint32(blockSize), juce::uint32(numChannels) };
+
+        juce::AudioBuffer<float> noise(numChannels, blockSize), work(numChannels, blockSize);
+        fillWithNoise(noise);
+
+        KcompEngine<float>::Parameters params;
+        params.thresholdDb = -24.0f;
+        params.attackMs = 5.0f;
+        params.releaseMs = 80.0f;
+
+        KcompTransferCurve<float>::Settings hard, soft;
+        hard.ratio = 4.0f;
+        soft.ratio = 2.0f;
+        soft.kneeDb = 12.0f;
+        soft.upperStage = true;
+        soft.upperThresholdDb = 6.0f;
+        soft.upperRatio = 20.0f;
+
+        auto measure = [&](const KcompTransferCurve<float>::Settings& curve, bool republish)
+        {
+            KcompEngine<float> engine;
+            engine.setTransferCurve(0, curve);
+            engine.setParameters(params);
+            engine.prepare(spec);
+
+            auto copyIn = [&]
+            {
+                for (int channel = 0; channel < numChannels; ++channel)
+                {
+                    work.copyFrom(channel, 0, noise, channel, 0, blockSize);
+                }
+            };
+
+            //publishing builds the table, which happens off the audio thread in the plugin, so it's timed on its own
+            auto publishTime = 0.0;
+            if (republish)
+            {
+                publishTime = measureNanoseconds([&] { engine.setTransferCurve(0, curve); });
+            }
+
+            const auto copyTime = measureNanoseconds(copyIn);
+            return juce::jmax(1.0, measureNanoseconds([&]
+            {
+                copyIn();
+                if (republish)
+                {
+                    engine.setTransferCurve(0, curve);
+                }
+                engine.process(work);
+            }) - copyTime - publishTime);
+        };
+
+        const auto hardTime = measure(hard, false);
+        const auto softTime = measure(soft, false);
+        const auto fadingTime = measure(soft, true);
+
+        juce::String report;
+        report << "Stereo engine, " << blockSize << " samples @ " << int(sampleRate) << " Hz, "
+               << KcompTransferCurve<float>::tableSize << " point table" << juce::NewLine::getDefault()
+               << "4:1 hard knee: " << juce::String(hardTime, 1) << " ns/block" << juce::NewLine::getDefault()
+               << "two stages, 12 dB knee: " << juce::String(softTime, 1) << " ns/block (x" << juce::String(softTime / hardTime, 2) << ")" << juce::NewLine::getDefault()
+               << "crossfading: " << juce::String(fadingTime, 1) << " ns/block (x" << juce::String(fadingTime / hardTime, 2) << ")";
+        return report;
+    }
+
+    //Feed-forward, feedback and hybrid, single band and four bands. Each topology has its own inner loops,
+    //so feed-forward should cost what it did before the switch existed.
+    inline juce::String runTopologyBenchmark()
+    {
+        juce::dsp::ProcessSpec spec{ sampleRate, juce::uint32(blockSize), juce::uint32(numChannels) };
+
+        juce::AudioBuffer<float> noise(numChannels, blockSize), work(numChannels, blockSize);
+        fillWithNoise(noise);
+
+        KcompEngine<float>::Parameters params;
+        params.thresholdDb = -24.0f;
+        params.attackMs = 5.0f;
+        params.releaseMs = 80.0f;
+        for (auto& band : params.bands)
+        {
+            band = { -24.0f, 5.0f, 80.0f };
+        }
+
+        auto measure = [&](KcompEngine<float>::Topology topology, int numBands)
+        {
+            KcompEngine<float> engine;
+            params.topology = int(topology);
+            params.numBands = numBands;
+            setUpCurves(engine);
+            engine.setParameters(params);
+            engine.prepare(spec);
+
+            auto copyIn = [&]
+            {
+                for (int channel = 0; channel < numChannels; ++channel)
+                {
+                    work.copyFrom(channel, 0, noise, channel, 0, blockSize);
+                }
+            };
+
+            const auto copyTime = measureNanoseconds(copyIn);
+            return juce::jmax(1.0, measureNanoseconds([&]
+            {
+                copyIn();
+                engine.process(work);
+            }) - copyTime);
+        };
+
+        juce::String report;
+        report << "Stereo engine, " << blockSize << " samples @ " << int(sampleRate) << " Hz";
+
+        for (auto numBands : { 1, 4 })
+        {
+            const auto feedForwardTime = measure(KcompEngine<float>::Topology::feedForward, numBands);
+            const auto feedbackTime = measure(KcompEngine<float>::Topology::feedback, numBands);
+            const auto hybridTime = measure(KcompEngine<float>::Topology::hybrid, numBands);
+
+            report << juce::NewLine::getDefault() << numBands << (numBands == 1 ? " band" : " bands") << juce::NewLine::getDefault()
+                   << "feed-forward: " << juce::String(feedForwardTime, 1) << " ns/block" << juce::NewLine::getDefault()
+                   << "feedback: " << juce::String(feedbackTime, 1) << " ns/block (x" << juce::String(feedbackTime / feedForwardTime, 2) << ")" << juce::NewLine::getDefault()
+                   << "hybrid: " << juce::String(hybridTime, 1) << " ns/block (x" << juce::String(hybridTime / feedForwardTime, 2) << ")";
+        }
+        return report;
+    }
+
+    //L/R against M/S, unlinked, linked and half linked. M/S is matrixed inside the engine's loop, the last line
+    //is what an M/S wrapper around the L/R engine costs with its two extra passes over the buffer.
+    inline juce::String runStereoModeBenchmark()
+    {
+        juce::dsp::ProcessSpec spec{ sampleRate, juce::uint32(blockSize), juce::uint32(numChannels) };
+
+        juce::AudioBuffer<float> noise(numChannels, blockSize), work(numChannels, blockSize);
+        fillWithNoise(noise);
+
+        KcompEngine<float>::Parameters params;
+        params.thresholdDb = -24.0f;
+        params.attackMs = 5.0f;
+        params.releaseMs = 80.0f;
+
+        auto copyIn = [&]
+        {
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                work.copyFrom(channel, 0, noise, channel, 0, blockSize);
+            }
+        };
+
+        //(L + R, L - R) scaled, the same matrix both ways
+        auto matrix = [&](float scale)
+        {
+            auto* left = work.getWritePointer(0);
+            auto* right = work.getWritePointer(1);
+            for (int i = 0; i < blockSize; ++i)
+            {
+                const auto sum = (left[i] + right[i]) * scale;
+                right[i] = (left[i] - right[i]) * scale;
+                left[i] = sum;
+            }
+        };
+
+        auto measure = [&](KcompEngine<float>::StereoMode mode, bool linked, float linkAmount, bool wrapped)
+        {
+            KcompEngine<float> engine;
+            params.stereoMode = int(mode);
+            params.linked = linked;
+            params.linkAmount = linkAmount;
+            setUpCurves(engine);
+            engine.setParameters(params);
+            engine.prepare(spec);
+
+            const auto copyTime = measureNanoseconds(copyIn);
+            return juce::jmax(1.0, measureNanoseconds([&]
+            {
+                copyIn();
+                if (wrapped)
+                {
+                    matrix(0.5f);
+                }
+                engine.process(work);
+                if (wrapped)
+                {
+                    matrix(1.0f);
+                }
+            }) - copyTime);
+        };
+
+        using Mode = KcompEngine<float>::StereoMode;
+        const auto baseTime = measure(Mode::leftRight, false, 1.0f, false);
+
+        juce::String report;
+        report << "Stereo engine, " << blockSize << " samples @ " << int(sampleRate) << " Hz" << juce::NewLine::getDefault()
+               << "L/R: " << juce::String(baseTime, 1) << " ns/block";
+
+        auto addLine = [&](const juce::String& name, double time)
+        {
+            report << juce::NewLine::getDefault() << name << ": " << juce::String(time, 1) << " ns/block (x" << juce::String(time / baseTime, 2) << ")";
+        };
+
+        addLine("L/R linked", measure(Mode::leftRight, true, 1.0f, false));
+        addLine("L/R 50% linked", measure(Mode::leftRight, true, 0.5f, false));
+        addLine("M/S", measure(Mode::midSide, false, 1.0f, false));
+        addLine("M/S 50% linked", measure(Mode::midSide, true, 0.5f, false));
+        addLine("L/R in an M/S wrapper", measure(Mode::leftRight, false, 1.0f, true));
+        return report;
+    }
+
+    //Peak, RMS and DC offset of every channel: juce's getMagnitude() and getRMSLevel() plus a pass for the mean,
+    //against KcompLevelStats::measure() doing all of it in one pass. Stereo and 7.1.4, short and long blocks.
+    inline juce::String runLevelStatsBenchmark()
+    {
+        juce::String report;
+        report << "Level statistics, peak + RMS + DC";
+
+        float sink = 0.0f;
+        for (const auto channels : { 2, 12 })
+        {
+            for (const auto samples : { blockSize, 1024 })
+            {
+                juce::AudioBuffer<float> noise(channels, samples);
+                fillWithNoise(noise);
+
+                const auto separateTime = measureNanoseconds([&]
+                {
+                    for (int channel = 0; channel < channels; ++channel)
+                    {
+                        const auto* data = noise.getReadPointer(channel);
+                        sink += noise.getMagnitude(channel, 0, samples) + noise.getRMSLevel(channel, 0, samples)
+                              + float(std::accumulate(data, data + samples, 0.0) / samples);
+                    }
+                });
+
+                const auto fusedTime = measureNanoseconds([&]
+                {
+                    for (int channel = 0; channel < channels; ++channel)
+                    {
+                        const auto levels = KcompLevelStats<float>::measure(noise.getReadPointer(channel), samples);
+                        sink += levels.peak + levels.rms + levels.dcOffset;
+                    }
+                });
+
+                report << juce::NewLine::getDefault() << channels << " channels, " << samples << " samples: "
+                       << juce::String(separateTime, 1) << " ns separate, " << juce::String(fusedTime, 1) << " ns one pass (x"
+                       << juce::String(separateTime / juce::jmax(1.0, fusedTime), 2) << ")";
+            }
+        }
+
+        //keeps the measurements from being optimised away
+        if (sink == 0.0f)
+        {
+            report << " ";
+        }
+        return report;
+    }
+
+    //==============================================================================
+    //Runs every benchmark and hands each report to print(title, report). False if one of them failed.
+    template <typename PrintFunction>
+    bool runAll(PrintFunction&& print)
+    {
+        auto compressorFastEnough = false, autoTimingWithinBudget = false;
+        print("Compressor Benchmark", runCompressorBenchmark(compressorFastEnough));
+        print("Oversampling Benchmark", runOversamplingBenchmark());
+        print("Precision Benchmark", runPrecisionBenchmark());
+        print("Idle Benchmark", runIdleBenchmark());
+        print("Detector Benchmark", runDetectorBenchmark());
+        print("Auto Timing Benchmark", runAutoTimingBenchmark(autoTimingWithinBudget));
+        print("Math Benchmark", runMathBenchmark());
+        print("Transfer Curve Benchmark", runTransferCurveBenchmark());
+        print("Topology Benchmark", runTopologyBenchmark());
+        print("Stereo Mode Benchmark", runStereoModeBenchmark());
+        print("Level Stats Benchmark", runLevelStatsBenchmark());
+        return compressorFastEnough && autoTimingWithinBudget;
+    }
+}
@@ -0,0 +1,146 @@
+#include <JuceHeader.h>
+#include "KcompMath.h"
+
+//==============================================================================
+/*
+    Every float in the audio range through both KcompMath conversions, at
+    both accuracies, one value at a time and a register at a time, against
+    libm in double precision.
+
+    gainToDecibels gets every gain from -120 dB to +24 dB, decibelsToGain
+    every decibel value from -120 to +24. The error is in dB either way.
+*/
+class KcompMathTests : public juce::UnitTest
+{
+public:
+
+    KcompMathTests() : juce::UnitTest("KcompMath", "Kcomp") {}
+
+    static constexpr float minDb = -120.0f;
+    static constexpr float maxDb = 24.0f;
+
+    //The bounds KcompMath::Accuracy promises
+    static constexpr double coarseToleranceDb = 0.005;
+    static constexpr double fineToleranceDb = 0.0001;
+
+    void runTest() override
+    {
+        beginTest("gainToDecibels, coarse");
+        checkGainToDecibels<KcompMath::Accuracy::coarse>(coarseToleranceDb);
+
+        beginTest("gainToDecibels, fine");
+        checkGainToDecibels<KcompMath::Accuracy::fine>(fineToleranceDb);
+
+        beginTest("decibelsToGain, coarse");
+        checkDecibelsToGain<KcompMath::Accuracy::coarse>(coarseToleranceDb);
+
+        beginTest("decibelsToGain, fine");
+        checkDecibelsToGain<KcompMath::Accuracy::fine>(fineToleranceDb);
+
+        beginTest("Unity and the floor");
+        expectEquals(KcompMath::gainToDecibels<KcompMath::Accuracy::coarse>(1.0f), 0.0f);
+        expectEquals(KcompMath::gainToDecibels<KcompMath::Accuracy::fine>(1.0f), 0.0f);
+        expectEquals(KcompMath::decibelsToGain<KcompMath::Accuracy::coarse>(0.0f), 1.0f);
+        expectEquals(KcompMath::decibelsToGain<KcompMath::Accuracy::fine>(0.0f), 1.0f);
+        expectEquals(KcompMath::gainToDecibels<KcompMath::Accuracy::fine>(0.0f, minDb), minDb);
+        expectEquals(KcompMath::decibelsToGain<KcompMath::Accuracy::fine>(minDb, minDb), 0.0f);
+    }
+
+private:
+
+    using Vec = KcompSIMD::Register<float>;
+    static constexpr int lanes = int(Vec::SIMDNumElements);
+
+    static juce::uint32 toBits(float x) noexcept
+    {
+        juce::uint32 bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+        return bits;
+    }
+
+    static float fromBits(juce::uint32 bits) noexcept
+    {
+        float x;
+        std::memcpy(&x, &bits, sizeof(x));
+        return x;
+    }
+
+    //Calls check(values) with a register's worth of consecutive floats at a time, every float from first to last
+    //(both positive) times sign. The last run is padded with last.
+    template <typename Function>
+    static void forEachFloat(float first, float last, float sign, Function&& check)
+    {
+        const auto lastBits = toBits(last);
+        float values[lanes];
+
+        for (auto bits = toBits(first); bits <= lastBits; bits += juce::uint32(lanes))
+        {
+            for (int lane = 0; lane < lanes; ++lane)
+            {
+                values[lane] = sign * fromBits(juce::jmin(bits + juce::uint32(lane), lastBits));
+            }
+
+            check(values);
+        }
+    }
+
+    void report(const juce::String& name, double worstScalar, double worstSIMD, double tolerance)
+    {
+        logMessage(name + ": worst " + juce::String(worstScalar, 6) + " dB one at a time, " + juce::String(worstSIMD, 6) + " dB in registers");
+        expectLessOrEqual(worstScalar, tolerance, name + ", scalar");
+        expectLessOrEqual(worstSIMD, tolerance, name + ", SIMD");
+    }
+
+    template <KcompMath::Accuracy accuracy>
+    void checkGainToDecibels(double tolerance)
+    {
+        const auto floor = minDb - 1.0f;
+        double worstScalar = 0.0, worstSIMD = 0.0;
+
+        forEachFloat(juce::Decibels::decibelsToGain(minDb, floor), juce::Decibels::decibelsToGain(maxDb), 1.0f, [&](const float* gains)
+        {
+            float decibels[lanes];
+            KcompSIMD::store(decibels, KcompMath::gainToDecibels<accuracy>(KcompSIMD::load(gains), floor));
+
+            for (int lane = 0; lane < lanes; ++lane)
+            {
+                const auto expected = 20.0 * std::log10(double(gains[lane]));
+                worstSIMD = juce::jmax(worstSIMD, std::abs(double(decibels[lane]) - expected));
+                worstScalar = juce::jmax(worstScalar, std::abs(double(KcompMath::gainToDecibels<accuracy>(gains[lane], floor)) - expected));
+            }
+        });
+
+        report("gainToDecibels", worstScalar, worstSIMD, tolerance);
+    }
+
+    template <KcompMath::Accuracy accuracy>
+    void checkDecibelsToGain(double tolerance)
+    {
+        const auto floor = minDb - 1.0f;
+        double worstScalar = 0.0, worstSIMD = 0.0;
+
+        auto check = [&](const float* decibels)
+        {
+            float gains[lanes];
+            KcompSIMD::store(gains, KcompMath::decibelsToGain<accuracy>(KcompSIMD::load(decibels), floor));
+
+            for (int lane = 0; lane < lanes; ++lane)
+            {
+                auto error = [&](float gain) { return std::abs(20.0 * std::log10(double(gain)) - double(decibels[lane])); };
+
+                //the log is the slow part, both paths usually agree to the bit
+                const auto scalarGain = KcompMath::decibelsToGain<accuracy>(decibels[lane], floor);
+                const auto simdError = error(gains[lane]);
+                worstSIMD = juce::jmax(worstSIMD, simdError);
+                worstScalar = juce::jmax(worstScalar, scalarGain == gains[lane] ? simdError : error(scalarGain));
+            }
+        };
+
+        forEachFloat(0.0f, -minDb, -1.0f, check);
+        forEachFloat(0.0f, maxDb, 1.0f, check);
+
+        report("decibelsToGain", worstScalar, worstSIMD, tolerance);
+    }
+};
+
+static KcompMathTests kcompMathTests;
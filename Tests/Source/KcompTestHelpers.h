@@ -0,0 +1,120 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "KcompEngine.h"
+
+//==============================================================================
+/*
+    Signals, engine set-up and measurements shared by the engine tests.
+*/
+namespace KcompTestHelpers
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 256;
+
+    inline juce::dsp::ProcessSpec getSpec(int numChannels)
+    {
+        return { sampleRate, juce::uint32(blockSize), juce::uint32(numChannels) };
+    }
+
+    //Hard knee at ratio:1 on every band, then prepare() with params, so nothing ramps or glides
+    template <typename SampleType>
+    void prepareEngine(KcompEngine<SampleType>& engine, const typename KcompEngine<SampleType>::Parameters& params, int numChannels,
+                       SampleType ratio = 4)
+    {
+        typename KcompTransferCurve<SampleType>::Settings curve;
+        curve.ratio = ratio;
+        for (int band = 0; band < KcompEngine<SampleType>::maxBands; ++band)
+        {
+            engine.setTransferCurve(band, curve);
+        }
+
+        engine.setParameters(params);
+        engine.prepare(getSpec(numChannels));
+    }
+
+    template <typename SampleType>
+    SampleType sine(double frequency, SampleType amplitude, int sample)
+    {
+        return amplitude * static_cast<SampleType>(std::sin(juce::MathConstants<double>::twoPi * frequency * sample / sampleRate));
+    }
+
+    //numSamples of signal(channel, sample), numChannels wide
+    template <typename SampleType, typename SignalFunction>
+    juce::AudioBuffer<SampleType> makeSignal(int numChannels, int numSamples, SignalFunction&& signal)
+    {
+        juce::AudioBuffer<SampleType> buffer(numChannels, numSamples);
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            for (int i = 0; i < numSamples; ++i)
+            {
+                buffer.setSample(channel, i, signal(channel, i));
+            }
+        }
+        return buffer;
+    }
+
+    //Runs input through the engine blockSize samples at a time, before(block) is called ahead of each block
+    template <typename SampleType, typename BlockFunction>
+    juce::AudioBuffer<SampleType> process(KcompEngine<SampleType>& engine, const juce::AudioBuffer<SampleType>& input, BlockFunction&& before)
+    {
+        juce::AudioBuffer<SampleType> output(input.getNumChannels(), input.getNumSamples());
+        juce::AudioBuffer<SampleType> block(input.getNumChannels(), blockSize);
+
+        for (int start = 0, index = 0; start < input.getNumSamples(); start += blockSize, ++index)
+        {
+            const auto num = juce::jmin(blockSize, input.getNumSamples() - start);
+            block.setSize(input.getNumChannels(), num, false, false, true);
+            for (int channel = 0; channel < input.getNumChannels(); ++channel)
+            {
+                block.copyFrom(channel, 0, input, channel, start, num);
+            }
+
+            before(index);
+            engine.process(block);
+
+            for (int channel = 0; channel < input.getNumChannels(); ++channel)
+            {
+                output.copyFrom(channel, start, block, channel, 0, num);
+            }
+        }
+        return output;
+    }
+
+    template <typename SampleType>
+    juce::AudioBuffer<SampleType> process(KcompEngine<SampleType>& engine, const juce::AudioBuffer<SampleType>& input)
+    {
+        return process(engine, input, [](int) {});
+    }
+
+    //A fresh engine prepared with params, run over the whole input
+    template <typename SampleType>
+    juce::AudioBuffer<SampleType> run(const juce::AudioBuffer<SampleType>& input, const typename KcompEngine<SampleType>::Parameters& params)
+    {
+        KcompEngine<SampleType> engine;
+        prepareEngine(engine, params, input.getNumChannels());
+        return process(engine, input);
+    }
+
+    //RMS of one channel over [start, start + num), in dB
+    template <typename SampleType>
+    double getRMSDb(const juce::AudioBuffer<SampleType>& buffer, int channel, int start, int num)
+    {
+        return juce::Decibels::gainToDecibels(double(buffer.getRMSLevel(channel, start, num)), -200.0);
+    }
+
+    //Largest difference between a and b from start on, b read delay samples earlier than a
+    template <typename SampleTypeA, typename SampleTypeB>
+    double getMaxDifference(const juce::AudioBuffer<SampleTypeA>& a, const juce::AudioBuffer<SampleTypeB>& b, int start = 0, int delay = 0)
+    {
+        double difference = 0.0;
+        for (int channel = 0; channel < juce::jmin(a.getNumChannels(), b.getNumChannels()); ++channel)
+        {
+            for (int i = juce::jmax(start, delay); i < juce::jmin(a.getNumSamples(), b.getNumSamples() + delay); ++i)
+            {
+                difference = juce::jmax(difference, std::abs(double(a.getSample(channel, i)) - double(b.getSample(channel, i - delay))));
+            }
+        }
+        return difference;
+    }
+}
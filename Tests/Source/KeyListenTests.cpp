@@ -0,0 +1,56 @@
+#include <JuceHeader.h>
+#include "KcompTestHelpers.h"
+
+using namespace KcompTestHelpers;
+
+//==============================================================================
+/*
+    With the key filters off the key is the signal, so listening to it has
+    to come out exactly like the idle compressor: same delay, same
+    oversampling filters, same reported latency.
+*/
+class KeyListenTests : public juce::UnitTest
+{
+public:
+
+    KeyListenTests() : juce::UnitTest("Key listen", "Kcomp") {}
+
+    void runTest() override
+    {
+        beginTest("Listening stays in time with the reported latency");
+
+        auto random = getRandom();
+        const auto input = makeSignal<float>(2, 24000, [&random](int, int) { return (random.nextFloat() * 2.0f - 1.0f) * 0.01f; });
+
+        for (auto lookaheadMs : { 0.0f, 2.0f, 10.0f })
+        {
+            for (int order = 0; order <= 2; ++order)
+            {
+                KcompEngine<float>::Parameters params;
+                params.lookaheadMs = lookaheadMs;
+                params.oversamplingOrder = order;
+                const auto idle = run(input, params);
+
+                params.keyListen = true;
+                const auto name = juce::String(lookaheadMs) + " ms lookahead, " + juce::String(1 << order) + "x";
+                expectLessOrEqual(getMaxDifference(run(input, params), idle), 1.0e-6, name);
+            }
+        }
+
+        beginTest("Same across a link wider than a register");
+        {
+            //16 linked channels take the path that measures every channel first
+            const auto wide = makeSignal<float>(16, 12000, [&random](int, int) { return (random.nextFloat() * 2.0f - 1.0f) * 0.01f; });
+
+            KcompEngine<float>::Parameters params;
+            params.lookaheadMs = 5.0f;
+            params.linked = true;
+            const auto idle = run(wide, params);
+
+            params.keyListen = true;
+            expectLessOrEqual(getMaxDifference(run(wide, params), idle), 1.0e-6, "16 channels");
+        }
+    }
+};
+
+static KeyListenTests keyListenTests;
@@ -0,0 +1,224 @@
+#include <JuceHeader.h>
+#include "KcompTestHelpers.h"
+#include "LevelMeter.h"
+
+using namespace KcompTestHelpers;
+
+//==============================================================================
+/*
+    LevelMeterGetter fed by the engine the way the processor does it, read
+    back the way the editor does it, and the KcompTripleBuffer between them.
+*/
+class LevelMeterTests : public juce::UnitTest
+{
+public:
+
+    LevelMeterTests() : juce::UnitTest("Level Meter", "Kcomp") {}
+
+    void runTest() override
+    {
+        using Getter = LevelMeter::LevelMeterGetter;
+
+        beginTest("PPM Type II falls 24 dB in 2.8 s");
+        {
+            //a second of tone, then silence
+            const auto toneSamples = 48000;
+            const auto input = makeSignal<float>(2, toneSamples + 3 * 48000, [](int, int i) { return i < toneSamples ? sine(1000.0, 0.5f, i) : 0.0f; });
+
+            Getter getter;
+            const auto peaksDb = measure(getter, input, 2, blockSize, [&getter] { return getter.getMaxLevel(0); });
+
+            const auto fallSamples = juce::roundToInt(2.8 * sampleRate);
+            const auto startDb = peaksDb[size_t(toneSamples / blockSize)];
+            expectWithinAbsoluteError(startDb, -6.02, 0.05, "peak of the tone");
+            expectWithinAbsoluteError(peaksDb[size_t((toneSamples + fallSamples) / blockSize)] - startDb, -24.0, 0.5, "2.8 s later");
+        }
+
+        beginTest("32 and 4096 sample buffers read the same RMS");
+        {
+            //noise, a tone with a whole period in every RMS bin, then silence for the windows to empty out
+            auto random = getRandom();
+            const auto input = makeSignal<float>(2, 4 * 48000, [&random](int channel, int i)
+            {
+                if (i < 48000)
+                {
+                    return (random.nextFloat() * 2.0f - 1.0f) * (channel == 0 ? 0.5f : 0.1f);
+                }
+                return i < 3 * 48000 ? sine(1500.0, 0.25f, i) : 0.0f;
+            });
+
+            for (int ballistics = 0; ballistics < Getter::numBallistics; ++ballistics)
+            {
+                Getter small, large;
+                const auto smallDb = measure(small, input, ballistics, 32, [&small] { return small.getRMSLevel(0); });
+                const auto largeDb = measure(large, input, ballistics, 4096, [&large] { return large.getRMSLevel(0); });
+
+                //every 4096 samples, where both have just taken a block
+                auto worst = 0.0;
+                for (int end = 4096; end <= input.getNumSamples(); end += 4096)
+                {
+                    const auto a = smallDb[size_t(end / 32 - 1)];
+                    const auto b = largeDb[size_t(end / 4096 - 1)];
+                    worst = juce::jmax(worst, std::abs(a - b));
+                }
+                expectLessOrEqual(worst, 0.01, Getter::getBallistics(ballistics).name);
+
+                //a steady sine reads its RMS once the window is full of it
+                expectWithinAbsoluteError(largeDb[size_t(3 * 48000 / 4096 - 1)], juce::Decibels::gainToDecibels(0.25 * std::sqrt(0.5)), 0.05,
+                                          juce::String(Getter::getBallistics(ballistics).name) + " tone");
+            }
+        }
+
+        beginTest("Kcomp ballistics hold the peak for 100 ms, then drop to the level");
+        {
+            //half a second of tone, then one 14 dB lower; 240 samples is 5 ms and 5 whole periods
+            const auto input = makeSignal<float>(2, 48000, [](int, int i) { return sine(1000.0, i < 24000 ? 0.5f : 0.1f, i); });
+
+            Getter getter;
+            const auto peaksDb = measure(getter, input, 0, 240, [&getter] { return getter.getMaxLevel(0); });
+
+            expectWithinAbsoluteError(peaksDb[size_t((24000 + 4800) / 240 - 1)], -6.02, 0.01, "100 ms after the drop");
+            expectWithinAbsoluteError(peaksDb[size_t((24000 + 4800) / 240)], -20.0, 0.01, "one block later");
+        }
+
+        beginTest("Clip flags and overall peaks stay until the editor clears them");
+        {
+            //50 blocks over full scale, then 50 at half of it
+            const auto input = makeSignal<float>(2, 24000, [](int, int i) { return sine(1000.0, i < 12000 ? 1.2f : 0.5f, i); });
+
+            Getter getter;
+            int block = 0;
+            std::vector<bool> clips;
+            std::vector<float> overalls;
+            auto clearedShown = true;
+            measure(getter, input, 0, 240, [&]
+            {
+                clips.push_back(getter.getClipFlag(0));
+                overalls.push_back(getter.getMaxOverallLevel(0));
+
+                //what's shown goes at once, the audio thread's copy with the next block
+                if (++block == 75)
+                {
+                    getter.clearAllClipFlags();
+                    getter.clearMaxOveralls();
+                    clearedShown = ! getter.getClipFlag(0) && getter.getMaxOverallLevel(0) == infinity;
+                }
+                return 0.0f;
+            });
+
+            expect(clips[0] && clips[74], "clipped, and still flagged 25 quiet blocks later");
+            expectWithinAbsoluteError(overalls[74], 1.2f, 1.0e-5f, "overall peak 25 quiet blocks later");
+            expect(clearedShown, "cleared on the editor's side");
+            expect(! clips[75] && ! clips[99], "not flagged after the clear");
+            expectWithinAbsoluteError(overalls[75], 0.5f, 1.0e-5f, "overall peak after the clear");
+        }
+
+        beginTest("An over between the samples clips on true peaks, not on sample peaks");
+        {
+            //a quarter of the sample rate 45 degrees off: the samples sit 3 dB under the crests, at 0.95
+            const auto amplitude = 0.95 * std::sqrt(2.0);
+            const auto input = makeSignal<float>(2, 24000, [amplitude](int, int i)
+            {
+                return float(amplitude * std::sin(juce::MathConstants<double>::halfPi * i + juce::MathConstants<double>::pi / 4.0));
+            });
+
+            for (auto truePeak : { false, true })
+            {
+                Getter getter;
+                measure(getter, input, 0, blockSize, [] { return 0.0f; }, truePeak);
+
+                const auto name = juce::String(truePeak ? "true peaks" : "sample peaks");
+                expectEquals(getter.isTruePeak(), truePeak, name);
+                expectWithinAbsoluteError(getter.getMaxLevel(0), 0.95f, 1.0e-4f, name + ", peak");
+                expectEquals(getter.getClipFlag(0), truePeak, name + ", clip");
+                expectWithinAbsoluteError(juce::Decibels::gainToDecibels(double(getter.getMaxOverallLevel(0))),
+                                          juce::Decibels::gainToDecibels(truePeak ? amplitude : 0.95), 0.2, name + ", overall");
+            }
+        }
+
+        beginTest("The triple buffer hands over the newest snapshot, whole");
+        {
+            KcompTripleBuffer<std::array<int, 64>> buffer;
+            expect(! buffer.acquire(), "nothing published yet");
+
+            for (int value : { 1, 2, 3 })
+            {
+                buffer.getWriteSlot().fill(value);
+                buffer.publish();
+            }
+            expect(buffer.hasFreshSlot(), "fresh after publishing");
+            expect(buffer.acquire(), "acquired");
+            expectEquals(buffer.getReadSlot()[0], 3, "the newest of three");
+            expect(! buffer.hasFreshSlot() && ! buffer.acquire(), "nothing new since");
+            expectEquals(buffer.getReadSlot()[63], 3, "the read slot stays");
+
+            //a writer thread publishing as fast as it can: every acquired slot is one whole publish, never older than the last
+            constexpr int numPublishes = 200000;
+            std::atomic<bool> done{ false };
+            std::thread writer([&buffer, &done]
+            {
+                for (int value = 4; value < numPublishes; ++value)
+                {
+                    buffer.getWriteSlot().fill(value);
+                    buffer.publish();
+                }
+                done = true;
+            });
+
+            auto whole = true, ordered = true;
+            auto last = 3, numAcquired = 0;
+            while (! done || buffer.hasFreshSlot())
+            {
+                if (buffer.acquire())
+                {
+                    const auto& slot = buffer.getReadSlot();
+                    whole = whole && std::all_of(slot.begin(), slot.end(), [&slot](int value) { return value == slot[0]; });
+                    ordered = ordered && slot[0] > last;
+                    last = slot[0];
+                    ++numAcquired;
+                }
+            }
+            writer.join();
+
+            expect(whole, "no torn snapshots over " + juce::String(numAcquired) + " acquires");
+            expect(ordered, "always newer than the last one");
+            expectEquals(last, numPublishes - 1, "ends on the last publish");
+        }
+    }
+
+private:
+
+    //Runs input through an idle engine hostBlockSize samples at a time, the getter takes its levels after every block,
+    //with the output true peaks when truePeak is set. Returns what read() shows after each block, in dB.
+    template <typename ReadFunction>
+    static std::vector<double> measure(LevelMeter::LevelMeterGetter& getter, const juce::AudioBuffer<float>& input, int ballistics,
+                                       int hostBlockSize, ReadFunction&& read, bool truePeak = false)
+    {
+        KcompEngine<float> engine;
+        engine.setTruePeakMeter(truePeak);
+        engine.setParameters(KcompEngine<float>::Parameters{});
+        engine.prepare({ sampleRate, juce::uint32(hostBlockSize), 2 });
+        getter.prepare(2, sampleRate);
+        getter.setBallistics(ballistics);
+
+        std::vector<double> readings;
+        juce::AudioBuffer<float> block(2, hostBlockSize);
+        for (int start = 0; start < input.getNumSamples(); start += hostBlockSize)
+        {
+            const auto num = juce::jmin(hostBlockSize, input.getNumSamples() - start);
+            block.setSize(2, num, false, false, true);
+            for (int channel = 0; channel < 2; ++channel)
+            {
+                block.copyFrom(channel, 0, input, channel, start, num);
+            }
+
+            engine.process(block);
+            getter.loadMeterData(engine.getInputLevels(), 2, num, truePeak ? engine.getOutputTruePeaks() : nullptr);
+            getter.readLevels();
+            readings.push_back(juce::Decibels::gainToDecibels(double(read()), -200.0));
+        }
+        return readings;
+    }
+};
+
+static LevelMeterTests levelMeterTests;
@@ -0,0 +1,104 @@
+#include <JuceHeader.h>
+#include "KcompTestHelpers.h"
+
+using namespace KcompTestHelpers;
+
+//==============================================================================
+class LevelStatsTests : public juce::UnitTest
+{
+public:
+
+    LevelStatsTests() : juce::UnitTest("Level stats", "Kcomp") {}
+
+    void runTest() override
+    {
+        beginTest("One pass matches the plain sums");
+        {
+            auto random = getRandom();
+            for (auto numSamples : { 1, 7, 255, 256, 1000, 4097 })
+            {
+                const auto signal = makeSignal<float>(1, numSamples, [&random](int, int) { return random.nextFloat() * 1.5f - 0.5f; });
+                const auto* data = signal.getReadPointer(0);
+
+                auto peak = 0.0f;
+                auto sumOfSquares = 0.0, sum = 0.0;
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    peak = juce::jmax(peak, std::abs(data[i]));
+                    sumOfSquares += double(data[i]) * data[i];
+                    sum += data[i];
+                }
+
+                const auto levels = Stats::measure(data, numSamples);
+                const auto name = juce::String(numSamples) + " samples";
+                expectEquals(levels.peak, peak, name);
+                expectWithinAbsoluteError(double(levels.rms), std::sqrt(sumOfSquares / numSamples), 1.0e-6, name);
+                expectWithinAbsoluteError(double(levels.dcOffset), sum / numSamples, 1.0e-6, name);
+                expectWithinAbsoluteError(double(levels.crestFactor), peak / std::sqrt(sumOfSquares / numSamples), 1.0e-5, name);
+            }
+        }
+
+        beginTest("DC offset and crest factor of a sine");
+        {
+            //whole periods, so the sine itself averages out
+            const auto signal = makeSignal<float>(1, 4800, [](int, int i) { return sine(1000.0, 0.5f, i); });
+            auto levels = Stats::measure(signal.getReadPointer(0), signal.getNumSamples());
+            expectWithinAbsoluteError(levels.crestFactor, std::sqrt(2.0f), 1.0e-4f, "sine");
+            expectWithinAbsoluteError(levels.dcOffset, 0.0f, 1.0e-6f, "sine");
+
+            const auto offset = makeSignal<float>(1, 4800, [](int, int i) { return 0.25f + sine(1000.0, 0.5f, i); });
+            levels = Stats::measure(offset.getReadPointer(0), offset.getNumSamples());
+            expectWithinAbsoluteError(levels.dcOffset, 0.25f, 1.0e-6f, "offset sine");
+            expectWithinAbsoluteError(levels.rms, std::sqrt(0.5f * 0.25f + 0.25f * 0.25f), 1.0e-5f, "offset sine");
+            expectWithinAbsoluteError(levels.peak, 0.75f, 1.0e-4f, "offset sine");
+
+            const float silence[16]{};
+            expectEquals(Stats::measure(silence, 16).crestFactor, 0.0f, "silence");
+        }
+
+        beginTest("The engine's meter taps measure each block");
+        {
+            //idle, so the output is the input, across more channels than one register holds
+            constexpr int numChannels = 6;
+            auto random = getRandom();
+            const auto input = makeSignal<float>(numChannels, 8 * blockSize, [&random](int channel, int)
+            {
+                return (random.nextFloat() * 2.0f - 0.8f) * 0.01f * float(channel + 1);
+            });
+
+            KcompEngine<float> engine;
+            prepareEngine(engine, KcompEngine<float>::Parameters{}, numChannels);
+
+            auto worst = 0.0;
+            process(engine, input, [&](int block)
+            {
+                if (block == 0)
+                {
+                    return;
+                }
+
+                //levels of the block just processed
+                for (int channel = 0; channel < numChannels; ++channel)
+                {
+                    const auto expected = Stats::measure(input.getReadPointer(channel, (block - 1) * blockSize), blockSize);
+                    for (const auto* stats : { &engine.getInputLevels(), &engine.getOutputLevels() })
+                    {
+                        //the crest factor is a ratio around 3, the rest are levels around 0.01
+                        worst = juce::jmax(worst,
+                                           juce::jmax(std::abs(double(stats->getPeaks()[channel] - expected.peak)),
+                                                      std::abs(double(stats->getRMSLevels()[channel] - expected.rms))),
+                                           juce::jmax(std::abs(double(stats->getDCOffsets()[channel] - expected.dcOffset)),
+                                                      std::abs(double(stats->getCrestFactors()[channel] - expected.crestFactor)) * 1.0e-2));
+                    }
+                }
+            });
+            expectLessOrEqual(worst, 1.0e-6, "input and output taps");
+        }
+    }
+
+private:
+
+    using Stats = KcompLevelStats<float>;
+};
+
+static LevelStatsTests levelStatsTests;
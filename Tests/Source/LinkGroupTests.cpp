@@ -0,0 +1,102 @@
+#include <JuceHeader.h>
+#include "KcompTestHelpers.h"
+
+using namespace KcompTestHelpers;
+
+//==============================================================================
+/*
+    Linked mode on layouts with more than one link group. The reference does
+    it the slow way: every group's loudest rectified member, sample by sample,
+    through an unlinked mono engine, whose gain then goes on every member.
+    Channels outside any group get a mono engine of their own.
+*/
+class LinkGroupTests : public juce::UnitTest
+{
+public:
+
+    LinkGroupTests() : juce::UnitTest("Link Groups", "Kcomp") {}
+
+    void runTest() override
+    {
+        beginTest("7.1.4 links front, surround and height apart, the LFE on its own");
+        {
+            //L R C, LFE, the four surrounds, the four heights
+            const auto layout = juce::AudioChannelSet::create7point1point4();
+            expectLinkedMatches(layout, { 0, 0, 0, -1, 1, 1, 1, 1, 2, 2, 2, 2 }, "7.1.4");
+        }
+
+        beginTest("Ambisonics link every channel");
+        {
+            for (int order : { 1, 3 })
+            {
+                const auto layout = juce::AudioChannelSet::ambisonic(order);
+                expectLinkedMatches(layout, std::vector<int>(size_t(layout.size()), 0), "order " + juce::String(order));
+            }
+        }
+    }
+
+private:
+
+    static constexpr int numSamples = 24000;
+
+    //Never crosses zero, so the gain is output / input everywhere. Channel 3 is the loudest, the LFE on 7.1.4,
+    //so an LFE that got linked would pull the front down with it.
+    static float getInput(int channel, int i)
+    {
+        const auto level = channel == 3 ? 0.9f : 0.05f + 0.05f * float(channel);
+        return level * (1.0f + 0.5f * sine(50.0 + 37.0 * channel, 1.0f, i));
+    }
+
+    static KcompEngine<float>::Parameters getParameters()
+    {
+        KcompEngine<float>::Parameters params;
+        params.thresholdDb = -20.0f;
+        params.attackMs = 2.0f;
+        params.releaseMs = 40.0f;
+        params.linked = true;
+        return params;
+    }
+
+    //groups holds each channel's link group, -1 for a detector of its own
+    void expectLinkedMatches(const juce::AudioChannelSet& layout, const std::vector<int>& groups, const juce::String& name)
+    {
+        const auto numChannels = layout.size();
+        const auto input = makeSignal<float>(numChannels, numSamples, [](int channel, int i) { return getInput(channel, i); });
+
+        KcompEngine<float> engine;
+        engine.setChannelLayout(layout);
+        prepareEngine(engine, getParameters(), numChannels);
+        const auto output = process(engine, input);
+
+        auto worst = 0.0;
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            //the detector signal of the channel's group, or of the channel alone
+            const auto key = makeSignal<float>(1, numSamples, [&](int, int i)
+            {
+                auto loudest = 0.0f;
+                for (int member = 0; member < numChannels; ++member)
+                {
+                    if (member == channel || (groups[size_t(channel)] >= 0 && groups[size_t(member)] == groups[size_t(channel)]))
+                    {
+                        loudest = juce::jmax(loudest, std::abs(input.getSample(member, i)));
+                    }
+                }
+                return loudest;
+            });
+
+            auto params = getParameters();
+            params.linked = false;
+            const auto keyOutput = run(key, params);
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const auto expected = double(input.getSample(channel, i)) * keyOutput.getSample(0, i) / key.getSample(0, i);
+                worst = juce::jmax(worst, std::abs(output.getSample(channel, i) - expected));
+            }
+        }
+        expectLessOrEqual(worst, 1.0e-5, name);
+    }
+};
+
+static LinkGroupTests linkGroupTests;
@@ -0,0 +1,187 @@
+#include <JuceHeader.h>
+#include "KcompTestHelpers.h"
+
+using namespace KcompTestHelpers;
+
+//==============================================================================
+/*
+    The K-weighting against the BS.1770 coefficients, the meter against the
+    EBU Tech 3341 and 3342 test signals (stereo 1 kHz sines), and the engine
+    feeding it the same readings whatever the host block size.
+*/
+class LoudnessTests : public juce::UnitTest
+{
+public:
+
+    LoudnessTests() : juce::UnitTest("Loudness", "Kcomp") {}
+
+    void runTest() override
+    {
+        beginTest("K-weighting matches the BS.1770 coefficients at 48 kHz");
+        {
+            //shelf, then the RLB high-pass: b0, b1, b2, a1, a2
+            const double reference[2][5]{ { 1.53512485958697, -2.69169618940638, 1.19839281085285, -1.69065929318241, 0.73248077421585 },
+                                          { 1.0, -2.0, 1.0, -1.99004745483398, 0.99007225036621 } };
+
+            KcompKWeighting<double> kWeighting;
+            kWeighting.prepare(48000.0, 1);
+            auto state = kWeighting.load(0);
+
+            double s1[2]{}, s2[2]{};
+            auto worst = 0.0;
+            for (int i = 0; i < 4800; ++i)
+            {
+                auto x = i == 0 ? 1.0 : 0.0;
+                const auto y = kWeighting.process(state, KcompSIMD::Register<double>::expand(x));
+
+                for (int section = 0; section < 2; ++section)
+                {
+                    const auto* c = reference[section];
+                    const auto out = c[0] * x + s1[section];
+                    s1[section] = c[1] * x - c[3] * out + s2[section];
+                    s2[section] = c[2] * x - c[4] * out;
+                    x = out;
+                }
+
+                double lanes[KcompSIMD::Register<double>::SIMDNumElements];
+                KcompSIMD::store(lanes, y);
+                worst = juce::jmax(worst, std::abs(lanes[0] - x));
+            }
+            expectLessOrEqual(worst, 1.0e-7, "impulse response");
+        }
+
+        beginTest("Tech 3341 cases 1 to 4");
+        {
+            auto reading = measureTones({ { 20.0, -23.0 } });
+            expectWithinAbsoluteError(reading.momentary, -23.0f, 0.1f, "case 1 momentary");
+            expectWithinAbsoluteError(reading.shortTerm, -23.0f, 0.1f, "case 1 short-term");
+            expectWithinAbsoluteError(reading.integrated, -23.0f, 0.1f, "case 1 integrated");
+
+            reading = measureTones({ { 20.0, -33.0 } });
+            expectWithinAbsoluteError(reading.momentary, -33.0f, 0.1f, "case 2 momentary");
+            expectWithinAbsoluteError(reading.shortTerm, -33.0f, 0.1f, "case 2 short-term");
+            expectWithinAbsoluteError(reading.integrated, -33.0f, 0.1f, "case 2 integrated");
+
+            //the relative gate has to drop the quieter parts, the absolute one the -72 dBFS ones
+            reading = measureTones({ { 10.0, -36.0 }, { 60.0, -23.0 }, { 10.0, -36.0 } });
+            expectWithinAbsoluteError(reading.integrated, -23.0f, 0.1f, "case 3 integrated");
+
+            reading = measureTones({ { 10.0, -72.0 }, { 10.0, -36.0 }, { 60.0, -23.0 }, { 10.0, -36.0 }, { 10.0, -72.0 } });
+            expectWithinAbsoluteError(reading.integrated, -23.0f, 0.1f, "case 4 integrated");
+        }
+
+        beginTest("Tech 3342 loudness range cases 1 to 4");
+        {
+            expectWithinAbsoluteError(measureTones({ { 20.0, -20.0 }, { 20.0, -30.0 } }).range, 10.0f, 1.0f, "case 1");
+            expectWithinAbsoluteError(measureTones({ { 20.0, -20.0 }, { 20.0, -15.0 } }).range, 5.0f, 1.0f, "case 2");
+            expectWithinAbsoluteError(measureTones({ { 20.0, -40.0 }, { 20.0, -20.0 } }).range, 20.0f, 1.0f, "case 3");
+            expectWithinAbsoluteError(measureTones({ { 20.0, -50.0 }, { 20.0, -35.0 }, { 20.0, -20.0 }, { 20.0, -35.0 }, { 20.0, -50.0 } }).range,
+                                      15.0f, 1.0f, "case 4");
+        }
+
+        beginTest("The engine's readings don't depend on the host block size");
+        {
+            //noise, silence long enough for the engine to sleep, then a tone
+            auto random = getRandom();
+            const auto input = makeSignal<float>(2, 6 * 48000, [&random](int, int i)
+            {
+                if (i < 3 * 48000)
+                {
+                    return (random.nextFloat() * 2.0f - 1.0f) * 0.1f;
+                }
+                return i < 5 * 48000 ? 0.0f : sine(1000.0, 0.03f, i);
+            });
+
+            const auto expected = measureEngine(input, 32);
+            for (auto hostBlockSize : { 441, 1000, 4096 })
+            {
+                const auto reading = measureEngine(input, hostBlockSize);
+                const auto name = juce::String(hostBlockSize) + " samples";
+                expectWithinAbsoluteError(reading.momentary, expected.momentary, 0.01f, name + " momentary");
+                expectWithinAbsoluteError(reading.shortTerm, expected.shortTerm, 0.01f, name + " short-term");
+                expectWithinAbsoluteError(reading.integrated, expected.integrated, 0.01f, name + " integrated");
+                expectWithinAbsoluteError(reading.range, expected.range, 0.01f, name + " range");
+            }
+        }
+    }
+
+private:
+
+    struct Tone
+    {
+        double seconds, levelDb;
+    };
+
+    //Stereo 1 kHz sines at the given peak levels one after the other, 32 samples at a time like the engine
+    static KcompLoudnessMeter::Reading measureTones(std::initializer_list<Tone> tones)
+    {
+        using Vec = KcompSIMD::Register<float>;
+
+        KcompKWeighting<float> kWeighting;
+        kWeighting.prepare(sampleRate, 1);
+        auto state = kWeighting.load(0);
+
+        KcompLoudnessMeter meter;
+        meter.prepare(sampleRate);
+
+        constexpr int chunkSize = 32;
+        int sample = 0;
+        for (const auto& tone : tones)
+        {
+            const auto amplitude = juce::Decibels::decibelsToGain(float(tone.levelDb));
+            const auto end = sample + juce::roundToInt(tone.seconds * sampleRate);
+
+            while (sample < end)
+            {
+                const auto num = juce::jmin(chunkSize, end - sample);
+                auto sumOfSquares = Vec::expand(0.0f);
+                for (int i = 0; i < num; ++i, ++sample)
+                {
+                    //both channels in the first two lanes, the rest stay silent
+                    float frame[Vec::SIMDNumElements]{};
+                    for (int channel = 0; channel < juce::jmin(2, int(Vec::SIMDNumElements)); ++channel)
+                    {
+                        frame[channel] = sine(1000.0, amplitude, sample);
+                    }
+
+                    const auto weighted = kWeighting.process(state, KcompSIMD::load(frame));
+                    sumOfSquares += weighted * weighted;
+                }
+
+                //a one-lane build only has the left channel, the right one is the same
+                meter.add(double(sumOfSquares.sum()) * (Vec::SIMDNumElements == 1 ? 2.0 : 1.0), num);
+            }
+        }
+
+        return meter.getReading();
+    }
+
+    //Input meter of an idle engine fed hostBlockSize samples at a time
+    static KcompLoudnessMeter::Reading measureEngine(const juce::AudioBuffer<float>& input, int hostBlockSize)
+    {
+        KcompLoudnessMeter inputMeter, outputMeter;
+        inputMeter.prepare(sampleRate);
+        outputMeter.prepare(sampleRate);
+
+        KcompEngine<float> engine;
+        engine.setLoudnessMeters(&inputMeter, &outputMeter);
+        engine.setParameters(KcompEngine<float>::Parameters{});
+        engine.prepare({ sampleRate, juce::uint32(hostBlockSize), 2 });
+
+        juce::AudioBuffer<float> block(2, hostBlockSize);
+        for (int start = 0; start < input.getNumSamples(); start += hostBlockSize)
+        {
+            const auto num = juce::jmin(hostBlockSize, input.getNumSamples() - start);
+            block.setSize(2, num, false, false, true);
+            for (int channel = 0; channel < 2; ++channel)
+            {
+                block.copyFrom(channel, 0, input, channel, start, num);
+            }
+            engine.process(block);
+        }
+
+        return inputMeter.getReading();
+    }
+};
+
+static LoudnessTests loudnessTests;
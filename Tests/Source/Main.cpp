@@ -0,0 +1,41 @@
+/*
+  ==============================================================================
+
+    This file contains the basic startup code for the Kcomp test runner.
+
+    KcompTests runs every unit test in the "Kcomp" category.
+    KcompTests --benchmark runs the benchmarks instead (Release builds only).
+    Either way the exit code is non-zero if anything failed.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include "KcompBenchmark.h"
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    if (juce::ArgumentList(argc, argv).containsOption("--benchmark"))
+    {
+        const auto passed = KcompBenchmark::runAll([](const juce::String& title, const juce::String& report)
+        {
+            std::cout << title << std::endl << report << std::endl << std::endl;
+        });
+
+        return passed ? 0 : 1;
+    }
+
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure(false);
+    runner.runTestsInCategory("Kcomp");
+
+    int failures = 0;
+    for (int i = 0; i < runner.getNumResults(); ++i)
+    {
+        failures += runner.getResult(i)->failures;
+    }
+
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,98 @@
+#include <JuceHeader.h>
+#include "KcompTestHelpers.h"
+
+using namespace KcompTestHelpers;
+
+//==============================================================================
+/*
+    Four bands at the default crossovers, 120 Hz, 1 kHz and 6 kHz, with a
+    tone in the middle of each band.
+*/
+class MultibandTests : public juce::UnitTest
+{
+public:
+
+    MultibandTests() : juce::UnitTest("Multiband", "Kcomp") {}
+
+    void runTest() override
+    {
+        beginTest("Idle bands sum back flat");
+        for (auto frequency : { 40.0, 120.0, 350.0, 1000.0, 2500.0, 6000.0, 12000.0 })
+        {
+            const auto input = makeTone(frequency);
+            const auto output = run(input, getParameters(-1));
+            expectWithinAbsoluteError(getRMSDb(output, 0, settle, numSamples - settle), getRMSDb(input, 0, settle, numSamples - settle), 0.05,
+                                      juce::String(frequency) + " Hz");
+        }
+
+        beginTest("Each band only compresses its own range");
+        for (int band = 0; band < KcompEngine<float>::maxBands; ++band)
+        {
+            for (int toneBand = 0; toneBand < KcompEngine<float>::maxBands; ++toneBand)
+            {
+                const auto input = makeTone(bandCentres[toneBand]);
+                const auto reductionDb = getRMSDb(input, 0, settle, numSamples - settle)
+                                       - getRMSDb(run(input, getParameters(band)), 0, settle, numSamples - settle);
+
+                const auto name = "band " + juce::String(band + 1) + " compressing, " + juce::String(bandCentres[toneBand]) + " Hz";
+                if (band == toneBand)
+                {
+                    //-12 dBFS peaks are 13.5 dB down at 4:1, less the part of the tone the neighbouring bands carry
+                    expectGreaterThan(reductionDb, 10.0, name);
+                }
+                else
+                {
+                    expectWithinAbsoluteError(reductionDb, 0.0, 0.05, name);
+                }
+            }
+        }
+
+        beginTest("Crossovers out of order are kept in order");
+        {
+            const auto input = makeSignal<float>(2, numSamples, [](int, int i)
+            {
+                return sine(bandCentres[0], 0.1f, i) + sine(bandCentres[2], 0.1f, i) + sine(bandCentres[3], 0.1f, i);
+            });
+
+            auto params = getParameters(2);
+            params.crossoverFrequencies[0] = 6000.0f;
+            params.crossoverFrequencies[1] = 1000.0f;
+            params.crossoverFrequencies[2] = 120.0f;
+            const auto reversed = run(input, params);
+
+            params.crossoverFrequencies[1] = 6000.0f;
+            params.crossoverFrequencies[2] = 6000.0f;
+            expectLessOrEqual(getMaxDifference(reversed, run(input, params)), 1.0e-6, "6000, 1000, 120 is 6000, 6000, 6000");
+        }
+    }
+
+private:
+
+    static constexpr int numSamples = 48000;
+    static constexpr int settle = 24000;
+    static constexpr double bandCentres[]{ 40.0, 350.0, 2500.0, 12000.0 };
+
+    //Four bands, only compressingBand under its threshold (none for -1)
+    static KcompEngine<float>::Parameters getParameters(int compressingBand)
+    {
+        KcompEngine<float>::Parameters params;
+        params.numBands = KcompEngine<float>::maxBands;
+        params.attackMs = 1.0f;
+        params.releaseMs = 100.0f;
+
+        for (int band = 0; band < KcompEngine<float>::maxBands; ++band)
+        {
+            params.bands[band] = { band == compressingBand ? -30.0f : 0.0f, params.attackMs, params.releaseMs };
+        }
+        return params;
+    }
+
+    static juce::AudioBuffer<float> makeTone(double frequency)
+    {
+        return makeSignal<float>(2, numSamples, [frequency](int, int i) { return sine(frequency, 0.25f, i); });
+    }
+};
+
+constexpr double MultibandTests::bandCentres[];
+
+static MultibandTests multibandTests;
@@ -0,0 +1,147 @@
+#include <JuceHeader.h>
+#include "KcompTestHelpers.h"
+
+using namespace KcompTestHelpers;
+
+//==============================================================================
+class OversamplingTests : public juce::UnitTest
+{
+public:
+
+    OversamplingTests() : juce::UnitTest("Oversampling", "Kcomp") {}
+
+    void runTest() override
+    {
+        beginTest("Latency is the oversampling filters plus the lookahead");
+        {
+            //the processor asks an engine running other settings what the new latency will be
+            KcompEngine<float> idle;
+            prepareEngine(idle, KcompEngine<float>::Parameters{}, 2);
+
+            for (int type = 0; type < 2; ++type)
+            {
+                for (int order = 0; order <= KcompEngine<float>::maxOversamplingOrder; ++order)
+                {
+                    auto params = getParameters(order, type == 1);
+                    params.lookaheadMs = 2.0f;
+
+                    KcompEngine<float> engine;
+                    prepareEngine(engine, params, 2);
+                    expectEquals(engine.getLatencySamples(), getFilterLatency(order, type == 1) + juce::roundToInt(0.002 * sampleRate),
+                                 getName(order, type == 1));
+                    expectEquals(idle.getLatencySamples(params), engine.getLatencySamples(), getName(order, type == 1) + " ahead of time");
+                }
+            }
+        }
+
+        beginTest("Changing the lookahead keeps the delay lines running");
+        {
+            //an idle compressor on DC: moving the read position repeats or skips some DC, clearing the line would drop out
+            auto params = getParameters(0, false);
+            params.lookaheadMs = 2.0f;
+
+            KcompEngine<float> engine;
+            prepareEngine(engine, params, 2);
+
+            const auto input = makeSignal<float>(2, numSamples, [](int, int) { return 0.1f; });
+            const auto output = process(engine, input, [&](int block)
+            {
+                if (block == 20 || block == 40)
+                {
+                    params.lookaheadMs = block == 20 ? 10.0f : 1.0f;
+                    engine.setParameters(params);
+                }
+            });
+
+            auto lowest = 1.0f;
+            for (int i = juce::roundToInt(0.002 * sampleRate); i < numSamples; ++i)
+            {
+                lowest = juce::jmin(lowest, output.getSample(0, i));
+            }
+            expectWithinAbsoluteError(lowest, 0.1f, 1.0e-6f, "lowest sample after the first latency");
+        }
+
+        beginTest("Wet and dry stay aligned");
+        for (int order = 1; order <= KcompEngine<float>::maxOversamplingOrder; ++order)
+        {
+            //an idle compressor at 50 % mix: in phase the two halves add up to +3 dB, out of phase they comb
+            auto params = getParameters(order, true);
+            params.dryWetMix = 0.5f;
+
+            KcompEngine<float> engine;
+            prepareEngine(engine, params, 2);
+
+            const auto input = makeSignal<float>(2, numSamples, [](int, int i) { return sine(1000.0, 0.1f, i); });
+            const auto output = process(engine, input);
+            expectWithinAbsoluteError(getRMSDb(output, 0, settle, numSamples - settle) - getRMSDb(input, 0, settle, numSamples - settle),
+                                      juce::Decibels::gainToDecibels(2.0 * std::sqrt(0.5)), 0.1, getName(order, true));
+        }
+
+        beginTest("Gain reduction doesn't depend on the factor");
+        {
+            const auto input = makeSignal<float>(2, numSamples, [](int, int i) { return sine(100.0, 0.5f, i); });
+
+            KcompEngine<float> reference;
+            auto params = getParameters(0, false);
+            params.thresholdDb = -20.0f;
+            prepareEngine(reference, params, 2);
+            const auto expectedDb = getRMSDb(process(reference, input), 0, settle, numSamples - settle);
+
+            for (int type = 0; type < 2; ++type)
+            {
+                for (int order = 1; order <= KcompEngine<float>::maxOversamplingOrder; ++order)
+                {
+                    params = getParameters(order, type == 1);
+                    params.thresholdDb = -20.0f;
+
+                    KcompEngine<float> engine;
+                    prepareEngine(engine, params, 2);
+                    expectWithinAbsoluteError(getRMSDb(process(engine, input), 0, settle, numSamples - settle), expectedDb, 0.25, getName(order, type == 1));
+                }
+            }
+        }
+    }
+
+private:
+
+    static constexpr int numSamples = 24000;
+    static constexpr int settle = 12000;
+
+    static KcompEngine<float>::Parameters getParameters(int order, bool linearPhase)
+    {
+        KcompEngine<float>::Parameters params;
+        params.attackMs = 10.0f;
+        params.releaseMs = 100.0f;
+        params.oversamplingOrder = order;
+        params.linearPhaseOversampling = linearPhase;
+        return params;
+    }
+
+    //What the engine's own oversampler reports, rounded the same way
+    static int getFilterLatency(int order, bool linearPhase)
+    {
+        if (order == 0)
+        {
+            return 0;
+        }
+
+       #if JUCE_MAJOR_VERSION > 6 || (JUCE_MAJOR_VERSION == 6 && JUCE_MINOR_VERSION >= 1)
+        constexpr bool useIntegerLatency = true;
+       #else
+        constexpr bool useIntegerLatency = false;
+       #endif
+
+        juce::dsp::Oversampling<float> oversampling(2, size_t(order), linearPhase ? juce::dsp::Oversampling<float>::filterHalfBandFIREquiripple
+                                                                                  : juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR,
+                                                    true, useIntegerLatency);
+        oversampling.initProcessing(size_t(KcompEngine<float>::subBlockSize));
+        return juce::roundToInt(oversampling.getLatencyInSamples());
+    }
+
+    static juce::String getName(int order, bool linearPhase)
+    {
+        return juce::String(1 << order) + "x " + (linearPhase ? "FIR" : "IIR");
+    }
+};
+
+static OversamplingTests oversamplingTests;
@@ -0,0 +1,98 @@
+#include <JuceHeader.h>
+#include "KcompTestHelpers.h"
+
+using namespace KcompTestHelpers;
+
+//==============================================================================
+/*
+    KcompEngine<double> runs the same maths as KcompEngine<float>, half as
+    many channels per register. Fed the same signal with the same settings,
+    the two may only differ by float rounding.
+*/
+class PrecisionTests : public juce::UnitTest
+{
+public:
+
+    PrecisionTests() : juce::UnitTest("Double precision", "Kcomp") {}
+
+    //Largest difference allowed at any sample, -80 dBFS
+    static constexpr double tolerance = 1.0e-4;
+
+    void runTest() override
+    {
+        check("Single band", [](auto&) {});
+
+        check("Tame, RMS detector, lookahead", [](auto& params)
+        {
+            params.tameEnabled = true;
+            params.detectorMode = 1;
+            params.lookaheadMs = 3;
+        });
+
+        check("Three bands, linked", [](auto& params)
+        {
+            params.numBands = 3;
+            params.linked = true;
+        });
+
+        check("M/S, feedback, auto timing", [](auto& params)
+        {
+            params.stereoMode = 1;
+            params.topology = 2;
+            params.autoTiming = true;
+        });
+
+        check("Dry/wet and gains", [](auto& params)
+        {
+            params.dryWetMix = 0.3f;
+            params.inputGain = 1.5f;
+            params.outputGain = 0.7f;
+        });
+    }
+
+private:
+
+    static constexpr int numSamples = 24000;
+
+    template <typename SampleType, typename SetUpFunction>
+    static juce::AudioBuffer<SampleType> run(const juce::AudioBuffer<float>& input, SetUpFunction&& setUp)
+    {
+        typename KcompEngine<SampleType>::Parameters params;
+        params.thresholdDb = -24;
+        params.attackMs = 3;
+        params.releaseMs = 60;
+        params.makeUpGain = 2;
+        for (auto& band : params.bands)
+        {
+            band.thresholdDb = -24;
+        }
+        setUp(params);
+
+        KcompEngine<SampleType> engine;
+        prepareEngine(engine, params, input.getNumChannels());
+
+        juce::AudioBuffer<SampleType> converted;
+        converted.makeCopyOf(input);
+        return process(engine, converted);
+    }
+
+    template <typename SetUpFunction>
+    void check(const juce::String& name, SetUpFunction&& setUp)
+    {
+        beginTest(name);
+
+        //noise in bursts, the two channels at different levels
+        auto random = getRandom();
+        const auto input = makeSignal<float>(2, numSamples, [&random](int channel, int i)
+        {
+            const auto burst = (i / 4000) % 2 == 0 ? 0.9f : 0.1f;
+            return (random.nextFloat() * 2.0f - 1.0f) * burst * (channel == 0 ? 1.0f : 0.5f);
+        });
+
+        const auto difference = getMaxDifference(run<float>(input, setUp), run<double>(input, setUp));
+        logMessage("max difference " + juce::String(juce::Decibels::gainToDecibels(difference, -200.0), 1) + " dBFS");
+        expectLessOrEqual(difference, tolerance, "float and double engines differ");
+    }
+};
+
+static PrecisionTests precisionTests;
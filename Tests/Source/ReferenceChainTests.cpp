@@ -0,0 +1,201 @@
+#include <JuceHeader.h>
+#include "KcompEngine.h"
+
+//==============================================================================
+/*
+    The signal chain as it was before KcompEngine: input gain, then
+    ProcessorChain<Filter, Comp, Gain> (Tame low-pass at 10 kHz, the
+    compressor, make-up), then the DryWetMixer and the output gain.
+
+    KcompEngine has to follow it sample for sample while nothing moves, so
+    both get their settings before prepare(): no ramps, no glide, the curve
+    already in place. What's left is float rounding and the engine's log2
+    gain computer against std::pow.
+*/
+class ReferenceChainTests : public juce::UnitTest
+{
+public:
+
+    ReferenceChainTests() : juce::UnitTest("Reference chain", "Kcomp") {}
+
+    //Largest difference allowed at any sample, -80 dBFS
+    static constexpr float tolerance = 1.0e-4f;
+
+    void runTest() override
+    {
+        //the four ratio buttons the old editor had
+        for (auto ratio : { 1.5f, 5.0f, 10.0f, 20.0f })
+        {
+            Settings settings;
+            settings.ratio = ratio;
+            check("ratio " + juce::String(ratio, 1), settings);
+        }
+
+        Settings slow;
+        slow.attackMs = 30.0f;
+        slow.releaseMs = 400.0f;
+        slow.thresholdDb = -30.0f;
+        check("slow attack and release", slow);
+
+        Settings fast;
+        fast.attackMs = 0.0f;
+        fast.releaseMs = 5.0f;
+        check("zero attack", fast);
+
+        Settings tameOff;
+        tameOff.tameEnabled = false;
+        check("Tame off", tameOff);
+
+        Settings blend;
+        blend.dryWetMix = 0.4f;
+        blend.inputGain = juce::Decibels::decibelsToGain(4.0f);
+        blend.outputGain = juce::Decibels::decibelsToGain(-6.0f);
+        check("dry/wet and gains", blend);
+    }
+
+private:
+
+    struct Settings
+    {
+        float inputGain{ 1.0f };
+        float thresholdDb{ -20.0f };
+        float ratio{ 5.0f };
+        float attackMs{ 5.0f };
+        float releaseMs{ 80.0f };
+        float makeUpGain{ juce::Decibels::decibelsToGain(6.0f) };
+        float dryWetMix{ 1.0f };
+        float outputGain{ 1.0f };
+        bool tameEnabled{ true };
+    };
+
+    static constexpr double sampleRate = 48000.0;
+    static constexpr int blockSize = 480;
+    static constexpr int numChannels = 2;
+    static constexpr int numBlocks = 200;
+    static constexpr float filterFreq = 10000.0f;
+
+    //The old KcompAudioProcessor::processBlock, prepared the way prepareToPlay did it
+    struct ReferenceChain
+    {
+        using Gain = juce::dsp::Gain<float>;
+        using Filter = juce::dsp::ProcessorDuplicator<juce::dsp::IIR::Filter<float>, juce::dsp::IIR::Coefficients<float>>;
+        using Comp = juce::dsp::Compressor<float>;
+
+        enum ChainIDs
+        {
+            filter_ID,
+            compressor_ID,
+            makeUpGain_ID
+        };
+
+        void prepare(const juce::dsp::ProcessSpec& spec, const Settings& settings)
+        {
+            inputGain.setGainLinear(settings.inputGain);
+
+            kComp.get<filter_ID>().state = juce::dsp::IIR::Coefficients<float>::makeLowPass(spec.sampleRate, filterFreq);
+            kComp.setBypassed<filter_ID>(! settings.tameEnabled);
+
+            auto& comp = kComp.get<compressor_ID>();
+            comp.setAttack(settings.attackMs);
+            comp.setRelease(settings.releaseMs);
+            comp.setThreshold(settings.thresholdDb);
+            comp.setRatio(settings.ratio);
+
+            kComp.get<makeUpGain_ID>().setGainLinear(settings.makeUpGain);
+            outputGain.setGainLinear(settings.outputGain);
+
+            inputGain.prepare(spec);
+            kComp.prepare(spec);
+            outputGain.prepare(spec);
+
+            //set before prepare() so the mixer starts there instead of ramping from all wet
+            dryWet.setMixingRule(juce::dsp::DryWetMixingRule::squareRoot3dB);
+            dryWet.setWetMixProportion(settings.dryWetMix);
+            dryWet.prepare(spec);
+        }
+
+        void process(juce::AudioBuffer<float>& buffer)
+        {
+            juce::dsp::AudioBlock<float> block(buffer);
+            dryWet.pushDrySamples(block);
+            juce::dsp::ProcessContextReplacing<float> context(block);
+
+            inputGain.process(context);
+            kComp.process(context);
+            dryWet.mixWetSamples(context.getOutputBlock());
+            outputGain.process(context);
+        }
+
+        Gain inputGain, outputGain;
+        juce::dsp::ProcessorChain<Filter, Comp, Gain> kComp;
+        juce::dsp::DryWetMixer<float> dryWet;
+    };
+
+    void check(const juce::String& name, const Settings& settings)
+    {
+        beginTest(name);
+
+        const juce::dsp::ProcessSpec spec{ sampleRate, juce::uint32(blockSize), juce::uint32(numChannels) };
+
+        ReferenceChain reference;
+        reference.prepare(spec, settings);
+
+        KcompEngine<float>::Parameters params;
+        params.inputGain = settings.inputGain;
+        params.thresholdDb = settings.thresholdDb;
+        params.attackMs = settings.attackMs;
+        params.releaseMs = settings.releaseMs;
+        params.makeUpGain = settings.makeUpGain;
+        params.dryWetMix = settings.dryWetMix;
+        params.outputGain = settings.outputGain;
+        params.tameEnabled = settings.tameEnabled;
+        params.tameFrequencyHz = filterFreq;
+        params.tameSlope = 1;
+
+        KcompTransferCurve<float>::Settings curve;
+        curve.ratio = settings.ratio;
+
+        KcompEngine<float> engine;
+        engine.setTransferCurve(0, curve);
+        engine.setParameters(params);
+        engine.prepare(spec);
+
+        //noise with a slow swell and a few bursts, so the envelope attacks and releases through the whole range
+        auto random = getRandom();
+        juce::AudioBuffer<float> referenceBuffer(numChannels, blockSize), engineBuffer(numChannels, blockSize);
+        float maxDifference = 0.0f;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            for (int i = 0; i < blockSize; ++i)
+            {
+                const auto time = float(block * blockSize + i) / float(sampleRate);
+                const auto swell = 0.5f - 0.45f * std::cos(juce::MathConstants<float>::twoPi * 0.5f * time);
+                const auto burst = (block / 10) % 3 == 0 ? 1.0f : 0.2f;
+
+                for (int channel = 0; channel < numChannels; ++channel)
+                {
+                    const auto sample = (random.nextFloat() * 2.0f - 1.0f) * swell * burst * (channel == 0 ? 1.0f : 0.6f);
+                    referenceBuffer.setSample(channel, i, sample);
+                    engineBuffer.setSample(channel, i, sample);
+                }
+            }
+
+            reference.process(referenceBuffer);
+            engine.process(engineBuffer);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                for (int i = 0; i < blockSize; ++i)
+                {
+                    maxDifference = juce::jmax(maxDifference, std::abs(referenceBuffer.getSample(channel, i) - engineBuffer.getSample(channel, i)));
+                }
+            }
+        }
+
+        logMessage("max difference " + juce::String(juce::Decibels::gainToDecibels(maxDifference, -200.0f), 1) + " dBFS");
+        expectLessOrEqual(maxDifference, tolerance, "engine and old chain differ");
+    }
+};
+
+static ReferenceChainTests referenceChainTests;
@@ -0,0 +1,76 @@
+#include <JuceHeader.h>
+#include "KcompTestHelpers.h"
+
+using namespace KcompTestHelpers;
+
+//==============================================================================
+class StereoTests : public juce::UnitTest
+{
+public:
+
+    StereoTests() : juce::UnitTest("Stereo", "Kcomp") {}
+
+    void runTest() override
+    {
+        beginTest("M/S in and out again is transparent");
+        {
+            //under the threshold nothing touches the encoded signal
+            auto random = getRandom();
+            const auto input = makeSignal<float>(2, 24000, [&random](int, int) { return (random.nextFloat() * 2.0f - 1.0f) * 0.01f; });
+
+            KcompEngine<float>::Parameters params;
+            params.stereoMode = 1;
+            expectLessOrEqual(getMaxDifference(run(input, params), input), 1.0e-6, "idle M/S");
+        }
+
+        beginTest("Mono stays mono in M/S");
+        {
+            const auto input = makeSignal<float>(2, 24000, [](int, int i) { return sine(220.0, 0.8f, i); });
+
+            KcompEngine<float>::Parameters params;
+            params.stereoMode = 1;
+            params.thresholdDb = -24.0f;
+            const auto output = run(input, params);
+
+            juce::AudioBuffer<float> left(1, output.getNumSamples()), right(1, output.getNumSamples());
+            left.copyFrom(0, 0, output, 0, 0, output.getNumSamples());
+            right.copyFrom(0, 0, output, 1, 0, output.getNumSamples());
+
+            expectLessThan(getRMSDb(output, 0, 12000, 12000), getRMSDb(input, 0, 12000, 12000) - 6.0, "compressing");
+            expectLessOrEqual(getMaxDifference(left, right), 1.0e-6, "left against right");
+        }
+
+        //DC at different levels on the two sides, only the left one over the threshold
+        const auto input = makeSignal<float>(2, 24000, [](int channel, int) { return channel == 0 ? 0.5f : 0.05f; });
+
+        KcompEngine<float>::Parameters params;
+        params.thresholdDb = -20.0f;
+
+        beginTest("Link amount 0 is unlinked");
+        {
+            const auto unlinked = run(input, params);
+
+            params.linked = true;
+            params.linkAmount = 0.0f;
+            expectLessOrEqual(getMaxDifference(run(input, params), unlinked), 1.0e-6, "link amount 0");
+            expectEquals(unlinked.getSample(1, 23999), 0.05f, "the quiet side is left alone");
+        }
+
+        beginTest("Link amount 1 is fully linked, in between blends the levels");
+        {
+            params.linked = true;
+            params.linkAmount = 1.0f;
+            const auto linked = run(input, params);
+            expectWithinAbsoluteError(linked.getSample(0, 23999) / linked.getSample(1, 23999), 10.0f, 1.0e-4f, "left over right");
+            expectLessThan(linked.getSample(1, 23999), 0.05f, "the quiet side follows the loud one");
+
+            //in between, the right side's detector hears a blend of its own level and the loudest one: 0.275 at 4:1
+            params.linkAmount = 0.5f;
+            const auto half = run(input, params);
+            expectWithinAbsoluteError(juce::Decibels::gainToDecibels(half.getSample(1, 23999) / 0.05f),
+                                      (juce::Decibels::gainToDecibels(0.275f) - params.thresholdDb) * (1.0f / 4.0f - 1.0f), 0.01f, "link amount 0.5");
+        }
+    }
+};
+
+static StereoTests stereoTests;
@@ -0,0 +1,155 @@
+#include <JuceHeader.h>
+#include "KcompTestHelpers.h"
+
+using namespace KcompTestHelpers;
+
+//==============================================================================
+/*
+    KcompTame on its own: the bilinear Butterworth response of every slope and
+    type, and staying stable while the frequency jumps around every block.
+    Then dynamic Tame in the engine, which only cuts what goes over its threshold.
+*/
+class TameTests : public juce::UnitTest
+{
+public:
+
+    TameTests() : juce::UnitTest("Tame", "Kcomp") {}
+
+    void runTest() override
+    {
+        beginTest("12, 24, 36 and 48 dB/oct Butterworth slopes, -3 dB at the cutoff");
+        for (int numSections = 1; numSections <= KcompTame<double>::maxSections; ++numSections)
+        {
+            for (auto highPass : { false, true })
+            {
+                const auto name = juce::String(12 * numSections) + " dB/oct " + (highPass ? "high-pass" : "low-pass");
+                for (auto ratio : { 0.25, 0.5, 1.0, 2.0, 4.0 })
+                {
+                    const auto frequency = cutoff * ratio;
+                    expectWithinAbsoluteError(measureGainDb(numSections, highPass, frequency), getButterworthDb(numSections, highPass, frequency), 0.05,
+                                              name + ", " + juce::String(frequency) + " Hz");
+                }
+                expectWithinAbsoluteError(measureGainDb(numSections, highPass, cutoff), -3.01, 0.05, name + " at the cutoff");
+            }
+        }
+
+        beginTest("Stable when the frequency jumps every block");
+        {
+            using Vec = KcompTame<float>::Vec;
+
+            for (int numSections = 1; numSections <= KcompTame<float>::maxSections; ++numSections)
+            {
+                for (auto highPass : { false, true })
+                {
+                    KcompTame<float> tame;
+                    tame.setShape(numSections, highPass);
+                    tame.prepare(sampleRate, 1);
+
+                    auto random = getRandom();
+                    auto peak = 0.0f;
+                    auto finite = true;
+                    for (int block = 0; block < 10 * 48000 / KcompTame<float>::maxBlockSize; ++block)
+                    {
+                        //anywhere from 20 Hz to 20 kHz, log-uniform
+                        tame.setFrequency(20.0f * std::pow(1000.0f, random.nextFloat()));
+                        tame.fillCoefficients(KcompTame<float>::maxBlockSize);
+
+                        auto state = tame.load(0);
+                        for (int i = 0; i < KcompTame<float>::maxBlockSize; ++i)
+                        {
+                            float lanes[Vec::SIMDNumElements];
+                            for (auto& lane : lanes)
+                            {
+                                lane = random.nextFloat() * 2.0f - 1.0f;
+                            }
+
+                            KcompSIMD::store(lanes, tame.process(state, KcompSIMD::load(lanes), i));
+                            for (auto lane : lanes)
+                            {
+                                finite = finite && std::isfinite(lane);
+                                peak = juce::jmax(peak, std::abs(lane));
+                            }
+                        }
+                        tame.store(0, state);
+                    }
+
+                    const auto name = juce::String(12 * numSections) + " dB/oct " + (highPass ? "high-pass" : "low-pass");
+                    expect(finite, name + " stays finite");
+                    expectLessOrEqual(peak, 4.0f, name + " peak");
+                }
+            }
+        }
+
+        beginTest("Dynamic Tame leaves a quiet tone untouched and cuts a loud one");
+        {
+            //a 9 kHz tone against a 24 dB/oct low-pass at 4 kHz, so nearly all of it is what Tame removes
+            KcompEngine<float>::Parameters params;
+            params.tameFrequencyHz = 4000.0f;
+            params.tameSlope = 2;
+            params.tameDynamic = true;
+            params.tameThresholdDb = -40.0f;
+            params.tameRatio = 2.0f;
+
+            const auto quiet = makeSignal<float>(2, 48000, [](int, int i) { return sine(9000.0, 0.001f, i); });
+            const auto dry = run(quiet, params);
+            params.tameEnabled = true;
+            expectEquals(getMaxDifference(run(quiet, params), dry), 0.0, "-60 dBFS, 20 dB under the threshold");
+
+            //-6 dBFS is 34 dB over, at 2:1 that is 17 dB off
+            const auto loud = makeSignal<float>(2, 48000, [](int, int i) { return sine(9000.0, 0.5f, i); });
+            const auto tamed = run(loud, params);
+            expectWithinAbsoluteError(getRMSDb(tamed, 0, 24000, 24000) - getRMSDb(loud, 0, 24000, 24000), -17.0, 1.5, "-6 dBFS");
+        }
+    }
+
+private:
+
+    static constexpr double cutoff = 1000.0;
+
+    //Bilinear Butterworth of order 2 numSections: |H|^2 = 1 / (1 + r^(4 numSections)), r the prewarped frequency ratio
+    static double getButterworthDb(int numSections, bool highPass, double frequency)
+    {
+        const auto pi = juce::MathConstants<double>::pi;
+        auto ratio = std::tan(pi * frequency / sampleRate) / std::tan(pi * cutoff / sampleRate);
+        if (highPass)
+        {
+            ratio = 1.0 / ratio;
+        }
+        return -10.0 * std::log10(1.0 + std::pow(ratio, 4.0 * numSections));
+    }
+
+    //Sine in, RMS out over the second half of a second, against the sine's
+    static double measureGainDb(int numSections, bool highPass, double frequency)
+    {
+        using Vec = KcompTame<double>::Vec;
+
+        KcompTame<double> tame;
+        tame.setShape(numSections, highPass);
+        tame.setFrequency(cutoff);
+        tame.prepare(sampleRate, 1);
+
+        const auto numSamples = int(sampleRate);
+        auto sumOfSquares = 0.0;
+        for (int start = 0; start < numSamples; start += KcompTame<double>::maxBlockSize)
+        {
+            const auto num = juce::jmin(KcompTame<double>::maxBlockSize, numSamples - start);
+            tame.fillCoefficients(num);
+
+            auto state = tame.load(0);
+            for (int i = 0; i < num; ++i)
+            {
+                double lanes[Vec::SIMDNumElements];
+                KcompSIMD::store(lanes, tame.process(state, Vec::expand(sine(frequency, 1.0, start + i)), i));
+                if (start + i >= numSamples / 2)
+                {
+                    sumOfSquares += lanes[0] * lanes[0];
+                }
+            }
+            tame.store(0, state);
+        }
+
+        return juce::Decibels::gainToDecibels(std::sqrt(sumOfSquares / (numSamples / 2)) / std::sqrt(0.5), -200.0);
+    }
+};
+
+static TameTests tameTests;
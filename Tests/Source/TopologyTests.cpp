@@ -0,0 +1,81 @@
+#include <JuceHeader.h>
+#include "KcompTestHelpers.h"
+
+using namespace KcompTestHelpers;
+
+//==============================================================================
+/*
+    DC at two levels over the threshold: the output levels give the ratio
+    the topology really ends up with. Feed-forward is the curve's 4:1,
+    feedback at 4:1 settles where o = i / (2 - 1 / r), 1.75:1.
+*/
+class TopologyTests : public juce::UnitTest
+{
+public:
+
+    TopologyTests() : juce::UnitTest("Topology", "Kcomp") {}
+
+    void runTest() override
+    {
+        beginTest("Effective ratios");
+
+        const auto feedForward = getEffectiveRatio(0, 0.5f, false);
+        const auto feedback = getEffectiveRatio(1, 0.5f, false);
+        const auto hybrid = getEffectiveRatio(2, 0.5f, false);
+        logMessage("feed-forward " + juce::String(feedForward, 3) + ":1, feedback " + juce::String(feedback, 3) + ":1, hybrid "
+                   + juce::String(hybrid, 3) + ":1");
+
+        expectWithinAbsoluteError(feedForward, 4.0, 0.01, "feed-forward");
+        expectWithinAbsoluteError(feedback, 2.0 - 1.0 / 4.0, 0.02, "feedback");
+        expectGreaterThan(hybrid, feedback, "hybrid above feedback");
+        expectLessThan(hybrid, feedForward, "hybrid below feed-forward");
+
+        beginTest("The hybrid mix ends are the two topologies");
+        expectWithinAbsoluteError(getEffectiveRatio(2, 0.0f, false), feedForward, 0.01, "mix 0");
+        expectWithinAbsoluteError(getEffectiveRatio(2, 1.0f, false), feedback, 0.01, "mix 1");
+
+        beginTest("A sidechain runs feed-forward");
+        expectWithinAbsoluteError(getEffectiveRatio(1, 0.5f, true), feedForward, 0.01, "feedback with a key");
+    }
+
+private:
+
+    static constexpr float thresholdDb = -30.0f;
+
+    //Where the output settles on DC at levelDb, with the input as its own key if useKey is set
+    static double getOutputDb(int topology, float feedbackMix, bool useKey, float levelDb)
+    {
+        KcompEngine<float>::Parameters params;
+        params.thresholdDb = thresholdDb;
+        params.topology = topology;
+        params.feedbackMix = feedbackMix;
+
+        KcompEngine<float> engine;
+        prepareEngine(engine, params, 2);
+
+        constexpr int numSamples = 24000;
+        juce::AudioBuffer<float> block(2, blockSize), key(2, blockSize);
+        for (int start = 0; start < numSamples; start += blockSize)
+        {
+            for (int channel = 0; channel < 2; ++channel)
+            {
+                juce::FloatVectorOperations::fill(block.getWritePointer(channel), juce::Decibels::decibelsToGain(levelDb), blockSize);
+            }
+            key.makeCopyOf(block);
+
+            engine.process(block, useKey ? juce::dsp::AudioBlock<const float>(key) : juce::dsp::AudioBlock<const float>());
+        }
+
+        return juce::Decibels::gainToDecibels(double(block.getSample(0, blockSize - 1)));
+    }
+
+    //Input change over output change between 10 and 30 dB over the threshold
+    static double getEffectiveRatio(int topology, float feedbackMix, bool useKey)
+    {
+        const auto low = getOutputDb(topology, feedbackMix, useKey, thresholdDb + 10.0f);
+        const auto high = getOutputDb(topology, feedbackMix, useKey, thresholdDb + 30.0f);
+        return 20.0 / (high - low);
+    }
+};
+
+static TopologyTests topologyTests;
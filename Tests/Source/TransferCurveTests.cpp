@@ -0,0 +1,153 @@
+#include <JuceHeader.h>
+#include "KcompTestHelpers.h"
+
+using namespace KcompTestHelpers;
+
+//==============================================================================
+class TransferCurveTests : public juce::UnitTest
+{
+public:
+
+    TransferCurveTests() : juce::UnitTest("Transfer curve", "Kcomp") {}
+
+    void runTest() override
+    {
+        testShape();
+        testTable();
+        testStaticLevel();
+        testCurveChange();
+    }
+
+private:
+
+    using Curve = KcompTransferCurve<float>;
+
+    //Gain in dB for an overshoot in dB
+    static double getGainDb(const Curve::Settings& settings, double overshootDb)
+    {
+        return Curve::computeGain(settings, float(overshootDb * KcompMath::decibelsToLog2)) * KcompMath::log2ToDecibels;
+    }
+
+    void testShape()
+    {
+        beginTest("Hard knee, soft knee and upper stage");
+
+        Curve::Settings settings;
+        settings.ratio = 4.0f;
+
+        for (auto overshootDb : { -10.0, -0.1, 0.0, 0.1, 10.0, 40.0 })
+        {
+            expectWithinAbsoluteError(getGainDb(settings, overshootDb), juce::jmax(0.0, overshootDb) * (1.0 / 4.0 - 1.0), 1.0e-4,
+                                      "hard knee at " + juce::String(overshootDb) + " dB");
+        }
+
+        //the knee is W wide around the threshold, at the threshold itself the gain is (1 / ratio - 1) * W / 8
+        settings.kneeDb = 12.0f;
+        expectWithinAbsoluteError(getGainDb(settings, 0.0), (1.0 / 4.0 - 1.0) * 12.0 / 8.0, 1.0e-4, "middle of the knee");
+        expectEquals(getGainDb(settings, -6.01), 0.0, "below the knee");
+        expectWithinAbsoluteError(getGainDb(settings, 6.01), 6.01 * (1.0 / 4.0 - 1.0), 1.0e-4, "above the knee");
+
+        //a ratio of 20 from 12 dB over on, the gain has slope 1 / 20 - 1 up there
+        settings.kneeDb = 0.0f;
+        settings.upperStage = true;
+        settings.upperThresholdDb = 12.0f;
+        settings.upperRatio = 20.0f;
+        expectWithinAbsoluteError(getGainDb(settings, 12.0), 12.0 * (1.0 / 4.0 - 1.0), 1.0e-4, "at the upper threshold");
+        expectWithinAbsoluteError(getGainDb(settings, 30.0) - getGainDb(settings, 20.0), 10.0 * (1.0 / 20.0 - 1.0), 1.0e-3, "upper slope");
+    }
+
+    //What the audio thread reads against the curve it samples, every 0.01 dB from -12 to +96 dB over
+    void testTable()
+    {
+        beginTest("Table reads match the curve");
+
+        for (auto kneeDb : { 0.0f, 6.0f, 24.0f })
+        {
+            Curve::Settings settings;
+            settings.ratio = 6.0f;
+            settings.kneeDb = kneeDb;
+            settings.upperStage = true;
+
+            Curve curve;
+            curve.publish(settings);
+            curve.acquire(1.0f);
+
+            const float* tables[Curve::lanes];
+            std::fill(std::begin(tables), std::end(tables), curve.getTable());
+
+            auto worst = 0.0;
+            for (int step = -1200; step <= 9600; ++step)
+            {
+                const auto overshootDb = step * 0.01;
+                const auto overshoot = float(overshootDb * KcompMath::decibelsToLog2);
+
+                float gains[Curve::lanes];
+                KcompSIMD::store(gains, Curve::lookup(tables, Curve::Vec::expand(overshoot)));
+                worst = juce::jmax(worst, std::abs(gains[0] * KcompMath::log2ToDecibels - getGainDb(settings, overshootDb)));
+            }
+            expectLessOrEqual(worst, 0.01, "knee " + juce::String(kneeDb) + " dB");
+        }
+    }
+
+    //DC sits still in the peak detector, so the output is the curve itself: 10 dB over at 4:1 comes out 2.5 dB over
+    void testStaticLevel()
+    {
+        beginTest("Static output level");
+
+        for (auto ratio : { 2.0f, 4.0f, 10.0f })
+        {
+            KcompEngine<float>::Parameters params;
+            params.thresholdDb = -20.0f;
+
+            KcompEngine<float> engine;
+            prepareEngine(engine, params, 2, ratio);
+
+            const auto input = makeSignal<float>(2, 24000, [](int, int) { return juce::Decibels::decibelsToGain(-10.0f); });
+            const auto output = process(engine, input);
+            expectWithinAbsoluteError(juce::Decibels::gainToDecibels(double(output.getSample(0, 23999))), -20.0 + 10.0 / ratio, 0.01,
+                                      juce::String(ratio) + ":1");
+        }
+    }
+
+    //A new curve fades in over the parameter ramp instead of stepping the gain
+    void testCurveChange()
+    {
+        beginTest("A new curve crossfades in");
+
+        KcompEngine<float>::Parameters params;
+        params.thresholdDb = -20.0f;
+
+        KcompEngine<float> engine;
+        prepareEngine(engine, params, 2, 2.0f);
+
+        constexpr int changeBlock = 40;
+        const auto input = makeSignal<float>(2, 80 * blockSize, [](int, int) { return juce::Decibels::decibelsToGain(-10.0f); });
+        const auto output = process(engine, input, [&engine](int block)
+        {
+            if (block == changeBlock)
+            {
+                KcompTransferCurve<float>::Settings curve;
+                curve.ratio = 8.0f;
+                for (int band = 0; band < KcompEngine<float>::maxBands; ++band)
+                {
+                    engine.setTransferCurve(band, curve);
+                }
+            }
+        });
+
+        const auto rampSamples = KcompEngine<float>::rampLengthSeconds * sampleRate;
+        const auto before = double(output.getSample(0, changeBlock * blockSize - 1));
+        const auto after = double(output.getSample(0, output.getNumSamples() - 1));
+
+        auto largestStep = 0.0;
+        for (int i = changeBlock * blockSize; i < output.getNumSamples(); ++i)
+        {
+            largestStep = juce::jmax(largestStep, std::abs(double(output.getSample(0, i)) - double(output.getSample(0, i - 1))));
+        }
+
+        expectWithinAbsoluteError(juce::Decibels::gainToDecibels(after), -20.0 + 10.0 / 8.0, 0.01, "new curve");
+        expectLessOrEqual(largestStep, 1.5 * std::abs(after - before) / rampSamples, "no step");
+    }
+};
+
+static TransferCurveTests transferCurveTests;
@@ -0,0 +1,386 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "KcompSIMD.h"
+#include "KcompMath.h"
+#include "KcompTransferCurve.h"
+
+//==============================================================================
+/*
+    Compressor core that runs all channels side by side in one SIMDRegister,
+    one channel per lane. The ballistics are the same as juce::dsp::Compressor
+    (peak BallisticsFilter + hard-knee gain computer), but the gain computer
+    works in the log2 domain with KcompMath's fine log2/exp2 instead of a
+    std::pow per sample and channel.
+
+    In linked mode every lane is fed the loudest channel, so all channels share
+    one envelope and get the same gain.
+
+    process() keeps the dsp::ProcessorChain interface. KcompEngine uses
+    getFrameParameters()/processLevel() directly inside its own loop, with
+    the fixed slope replaced by a KcompTransferCurve frame wherever the
+    ratio and knee come from the plugin controls.
+
+    processLevelAuto() is the program-dependent version. It tracks the crest
+    factor (peak over RMS of the level, about 200 ms) and how many times a
+    second the level jumps 6 dB over the envelope. Attack and release are
+    scaled by 2 / crest^2, so they match the knobs on a sine and get faster
+    on spiky material, and the release slows down again as the onsets get
+    denser. A slow stage follows the envelope at slowReleaseScale times the
+    release and the gain follows whichever is higher, so short peaks recover
+    fast and long stretches of compression let go slowly. It's branchless:
+    two divisions and two exp2 a frame on top of processLevel().
+*/
+template <typename SampleType>
+class KcompCompressor
+{
+public:
+
+    using Vec = KcompSIMD::Register<SampleType>;
+    using Curve = typename KcompTransferCurve<SampleType>::Frame;
+    static constexpr int lanes = int(Vec::SIMDNumElements);
+
+    static constexpr double slowReleaseScale = 8.0;
+    static constexpr double crestMs = 200.0;
+    static constexpr double onsetRateSeconds = 1.0;
+
+    //The detector coefficients as plain values, for packing different settings into the lanes.
+    //autoAttack/autoRelease are the log2 of the auto mode coefficients at crest^2 = 1.
+    struct Coefficients
+    {
+        SampleType cteAttack, cteRelease;
+        SampleType slope;
+        SampleType autoAttack, autoRelease, cteSlow;
+    };
+
+    //Per-sub-block constants, expanded once so the per-sample code only does register maths
+    struct FrameParameters
+    {
+        Vec cteAttack, cteRelease;
+        Vec slope;
+        Vec autoAttack, autoRelease, cteSlow;
+    };
+
+    //Auto mode constants that only depend on the sample rate
+    struct AutoConstants
+    {
+        Vec cteCrest, cteOnsetRate, onsetWeight;
+    };
+
+    //Auto mode detector state, one lane per channel (or band)
+    struct AutoState
+    {
+        Vec slowEnv;
+        Vec peakSquare, meanSquare;
+        Vec onsetRate, wasAbove;
+    };
+
+    //Threshold in the log2 domain the gain computer works in
+    static SampleType thresholdToLog2(SampleType thresholdDb) noexcept
+    {
+        return thresholdDb * static_cast<SampleType>(KcompMath::decibelsToLog2);
+    }
+
+    //==============================================================================
+    void setThreshold(SampleType newThresholdDb)
+    {
+        thresholdDb = newThresholdDb;
+    }
+
+    void setRatio(SampleType newRatio)
+    {
+        jassert(newRatio >= static_cast<SampleType>(1.0));
+        if (ratio != newRatio)
+        {
+            ratio = newRatio;
+            update();
+        }
+    }
+
+    void setAttack(SampleType newAttackMs)
+    {
+        if (attackTime != newAttackMs)
+        {
+            attackTime = newAttackMs;
+            update();
+        }
+    }
+
+    void setRelease(SampleType newReleaseMs)
+    {
+        if (releaseTime != newReleaseMs)
+        {
+            releaseTime = newReleaseMs;
+            update();
+        }
+    }
+
+    //Lets the detector run at an oversampled rate without going through prepare() again
+    void setSampleRate(double newSampleRate)
+    {
+        if (sampleRate != newSampleRate)
+        {
+            sampleRate = newSampleRate;
+            update();
+        }
+    }
+
+    void setLinked(bool shouldBeLinked)     { linked = shouldBeLinked; }
+    bool isLinked() const noexcept          { return linked; }
+
+    //==============================================================================
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        jassert(spec.sampleRate > 0);
+        jassert(spec.numChannels > 0);
+
+        sampleRate = spec.sampleRate;
+        numChannels = int(spec.numChannels);
+        numGroups = (numChannels + lanes - 1) / lanes;
+        envelopes.assign(size_t(numGroups * lanes), SampleType());
+        autoStates.assign(size_t(numGroups * autoStateSize), SampleType());
+
+        update();
+        reset();
+    }
+
+    void reset()
+    {
+        std::fill(envelopes.begin(), envelopes.end(), SampleType());
+        std::fill(autoStates.begin(), autoStates.end(), SampleType());
+    }
+
+    void resetAutoStates()
+    {
+        std::fill(autoStates.begin(), autoStates.end(), SampleType());
+    }
+
+    template <typename ProcessContext>
+    void process(const ProcessContext& context) noexcept
+    {
+        const auto& inputBlock = context.getInputBlock();
+        auto& outputBlock = context.getOutputBlock();
+        const auto numBlockChannels = juce::jmin(int(outputBlock.getNumChannels()), numChannels);
+        const auto numSamples = outputBlock.getNumSamples();
+
+        jassert(inputBlock.getNumChannels() == outputBlock.getNumChannels());
+        jassert(inputBlock.getNumSamples() == numSamples);
+
+        if (context.isBypassed)
+        {
+            outputBlock.copyFrom(inputBlock);
+            return;
+        }
+
+        const auto params = getFrameParameters();
+        const auto log2Threshold = Vec::expand(thresholdToLog2(thresholdDb));
+
+        for (size_t start = 0; start < numSamples; start += size_t(chunkSize))
+        {
+            const auto num = juce::jmin(size_t(chunkSize), numSamples - start);
+
+            //every group's linked level is read before the first group writes, the block may be processed in place
+            if (linked)
+            {
+                for (size_t i = 0; i < num; ++i)
+                {
+                    linkedLevels[i] = getLinkedLevel(inputBlock, start + i, numBlockChannels);
+                }
+            }
+
+            for (int group = 0; group < numGroups; ++group)
+            {
+                const auto firstChannel = group * lanes;
+                const auto groupChannels = juce::jmin(lanes, numBlockChannels - firstChannel);
+
+                //whole frames first: a frame put together lane by lane and loaded straight away
+                //can't be forwarded from the stores, so the load would wait for everything before it to retire
+                for (int lane = 0; lane < lanes; ++lane)
+                {
+                    const auto* input = lane < groupChannels ? inputBlock.getChannelPointer(size_t(firstChannel + lane)) + start : nullptr;
+                    for (size_t i = 0; i < num; ++i)
+                    {
+                        frames[i * lanes + size_t(lane)] = input != nullptr ? input[i] : SampleType();
+                    }
+                }
+
+                auto env = getEnvelope(group);
+                for (size_t i = 0; i < num; ++i)
+                {
+                    auto* frame = frames + i * lanes;
+                    const auto x = KcompSIMD::load(frame);
+                    const auto level = linked ? Vec::expand(linkedLevels[i]) : KcompSIMD::abs(x);
+
+                    KcompSIMD::store(frame, x * processLevel(level, env, log2Threshold, params));
+                }
+                setEnvelope(group, env);
+
+                for (int lane = 0; lane < groupChannels; ++lane)
+                {
+                    auto* output = outputBlock.getChannelPointer(size_t(firstChannel + lane)) + start;
+                    for (size_t i = 0; i < num; ++i)
+                    {
+                        output[i] = frames[i * lanes + size_t(lane)];
+                    }
+                }
+            }
+        }
+    }
+
+    //==============================================================================
+    FrameParameters getFrameParameters() const noexcept
+    {
+        return { Vec::expand(cteAttack), Vec::expand(cteRelease), Vec::expand(slope),
+                 Vec::expand(autoAttack), Vec::expand(autoRelease), Vec::expand(cteSlow) };
+    }
+
+    Coefficients getCoefficients() const noexcept
+    {
+        return { cteAttack, cteRelease, slope, autoAttack, autoRelease, cteSlow };
+    }
+
+    AutoConstants getAutoConstants() const noexcept
+    {
+        return { Vec::expand(cteCrest), Vec::expand(cteOnsetRate), Vec::expand(onsetWeight) };
+    }
+
+    Vec getEnvelope(int group) const noexcept               { return KcompSIMD::load(envelopes.data() + group * lanes); }
+    void setEnvelope(int group, Vec env) noexcept           { KcompSIMD::store(envelopes.data() + group * lanes, env); }
+
+    AutoState getAutoState(int group) const noexcept        { return loadAutoState(autoStates.data() + group * autoStateSize); }
+    void setAutoState(int group, const AutoState& state)    { storeAutoState(autoStates.data() + group * autoStateSize, state); }
+
+    //AutoState as five registers of plain values, for callers that keep their own
+    static constexpr int autoStateSize = 5 * lanes;
+
+    static AutoState loadAutoState(const SampleType* source) noexcept
+    {
+        return { KcompSIMD::load(source),
+                 KcompSIMD::load(source + lanes), KcompSIMD::load(source + 2 * lanes),
+                 KcompSIMD::load(source + 3 * lanes), KcompSIMD::load(source + 4 * lanes) };
+    }
+
+    static void storeAutoState(SampleType* destination, const AutoState& state) noexcept
+    {
+        KcompSIMD::store(destination, state.slowEnv);
+        KcompSIMD::store(destination + lanes, state.peakSquare);
+        KcompSIMD::store(destination + 2 * lanes, state.meanSquare);
+        KcompSIMD::store(destination + 3 * lanes, state.onsetRate);
+        KcompSIMD::store(destination + 4 * lanes, state.wasAbove);
+    }
+
+    //Runs the detector on one frame of rectified levels and returns the gain for each lane.
+    //The threshold is passed per frame so it can be smoothed sample by sample.
+    static forcedinline Vec processLevel(Vec level, Vec& env, Vec log2Threshold, const FrameParameters& params) noexcept
+    {
+        followLevel(level, env, params);
+
+        //below the threshold the overshoot clamps to 0, so the gain is exactly unity
+        const auto overshoot = Vec::max(KcompMath::log2<gainAccuracy>(env) - log2Threshold, Vec::expand(SampleType()));
+        return KcompMath::exp2<gainAccuracy>(params.slope * overshoot);
+    }
+
+    //Same detector with the gain read from a transfer curve, fade is how far the curve's crossfade has got
+    static forcedinline Vec processLevel(Vec level, Vec& env, Vec log2Threshold, const FrameParameters& params,
+                                         const Curve& curve, Vec fade) noexcept
+    {
+        followLevel(level, env, params);
+        return KcompMath::exp2<gainAccuracy>(curve.getGain(KcompMath::log2<gainAccuracy>(env) - log2Threshold, fade));
+    }
+
+    //Program-dependent attack and a two-stage release, env is the fast stage
+    static forcedinline Vec processLevelAuto(Vec level, Vec& env, AutoState& state, Vec log2Threshold, const FrameParameters& params,
+                                             const AutoConstants& constants, const Curve& curve, Vec fade) noexcept
+    {
+        const auto zero = Vec::expand(SampleType());
+        const auto one = Vec::expand(static_cast<SampleType>(1.0));
+
+        //crest factor: peak and mean of the squared level on the same time constant
+        const auto square = level * level;
+        state.peakSquare = Vec::max(square, state.peakSquare * constants.cteCrest);
+        state.meanSquare = square + constants.cteCrest * (state.meanSquare - square);
+        const auto crestSquared = Vec::min(Vec::max(KcompSIMD::divide(state.peakSquare, Vec::max(state.meanSquare, Vec::expand(minMeanSquare))), one),
+                                           Vec::expand(maxCrestSquared));
+
+        //onsets per second: the level going from under to over twice the envelope
+        const auto above = KcompSIMD::select<SampleType>(Vec::greaterThan(level, env + env), one, zero);
+        state.onsetRate = state.onsetRate * constants.cteOnsetRate + (above - above * state.wasAbove) * constants.onsetWeight;
+        state.wasAbove = above;
+
+        const auto cteAttack = KcompMath::exp2<gainAccuracy>(params.autoAttack * crestSquared);
+        const auto cteRelease = KcompMath::exp2<gainAccuracy>(KcompSIMD::divide(params.autoRelease * crestSquared, one + state.onsetRate * Vec::expand(onsetReleaseScale)));
+
+        const auto cte = KcompSIMD::select<SampleType>(Vec::greaterThan(level, env), cteAttack, cteRelease);
+        env = level + cte * (env - level);
+        state.slowEnv = env + params.cteSlow * (state.slowEnv - env);
+
+        return KcompMath::exp2<gainAccuracy>(curve.getGain(KcompMath::log2<gainAccuracy>(Vec::max(env, state.slowEnv)) - log2Threshold, fade));
+    }
+
+private:
+
+    static constexpr auto gainAccuracy = KcompMath::Accuracy::fine;
+
+    static constexpr SampleType maxCrestSquared = 64;           //18 dB, attack and release at most 32x faster than set
+    static constexpr SampleType minMeanSquare = SampleType(1.0e-12);
+    static constexpr SampleType onsetReleaseScale = SampleType(0.25);  //4 onsets a second double the release
+
+
+    static forcedinline void followLevel(Vec level, Vec& env, const FrameParameters& params) noexcept
+    {
+        const auto cte = KcompSIMD::select<SampleType>(Vec::greaterThan(level, env), params.cteAttack, params.cteRelease);
+        env = level + cte * (env - level);
+    }
+
+    template <typename BlockType>
+    static SampleType getLinkedLevel(const BlockType& block, size_t index, int numBlockChannels) noexcept
+    {
+        SampleType level{};
+        for (int channel = 0; channel < numBlockChannels; ++channel)
+        {
+            level = juce::jmax(level, std::abs(block.getChannelPointer(size_t(channel))[index]));
+        }
+        return level;
+    }
+
+    void update()
+    {
+        const auto expFactor = -2.0 * juce::MathConstants<double>::pi * 1000.0 / sampleRate;
+        cteAttack = attackTime < static_cast<SampleType>(1.0e-3) ? SampleType() : static_cast<SampleType>(std::exp(expFactor / attackTime));
+        cteRelease = releaseTime < static_cast<SampleType>(1.0e-3) ? SampleType() : static_cast<SampleType>(std::exp(expFactor / releaseTime));
+
+        slope = static_cast<SampleType>(1.0) / ratio - static_cast<SampleType>(1.0);
+
+        //auto: exp2(autoAttack * crest^2) is cteAttack for a sine (crest^2 = 2), 2^-126 clamps to 0
+        const auto log2Factor = -juce::MathConstants<double>::pi * 1000.0 / (sampleRate * std::log(2.0));
+        autoAttack = attackTime < static_cast<SampleType>(1.0e-3) ? static_cast<SampleType>(-126.0) : static_cast<SampleType>(log2Factor / attackTime);
+        autoRelease = releaseTime < static_cast<SampleType>(1.0e-3) ? static_cast<SampleType>(-126.0) : static_cast<SampleType>(log2Factor / releaseTime);
+        cteSlow = releaseTime < static_cast<SampleType>(1.0e-3) ? SampleType() : static_cast<SampleType>(std::exp(expFactor / (releaseTime * slowReleaseScale)));
+
+        cteCrest = static_cast<SampleType>(std::exp(-1000.0 / (crestMs * sampleRate)));
+        cteOnsetRate = static_cast<SampleType>(std::exp(-1.0 / (onsetRateSeconds * sampleRate)));
+        onsetWeight = static_cast<SampleType>((1.0 - std::exp(-1.0 / (onsetRateSeconds * sampleRate))) * sampleRate);
+    }
+
+    double sampleRate{ 44100.0 };
+    int numChannels{ 0 };
+    int numGroups{ 0 };
+
+    SampleType thresholdDb{ 0 }, ratio{ 1 };
+    SampleType attackTime{ 1 }, releaseTime{ 100 };
+    bool linked{ false };
+
+    SampleType cteAttack{}, cteRelease{};
+    SampleType slope{ 0 };
+    SampleType autoAttack{}, autoRelease{}, cteSlow{};
+    SampleType cteCrest{}, cteOnsetRate{}, onsetWeight{};
+
+    std::vector<SampleType> envelopes, autoStates;
+
+    //process() works through the block in chunks of interleaved frames
+    static constexpr int chunkSize = 64;
+    SampleType frames[chunkSize * lanes]{};
+    SampleType linkedLevels[chunkSize]{};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(KcompCompressor)
+};
@@ -0,0 +1,216 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "KcompSIMD.h"
+
+//==============================================================================
+/*
+    Up to 4-band Linkwitz-Riley (24 dB/oct) crossover, channels in SIMD lanes.
+
+    Same TPT structure as juce::dsp::LinkwitzRileyFilter, split as a tree:
+    the highs of each split go into the next one, and the lower bands get
+    allpasses at the higher crossovers so all bands stay in phase and sum
+    back flat.
+
+    The filter state is loaded into a State for a pass over a channel group
+    and stored back afterwards, like the rest of KcompEngine.
+*/
+template <typename SampleType>
+class KcompCrossover
+{
+public:
+
+    using Vec = KcompSIMD::Register<SampleType>;
+    static constexpr int lanes = int(Vec::SIMDNumElements);
+
+    static constexpr int maxBands = 4;
+    static constexpr int maxSplits = maxBands - 1;
+
+    struct State
+    {
+        Vec split[maxSplits][4];
+
+        //[0] band 1 at the 2nd crossover, [1] band 1 at the 3rd, [2] band 2 at the 3rd
+        Vec allpass[maxSplits][2];
+    };
+
+    static constexpr int stateSize = (maxSplits * 4 + maxSplits * 2) * lanes;
+
+    void prepare(int newNumGroups)
+    {
+        numGroups = newNumGroups;
+        states.assign(size_t(numGroups * stateSize), SampleType());
+        reset();
+    }
+
+    void reset()
+    {
+        std::fill(states.begin(), states.end(), SampleType());
+    }
+
+    void setSampleRate(double newSampleRate)
+    {
+        if (sampleRate != newSampleRate)
+        {
+            sampleRate = newSampleRate;
+            update();
+        }
+    }
+
+    //Changing the band count starts the filters from silence
+    void setNumBands(int newNumBands)
+    {
+        newNumBands = juce::jlimit(1, maxBands, newNumBands);
+        if (newNumBands != numBands)
+        {
+            numBands = newNumBands;
+            reset();
+        }
+    }
+
+    int getNumBands() const noexcept        { return numBands; }
+
+    void setCrossoverFrequency(int index, SampleType newFrequency)
+    {
+        jassert(juce::isPositiveAndBelow(index, maxSplits));
+        if (frequencies[index] != newFrequency)
+        {
+            frequencies[index] = newFrequency;
+            update();
+        }
+    }
+
+    State load(int group) const noexcept
+    {
+        State state;
+        auto* source = states.data() + size_t(group * stateSize);
+        forEachRegister(state, [&](Vec& v) { v = KcompSIMD::load(source); source += lanes; });
+        return state;
+    }
+
+    void store(int group, State state) noexcept
+    {
+        auto* destination = states.data() + size_t(group * stateSize);
+        forEachRegister(state, [&](Vec& v) { KcompSIMD::store(destination, v); destination += lanes; });
+    }
+
+    //Splits one frame into numBands frames, lowest band first
+    forcedinline void process(State& state, Vec x, Vec* bands) const noexcept
+    {
+        if (numBands == 1)
+        {
+            bands[0] = x;
+            return;
+        }
+
+        Vec rest;
+        split(state.split[0], 0, x, bands[0], rest);
+
+        if (numBands == 2)
+        {
+            bands[1] = rest;
+            return;
+        }
+
+        split(state.split[1], 1, rest, bands[1], rest);
+        bands[0] = allpass(state.allpass[0], 1, bands[0]);
+
+        if (numBands == 3)
+        {
+            bands[2] = rest;
+            return;
+        }
+
+        split(state.split[2], 2, rest, bands[2], bands[3]);
+        bands[0] = allpass(state.allpass[1], 2, bands[0]);
+        bands[1] = allpass(state.allpass[2], 2, bands[1]);
+    }
+
+private:
+
+    static constexpr SampleType R2 = static_cast<SampleType>(1.4142135623730951);
+
+    template <typename Function>
+    static void forEachRegister(State& state, Function&& function) noexcept
+    {
+        for (auto& registers : state.split)
+        {
+            for (auto& v : registers)
+            {
+                function(v);
+            }
+        }
+        for (auto& registers : state.allpass)
+        {
+            for (auto& v : registers)
+            {
+                function(v);
+            }
+        }
+    }
+
+    forcedinline void split(Vec* s, int index, Vec x, Vec& low, Vec& high) const noexcept
+    {
+        const auto g = Vec::expand(gs[index]);
+        const auto h = Vec::expand(hs[index]);
+        const auto r2 = Vec::expand(R2);
+
+        const auto yH = (x - (r2 + g) * s[0] - s[1]) * h;
+        const auto yB = g * yH + s[0];
+        s[0] = g * yH + yB;
+        const auto yL = g * yB + s[1];
+        s[1] = g * yB + yL;
+
+        const auto yH2 = (yL - (r2 + g) * s[2] - s[3]) * h;
+        const auto yB2 = g * yH2 + s[2];
+        s[2] = g * yH2 + yB2;
+        const auto yL2 = g * yB2 + s[3];
+        s[3] = g * yB2 + yL2;
+
+        low = yL2;
+        high = yL - r2 * yB + yH - yL2;
+    }
+
+    forcedinline Vec allpass(Vec* s, int index, Vec x) const noexcept
+    {
+        const auto g = Vec::expand(gs[index]);
+        const auto h = Vec::expand(hs[index]);
+        const auto r2 = Vec::expand(R2);
+
+        const auto yH = (x - (r2 + g) * s[0] - s[1]) * h;
+        const auto yB = g * yH + s[0];
+        s[0] = g * yH + yB;
+        const auto yL = g * yB + s[1];
+        s[1] = g * yB + yL;
+
+        return yL - r2 * yB + yH;
+    }
+
+    void update()
+    {
+        if (sampleRate <= 0.0)
+        {
+            return;
+        }
+
+        //the tree only splits the highs further, so a crossover can't go below the one before it
+        auto frequency = SampleType();
+        for (int index = 0; index < maxSplits; ++index)
+        {
+            frequency = juce::jlimit(juce::jmax(static_cast<SampleType>(10.0), frequency), static_cast<SampleType>(sampleRate * 0.49), frequencies[index]);
+            gs[index] = static_cast<SampleType>(std::tan(juce::MathConstants<double>::pi * frequency / sampleRate));
+            hs[index] = static_cast<SampleType>(1.0) / (static_cast<SampleType>(1.0) + R2 * gs[index] + gs[index] * gs[index]);
+        }
+    }
+
+    double sampleRate{ 0.0 };
+    int numGroups{ 0 };
+    int numBands{ 1 };
+
+    SampleType frequencies[maxSplits]{ 120, 1000, 6000 };
+    SampleType gs[maxSplits]{}, hs[maxSplits]{};
+
+    std::vector<SampleType> states;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(KcompCrossover)
+};
@@ -0,0 +1,256 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "KcompSIMD.h"
+#include "KcompTruePeak.h"
+
+//==============================================================================
+/*
+    Turns one frame of the key into detector levels, one slot per register of
+    lanes (a channel group, or the bands of one channel in multiband mode).
+
+    Peak is the rectified key. RMS is the root of the mean square over a
+    window of 1 to 300 ms: a running sum over a ring of squares, so the cost
+    per sample doesn't depend on the window. The ring holds one entry per
+    base-rate sample, so oversampling doesn't make it longer.
+
+    The running sum is compensated (Neumaier). A second sum is built next to
+    it from additions only, one entry per sample, and replaces it once it
+    covers the whole window, so a quiet passage after a loud one isn't lost
+    in float rounding. A new window length adds or takes away only the
+    entries between the old length and the new one.
+
+    True peak is KcompTruePeak on the key, the loudest of the sample and
+    its four BS.1770 interpolated points. The interpolated ones lag the key
+    by about 6 samples.
+
+    Everything is allocated in prepare() for the longest window.
+*/
+template <typename SampleType>
+class KcompDetector
+{
+public:
+
+    using Vec = KcompSIMD::Register<SampleType>;
+    static constexpr int lanes = int(Vec::SIMDNumElements);
+
+    enum class Mode
+    {
+        peak,
+        rms,
+        truePeak
+    };
+
+    static constexpr double minWindowMs = 1.0;
+    static constexpr double maxWindowMs = 300.0;
+
+    //sampleRate is the base rate, setOversamplingOrder() tells it how many detector frames make one sample
+    void prepare(int newNumSlots, double newSampleRate)
+    {
+        numSlots = newNumSlots;
+        sampleRate = newSampleRate;
+        capacity = juce::jmax(1, int(std::ceil(maxWindowMs * 0.001 * sampleRate)));
+
+        squares.assign(size_t(numSlots * capacity * lanes), SampleType());
+        sums.assign(size_t(numSlots * lanes), SampleType());
+        compensations.assign(size_t(numSlots * lanes), SampleType());
+        pending.assign(size_t(numSlots * lanes), SampleType());
+        freshSums.assign(size_t(numSlots * lanes), SampleType());
+        freshCompensations.assign(size_t(numSlots * lanes), SampleType());
+        writePositions.assign(size_t(numSlots), 0);
+        pendingCounts.assign(size_t(numSlots), 0);
+        freshCounts.assign(size_t(numSlots), 0);
+
+        truePeak.prepare(numSlots);
+
+        length = juce::jlimit(1, capacity, juce::roundToInt(windowMs * 0.001 * sampleRate));
+        updateScale();
+        reset();
+    }
+
+    void reset()
+    {
+        std::fill(squares.begin(), squares.end(), SampleType());
+        std::fill(sums.begin(), sums.end(), SampleType());
+        std::fill(compensations.begin(), compensations.end(), SampleType());
+        std::fill(pending.begin(), pending.end(), SampleType());
+        std::fill(freshSums.begin(), freshSums.end(), SampleType());
+        std::fill(freshCompensations.begin(), freshCompensations.end(), SampleType());
+        std::fill(writePositions.begin(), writePositions.end(), 0);
+        std::fill(pendingCounts.begin(), pendingCounts.end(), 0);
+        std::fill(freshCounts.begin(), freshCounts.end(), 0);
+        truePeak.reset();
+    }
+
+    //The rings only fill in their own mode, so switching starts them over
+    void setMode(Mode newMode)
+    {
+        if (newMode != mode)
+        {
+            mode = newMode;
+            reset();
+        }
+    }
+
+    Mode getMode() const noexcept       { return mode; }
+
+    //The ring keeps the last maxWindowMs, so a new window only adds or takes away the entries it gained or lost
+    void setWindow(SampleType newWindowMs)
+    {
+        windowMs = juce::jlimit(static_cast<SampleType>(minWindowMs), static_cast<SampleType>(maxWindowMs), newWindowMs);
+        const auto newLength = juce::jlimit(1, capacity, juce::roundToInt(windowMs * 0.001 * sampleRate));
+
+        if (newLength != length)
+        {
+            if (mode == Mode::rms)
+            {
+                for (int slot = 0; slot < numSlots; ++slot)
+                {
+                    resizeWindow(slot, newLength);
+                }
+            }
+
+            length = newLength;
+            updateScale();
+        }
+    }
+
+    void setOversamplingOrder(int newOrder)
+    {
+        if ((1 << newOrder) != framesPerSample)
+        {
+            framesPerSample = 1 << newOrder;
+            updateScale();
+            reset();
+        }
+    }
+
+    forcedinline Vec process(int slot, Vec key) noexcept
+    {
+        switch (mode)
+        {
+            case Mode::rms:         return processRMS(slot, key);
+            case Mode::truePeak:    return truePeak.process(slot, key);
+            case Mode::peak:
+            default:                return KcompSIMD::abs(key);
+        }
+    }
+
+private:
+
+    forcedinline Vec processRMS(int slot, Vec key) noexcept
+    {
+        auto* slotPending = pending.data() + size_t(slot * lanes);
+        auto* slotSum = sums.data() + size_t(slot * lanes);
+        auto* slotCompensation = compensations.data() + size_t(slot * lanes);
+
+        auto square = KcompSIMD::load(slotPending) + key * key;
+        auto sum = KcompSIMD::load(slotSum);
+        auto compensation = KcompSIMD::load(slotCompensation);
+
+        //a whole base-rate sample has come in, it replaces the one that just left the window
+        auto& count = pendingCounts[size_t(slot)];
+        if (++count == framesPerSample)
+        {
+            auto& writePos = writePositions[size_t(slot)];
+            auto* ring = squares.data() + size_t(slot * capacity * lanes);
+            const auto readPos = writePos >= length ? writePos - length : writePos - length + capacity;
+
+            addCompensated(sum, compensation, square - KcompSIMD::load(ring + readPos * lanes));
+            KcompSIMD::store(ring + writePos * lanes, square);
+            KcompSIMD::store(slotSum, sum);
+            KcompSIMD::store(slotCompensation, compensation);
+
+            writePos = writePos + 1 < capacity ? writePos + 1 : 0;
+
+            //the fresh sum has only ever added, once it spans the window it takes over from the running one
+            auto* slotFreshSum = freshSums.data() + size_t(slot * lanes);
+            auto* slotFreshCompensation = freshCompensations.data() + size_t(slot * lanes);
+            auto freshSum = KcompSIMD::load(slotFreshSum);
+            auto freshCompensation = KcompSIMD::load(slotFreshCompensation);
+            addCompensated(freshSum, freshCompensation, square);
+
+            auto& freshCount = freshCounts[size_t(slot)];
+            if (++freshCount == length)
+            {
+                sum = freshSum;
+                compensation = freshCompensation;
+                KcompSIMD::store(slotSum, sum);
+                KcompSIMD::store(slotCompensation, compensation);
+                freshSum = Vec::expand(SampleType());
+                freshCompensation = Vec::expand(SampleType());
+                freshCount = 0;
+            }
+
+            KcompSIMD::store(slotFreshSum, freshSum);
+            KcompSIMD::store(slotFreshCompensation, freshCompensation);
+
+            square = Vec::expand(SampleType());
+            count = 0;
+        }
+
+        KcompSIMD::store(slotPending, square);
+        return KcompSIMD::sqrt(Vec::max(sum + compensation, Vec::expand(SampleType())) * Vec::expand(scale));
+    }
+
+    //Neumaier: compensation collects what each addition rounds away, from whichever side was smaller
+    static forcedinline void addCompensated(Vec& sum, Vec& compensation, Vec value) noexcept
+    {
+        const auto newSum = sum + value;
+        const auto sumIsBigger = Vec::greaterThan(KcompSIMD::abs(sum), KcompSIMD::abs(value));
+        compensation += (KcompSIMD::select<SampleType>(sumIsBigger, sum, value) - newSum) + KcompSIMD::select<SampleType>(sumIsBigger, value, sum);
+        sum = newSum;
+    }
+
+    //Moves the running sum from the last length entries to the last newLength. A fresh sum that already spans the
+    //new window would have to take entries away, so it starts over instead.
+    void resizeWindow(int slot, int newLength) noexcept
+    {
+        const auto* ring = squares.data() + size_t(slot * capacity * lanes);
+        const auto writePos = writePositions[size_t(slot)];
+        auto* slotSum = sums.data() + size_t(slot * lanes);
+        auto* slotCompensation = compensations.data() + size_t(slot * lanes);
+
+        auto sum = KcompSIMD::load(slotSum);
+        auto compensation = KcompSIMD::load(slotCompensation);
+        const auto grow = newLength > length;
+        for (int back = juce::jmin(length, newLength) + 1; back <= juce::jmax(length, newLength); ++back)
+        {
+            const auto readPos = writePos >= back ? writePos - back : writePos - back + capacity;
+            const auto entry = KcompSIMD::load(ring + readPos * lanes);
+            addCompensated(sum, compensation, grow ? entry : Vec::expand(SampleType()) - entry);
+        }
+        KcompSIMD::store(slotSum, sum);
+        KcompSIMD::store(slotCompensation, compensation);
+
+        if (freshCounts[size_t(slot)] >= newLength)
+        {
+            std::fill_n(freshSums.data() + size_t(slot * lanes), lanes, SampleType());
+            std::fill_n(freshCompensations.data() + size_t(slot * lanes), lanes, SampleType());
+            freshCounts[size_t(slot)] = 0;
+        }
+    }
+
+    void updateScale() noexcept
+    {
+        scale = static_cast<SampleType>(1.0 / (double(length) * framesPerSample));
+    }
+
+    int numSlots{ 0 };
+    double sampleRate{ 44100.0 };
+    Mode mode{ Mode::peak };
+
+    SampleType windowMs{ 10 };
+    int capacity{ 1 };
+    int length{ 1 };
+    int framesPerSample{ 1 };
+    SampleType scale{ 1 };
+
+    //RMS: [slot][entry] rings of squares, with the running and fresh sums and the partial entry of each slot
+    std::vector<SampleType> squares, sums, compensations, pending, freshSums, freshCompensations;
+    std::vector<int> writePositions, pendingCounts, freshCounts;
+
+    KcompTruePeak<SampleType> truePeak;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(KcompDetector)
+};
@@ -0,0 +1,2255 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "KcompSIMD.h"
+#include "KcompCompressor.h"
+#include "KcompTransferCurve.h"
+#include "KcompLookahead.h"
+#include "KcompCrossover.h"
+#include "KcompKeyFilter.h"
+#include "KcompTame.h"
+#include "KcompDetector.h"
+#include "KcompGainFifo.h"
+#include "KcompLoudness.h"
+#include "KcompLevelStats.h"
+#include "KcompTruePeak.h"
+
+//==============================================================================
+/*
+    Fused version of the Kcomp signal chain. Channels run side by side in
+    SIMD lanes, and every stage happens in one loop over each sub-block:
+
+        input gain -> Tame -> M/S encode -> key filter -> detector
+        -> gain computer (one per band in multiband mode) -> make-up
+        -> M/S decode -> dry/wet -> output gain -> meters
+
+    The key is the sidechain if there is one, the signal itself otherwise,
+    or the compressor's own output in the feedback topologies. With
+    oversampling on, the detector and gain stages run at the higher rate
+    in a pass of their own. Lookahead and oversampling add latency, the dry
+    path is delayed by getLatencySamples() to match.
+
+    Parameters come in once per block through setParameters() or
+    scheduleParameters(), and everything continuous is ramped. Ratio and
+    knee are per-band transfer curves built off the audio thread by
+    setTransferCurve() and crossfaded in. Bypass crossfades to the delayed
+    dry signal; on digital silence the engine sleeps.
+*/
+template <typename SampleType>
+class KcompEngine
+{
+public:
+
+    using Vec = KcompSIMD::Register<SampleType>;
+    static constexpr int lanes = int(Vec::SIMDNumElements);
+
+    static constexpr int subBlockSize = 32;
+    static constexpr int maxChannels = 16;
+    static constexpr double rampLengthSeconds = 0.05;
+    static constexpr double maxLookaheadMs = 20.0;
+    static constexpr int maxOversamplingOrder = 3;
+    static constexpr int maxBands = KcompCrossover<SampleType>::maxBands;
+    static constexpr int maxBandGroups = (maxBands + lanes - 1) / lanes;
+    static constexpr double tameAttackMs = 1.0;
+    static constexpr double tameReleaseMs = 60.0;
+    static constexpr double silenceDb = -120.0;
+
+    //What the detector listens to
+    enum class Topology
+    {
+        feedForward,    //the input, or the sidechain
+        feedback,       //the compressor's own output, one sample late
+        hybrid          //a blend of the two, set by feedbackMix
+    };
+
+    enum class StereoMode
+    {
+        leftRight,
+        midSide         //two channels only, anything else stays L/R
+    };
+
+    struct BandParameters
+    {
+        SampleType thresholdDb{ 0 };
+        SampleType attackMs{ 1 };
+        SampleType releaseMs{ 100 };
+    };
+
+    //Plain-value copy of the plugin parameters, taken once per block
+    struct Parameters
+    {
+        SampleType inputGain{ 1 };
+        SampleType thresholdDb{ 0 };
+        SampleType attackMs{ 1 };
+        SampleType releaseMs{ 100 };
+        bool autoTiming{ false };       //program-dependent attack and release, the times above set the scale
+        SampleType lookaheadMs{ 0 };
+        SampleType makeUpGain{ 1 };
+        SampleType dryWetMix{ 1 };
+        SampleType outputGain{ 1 };
+        int oversamplingOrder{ 0 };     //factor is 2^order
+        bool linearPhaseOversampling{ false };
+        bool tameEnabled{ false };
+        SampleType tameFrequencyHz{ 10000 };
+        int tameSlope{ 1 };             //in 12 dB/oct steps, 1 to 4
+        bool tameHighPass{ false };
+        bool tameDynamic{ false };      //only cut what Tame would remove when it goes over tameThresholdDb
+        SampleType tameThresholdDb{ 0 };
+        SampleType tameRatio{ 4 };
+        bool linked{ false };
+        SampleType linkAmount{ 1 };     //linked only, 0 is every channel on its own and 1 the loudest channel for all
+        int stereoMode{ 0 };            //see StereoMode
+
+        //multiband, only used with numBands > 1
+        int numBands{ 1 };
+        SampleType crossoverFrequencies[maxBands - 1]{ 120, 1000, 6000 };
+        BandParameters bands[maxBands];
+
+        //detector key, a cutoff of 0 switches that filter off
+        SampleType keyHighPassHz{ 0 };
+        SampleType keyLowPassHz{ 0 };
+        bool keyListen{ false };
+
+        int detectorMode{ 0 };          //0 peak, 1 RMS over rmsWindowMs, 2 true peak
+        SampleType rmsWindowMs{ 10 };
+
+        int topology{ 0 };              //see Topology
+        SampleType feedbackMix{ 0.5 };  //hybrid only, 0 is all feed-forward and 1 all feedback
+
+        bool bypassed{ false };
+    };
+
+    KcompEngine()
+    {
+        std::fill(std::begin(loudnessWeights), std::end(loudnessWeights), static_cast<SampleType>(1.0));
+    }
+
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        jassert(int(spec.numChannels) <= maxChannels);
+
+        sampleRate = spec.sampleRate;
+        numChannels = juce::jmin(int(spec.numChannels), maxChannels);
+        numGroups = (numChannels + lanes - 1) / lanes;
+        updateLinkGroups();
+
+        const auto numLanes = size_t(numGroups * lanes);
+        inputLevels.prepare(int(numLanes), (int(spec.maximumBlockSize) + subBlockSize - 1) / subBlockSize);
+        outputLevels.prepare(int(numLanes));
+        appliedGains.assign(numLanes, static_cast<SampleType>(1.0));
+        feedbackFrames.assign(numLanes, SampleType());
+
+        tame.prepare(sampleRate, numGroups);
+        inputKWeighting.prepare(sampleRate, numGroups);
+        outputKWeighting.prepare(sampleRate, numGroups);
+        truePeak.prepare(numGroups);
+        outputTruePeaks.assign(numLanes, SampleType());
+
+        for (auto* smoother : { &inputGain, &makeUpGain, &outputGain, &dryVolume, &wetVolume, &log2Threshold, &attackTime, &releaseTime, &tameLog2Threshold, &bypassMix, &feedbackMix, &linkAmount })
+        {
+            smoother->reset(sampleRate, rampLengthSeconds);
+        }
+        defaultRampSamples = int(std::floor(rampLengthSeconds * sampleRate));
+        targetRampSamples = defaultRampSamples;
+
+        //every factor and filter type is built here, so switching on the audio thread never allocates
+        auto maxOversamplingLatency = 0;
+        for (int type = 0; type < 2; ++type)
+        {
+            for (int order = 1; order <= maxOversamplingOrder; ++order)
+            {
+                auto& oversampling = oversamplers[type][order - 1];
+                oversampling.reset(new juce::dsp::Oversampling<SampleType>(size_t(juce::jmax(1, numChannels)), size_t(order),
+                                                                            type == 0 ? juce::dsp::Oversampling<SampleType>::filterHalfBandPolyphaseIIR
+                                                                                      : juce::dsp::Oversampling<SampleType>::filterHalfBandFIREquiripple,
+                                                                            true, useIntegerOversamplingLatency));
+                oversampling->initProcessing(size_t(subBlockSize));
+                oversamplingLatencies[type][order] = juce::roundToInt(oversampling->getLatencyInSamples());
+                maxOversamplingLatency = juce::jmax(maxOversamplingLatency, int(std::ceil(oversampling->getLatencyInSamples())));
+            }
+        }
+        wetScratch.setSize(maxChannels, subBlockSize);
+        levelScratch.setSize(numGroups * lanes, maxDetectorFrames);
+        bandSignalScratch.assign(size_t(numGroups * lanes * maxBandGroups * maxDetectorFrames * lanes), SampleType());
+        bandLevelScratch.assign(bandSignalScratch.size(), SampleType());
+
+        compressor.prepare(spec);
+        tameCompressor.prepare(spec);
+        tameCompressor.setAttack(static_cast<SampleType>(tameAttackMs));
+        tameCompressor.setRelease(static_cast<SampleType>(tameReleaseMs));
+        lookahead.prepare(numGroups, lookaheadMsToSamples(maxLookaheadMs) << maxOversamplingOrder);
+
+        crossover.prepare(numGroups);
+        keyCrossover.prepare(numGroups);
+        keyFilter.prepare(numGroups);
+        detector.prepare(numGroups, sampleRate);
+        bandDetector.prepare(numGroups * lanes * maxBandGroups, sampleRate);
+        bandEnvelopes.assign(size_t(numGroups * lanes * maxBandGroups * lanes), SampleType());
+        bandAutoStates.assign(size_t(numGroups * lanes * maxBandGroups * KcompCompressor<SampleType>::autoStateSize), SampleType());
+        bandFeedback.assign(bandEnvelopes.size(), SampleType());
+        bandLookahead.prepare(numGroups * lanes * maxBandGroups, lookaheadMsToSamples(maxLookaheadMs) << maxOversamplingOrder);
+        for (int band = 0; band < maxBands; ++band)
+        {
+            bandLog2Thresholds[band].reset(sampleRate, rampLengthSeconds);
+            bandAttackTimes[band].reset(sampleRate, rampLengthSeconds);
+            bandReleaseTimes[band].reset(sampleRate, rampLengthSeconds);
+            curveFades[band].reset(sampleRate, rampLengthSeconds);
+        }
+        dryDelay.prepare(numGroups, lookaheadMsToSamples(maxLookaheadMs) + maxOversamplingLatency);
+
+        updateStages(true);
+        reset();
+    }
+
+    void reset()
+    {
+        for (auto* smoother : { &inputGain, &makeUpGain, &outputGain, &dryVolume, &wetVolume, &log2Threshold, &attackTime, &releaseTime, &tameLog2Threshold, &bypassMix, &feedbackMix, &linkAmount })
+        {
+            smoother->setCurrentAndTargetValue(smoother->getTargetValue());
+        }
+
+        compressor.setAttack(attackTime.getTargetValue());
+        compressor.setRelease(releaseTime.getTargetValue());
+        dryDelay.reset();
+        inputKWeighting.reset();
+        outputKWeighting.reset();
+
+        for (int band = 0; band < maxBands; ++band)
+        {
+            for (auto* smoother : { &bandLog2Thresholds[band], &bandAttackTimes[band], &bandReleaseTimes[band] })
+            {
+                smoother->setCurrentAndTargetValue(smoother->getTargetValue());
+            }
+
+            bandCompressors[band].setAttack(bandAttackTimes[band].getTargetValue());
+            bandCompressors[band].setRelease(bandReleaseTimes[band].getTargetValue());
+
+            //starting over, so the newest curve applies straight away
+            transferCurves[band].acquire(static_cast<SampleType>(1.0));
+            curveFades[band].setCurrentAndTargetValue(static_cast<SampleType>(1.0));
+        }
+        updateMainCurve();
+
+        resetWetPath();
+        bypassHoldSamples = 0;
+        quietSamples = 0;
+        sleeping = false;
+    }
+
+    //Sorts the channels into link groups for linked mode. Call it before prepare() or from the audio thread.
+    void setChannelLayout(const juce::AudioChannelSet& layout)
+    {
+        const auto linkEverything = layout.isDiscreteLayout() || layout.getAmbisonicOrder() >= 0;
+
+        for (int channel = 0; channel < maxChannels; ++channel)
+        {
+            linkGroupOfChannel[channel] = linkEverything || channel >= layout.size() ? 0 : getLinkGroup(layout.getTypeOfChannel(channel));
+            loudnessWeights[channel] = layout.isDiscreteLayout() || channel >= layout.size()
+                                     ? static_cast<SampleType>(1.0) : KcompKWeighting<SampleType>::getChannelWeight(layout.getTypeOfChannel(channel));
+        }
+
+        updateLinkGroups();
+    }
+
+    //Builds the transfer curve of a band, 0 is also the single-band compressor. Call it from one thread at a time,
+    //not the audio thread unless it's rendering offline, the audio thread crossfades to it at its next block.
+    void setTransferCurve(int band, const typename KcompTransferCurve<SampleType>::Settings& settings) noexcept
+    {
+        jassert(juce::isPositiveAndBelow(band, maxBands));
+        transferCurves[band].publish(settings);
+    }
+
+    //Only call this from the audio thread (or before prepare), the ramps start from wherever they are now
+    void setParameters(const Parameters& newParams)
+    {
+        setSwitches(newParams);
+        setTargets(newParams, defaultRampSamples);
+
+        glideStart = newParams;
+        glideEnd = newParams;
+        gliding = false;
+    }
+
+    //Same as setParameters() for anything that switches, but the ramped parameters glide there from the last
+    //ones over the next process() call, with new targets at every sub-block. Hosts only hand over the last
+    //automation point of each block, so that's where the automation really is by the end of it, and a long
+    //block moves smoothly instead of jumping at its start. Audio thread only.
+    void scheduleParameters(const Parameters& newParams)
+    {
+        setSwitches(newParams);
+
+        //a glide the last call never got through (an empty buffer) lands where it was going first
+        if (gliding)
+        {
+            updateGlide(1, 1, defaultRampSamples);
+        }
+
+        glideStart = glideEnd;
+        glideEnd = newParams;
+
+        auto same = true;
+        forEachRampedParameter(glideStart, glideEnd, [&same](SampleType from, SampleType to) { same = same && from == to; });
+        gliding = ! same;
+
+        //the targets still depend on the switches (listen mode is all wet)
+        if (! gliding)
+        {
+            setTargets(newParams, defaultRampSamples);
+        }
+    }
+
+    //==============================================================================
+    //key is the sidechain, an empty block means the detector listens to the signal itself
+    void process(juce::AudioBuffer<SampleType>& buffer, const juce::dsp::AudioBlock<const SampleType>& key = {}) noexcept
+    {
+        const auto numBufferChannels = juce::jmin(buffer.getNumChannels(), numChannels);
+        const auto numSamples = buffer.getNumSamples();
+        auto* const* channelData = buffer.getArrayOfWritePointers();
+
+        clearMeters();
+
+        //fully bypassed: only the dry delay runs, so the output stays where the latency says it is
+        if (bypassMix.getTargetValue() > SampleType() && ! bypassMix.isSmoothing())
+        {
+            if (gliding)
+            {
+                updateGlide(numSamples, numSamples, defaultRampSamples);
+            }
+            processDryDelay(channelData, numBufferChannels, numSamples);
+            bypassedLastBlock = true;
+            return;
+        }
+
+        //the wet path sat still during the bypass, it starts over instead of playing what it held. Its delay lines
+        //are empty, so the crossfade back waits until they have refilled.
+        if (bypassedLastBlock)
+        {
+            resetWetPath();
+            bypassHoldSamples = getLatencySamples();
+            bypassedLastBlock = false;
+        }
+
+        //an awake block learns whether it was quiet from the peaks inputStage() takes anyway, the buffer is only
+        //scanned up front once the input has gone quiet
+        const auto scanned = quietSamples > 0;
+        if (scanned && updateSleep(buffer, numBufferChannels, key))
+        {
+            if (gliding)
+            {
+                updateGlide(numSamples, numSamples, defaultRampSamples);
+            }
+
+            //silence in, silence out, the loudness windows still move on
+            pushLoudness(numSamples);
+            return;
+        }
+
+        //everything on the wet side holds the other encoding, so it starts over like after a bypass
+        const auto useMidSide = stereoMode == StereoMode::midSide && numBufferChannels == 2;
+        if (useMidSide != midSide)
+        {
+            resetWetPath();
+            midSide = useMidSide;
+        }
+
+        const auto crossfading = bypassMix.isSmoothing();
+
+        const auto multiband = crossover.getNumBands() > 1;
+
+        //a link inside one register is a horizontal max, anything wider needs every channel's level first
+        const auto linkAcrossRegisters = compressor.isLinked() && numLinkGroups > 0 && ! linkFitsRegister;
+        const auto linked = compressor.isLinked() && linkFitsRegister;
+
+        //new curves crossfade in from wherever the last crossfade had got to
+        for (int band = 0; band < maxBands; ++band)
+        {
+            if (transferCurves[band].acquire(curveFades[band].getCurrentValue()))
+            {
+                curveFades[band].setCurrentAndTargetValue(SampleType());
+                curveFades[band].setTargetValue(static_cast<SampleType>(1.0));
+            }
+        }
+        updateMainCurve();
+
+        //the topology is picked once per block, each one has its own inner loops
+        switch (updateTopology(key.getNumChannels() > 0))
+        {
+            case Topology::feedback:
+                processSubBlocks<Topology::feedback>(channelData, key, numBufferChannels, numSamples, crossfading, multiband, linked, linkAcrossRegisters);
+                break;
+            case Topology::hybrid:
+                processSubBlocks<Topology::hybrid>(channelData, key, numBufferChannels, numSamples, crossfading, multiband, linked, linkAcrossRegisters);
+                break;
+            case Topology::feedForward:
+            default:
+                processSubBlocks<Topology::feedForward>(channelData, key, numBufferChannels, numSamples, crossfading, multiband, linked, linkAcrossRegisters);
+                break;
+        }
+
+        tame.snapToZero();
+        inputLevels.finish(numSamples);
+        outputLevels.finish(numSamples);
+
+        if (! scanned)
+        {
+            updateQuiet(numBufferChannels, numSamples, key);
+        }
+    }
+
+    int getLatencySamples() const noexcept              { return dryDelay.getDelay(); }
+
+    //The latency these settings will have, so it can be reported before the audio thread switches to them
+    int getLatencySamples(const Parameters& params) const noexcept
+    {
+        const auto order = juce::jlimit(0, maxOversamplingOrder, params.oversamplingOrder);
+        const auto ms = juce::jlimit(0.0, double(maxLookaheadMs), double(params.lookaheadMs));
+        return lookaheadMsToSamples(ms) + oversamplingLatencies[params.linearPhaseOversampling ? 1 : 0][order];
+    }
+
+    //Latency plus the time the slowest release takes to fall from 0 dBFS to silenceDb
+    double getTailSeconds() const noexcept
+    {
+        auto releaseMs = double(releaseTime.getTargetValue());
+        for (int band = 1; band < crossover.getNumBands(); ++band)
+        {
+            releaseMs = juce::jmax(releaseMs, double(bandReleaseTimes[band].getTargetValue()));
+        }
+
+        //auto timing lets go through its slow stage last
+        if (autoTiming)
+        {
+            releaseMs *= KcompCompressor<SampleType>::slowReleaseScale;
+        }
+
+        //the envelope falls by exp(-2pi * 1000 / releaseMs) per second
+        const auto decaySeconds = releaseMs * -silenceDb * std::log(10.0) / (20.0 * 2.0 * juce::MathConstants<double>::pi * 1000.0);
+        return getLatencySamples() / sampleRate + decaySeconds;
+    }
+
+    bool isSleeping() const noexcept                    { return sleeping; }
+
+    //Meter taps of the last processed block, one value per channel: the input after the input gain, the output
+    //as it leaves. The input keeps the sums of squares of each sub-block too.
+    const KcompLevelStats<SampleType>& getInputLevels() const noexcept     { return inputLevels; }
+    const KcompLevelStats<SampleType>& getOutputLevels() const noexcept    { return outputLevels; }
+
+    //BS.1770 true peak of the output in the last block, linear, one value per channel. 0 unless setTruePeakMeter() is on.
+    const SampleType* getOutputTruePeaks() const        { return outputTruePeaks.data(); }
+
+    //Lowest gain of each band over all channels in the last block, getNumBands() values
+    int getNumBands() const noexcept                    { return crossover.getNumBands(); }
+    const SampleType* getBandGains() const              { return bandMinGains; }
+
+    //Where the applied gain goes, one frame per sub-block. Set it before prepare() or with the audio stopped, nullptr for none.
+    void setGainFifo(KcompGainFifo* newFifo) noexcept   { gainFifo = newFifo; }
+
+    //Where the K-weighted power of the input (before the input gain) and the output goes, once per sub-block.
+    //Both or neither, same rules as setGainFifo(). Without them the K-weighting doesn't run.
+    void setLoudnessMeters(KcompLoudnessMeter* newInputMeter, KcompLoudnessMeter* newOutputMeter) noexcept
+    {
+        inputLoudness = newInputMeter;
+        outputLoudness = newOutputMeter;
+        measureLoudness = inputLoudness != nullptr && outputLoudness != nullptr;
+    }
+
+    //Runs the 4x oversampled true-peak estimate on the output, same rules as setGainFifo()
+    void setTruePeakMeter(bool shouldMeasure) noexcept  { measureTruePeak = shouldMeasure; }
+
+private:
+
+    using Smoother = juce::SmoothedValue<SampleType, juce::ValueSmoothingTypes::Linear>;
+    using FrameParameters = typename KcompCompressor<SampleType>::FrameParameters;
+    using AutoState = typename KcompCompressor<SampleType>::AutoState;
+
+    //Older JUCE versions can't pad the oversampling latency to whole samples, then it gets rounded
+   #if JUCE_MAJOR_VERSION > 6 || (JUCE_MAJOR_VERSION == 6 && JUCE_MINOR_VERSION >= 1)
+    static constexpr bool useIntegerOversamplingLatency = true;
+   #else
+    static constexpr bool useIntegerOversamplingLatency = false;
+   #endif
+
+    //Registers that live for one pass over a channel group
+    struct GroupState
+    {
+        typename KcompTame<SampleType>::State tame;
+        Vec env, tameEnv;
+        AutoState autoState;
+        typename KcompLevelStats<SampleType>::Accumulator inputLevels, outputLevels;
+        typename KcompKWeighting<SampleType>::State inputK, outputK;
+        Vec inputLoudness, outputLoudness;     //K-weighted sums of squares
+        typename KcompTruePeak<SampleType>::State truePeak;
+        Vec outputTruePeak;
+        Vec minGain;    //lowest applied gain in this sub-block
+        Vec feedback;   //last output before make-up, only kept in feedback and hybrid
+    };
+
+    using Curve = typename KcompCompressor<SampleType>::Curve;
+
+    //Per-band detector settings and curves, band b in lane b % lanes of band group b / lanes
+    struct BandFrameParameters
+    {
+        FrameParameters params[maxBandGroups];
+        Vec log2Thresholds[maxBandGroups];
+        Curve curves[maxBandGroups];
+        Vec curveFades[maxBandGroups];
+    };
+
+    //Sidechain channels for one sub-block, pointing into the host buffer
+    struct KeyInput
+    {
+        const SampleType* channels[maxChannels]{};
+        int numChannels{ 0 };
+        bool split{ false };    //the key differs from the signal, so multiband needs its own crossover for it
+    };
+
+    using KeyState = typename KcompKeyFilter<SampleType>::State;
+
+    //One frame of a channel group split into bands, [channel][band group] with the bands in the lanes
+    struct BandFrames
+    {
+        Vec signals[lanes][maxBandGroups];
+        Vec levels[lanes][maxBandGroups];
+    };
+
+    //Multiband registers for one pass over a channel group
+    struct BandState
+    {
+        typename KcompCrossover<SampleType>::State crossover, keyCrossover;
+        Vec envelopes[lanes][maxBandGroups];
+        AutoState autoStates[lanes][maxBandGroups];
+        Vec minGains[maxBandGroups];
+        Vec feedback[lanes][maxBandGroups];
+    };
+
+    static constexpr int maxDetectorFrames = subBlockSize << maxOversamplingOrder;
+    static constexpr int maxGroups = (maxChannels + lanes - 1) / lanes;
+
+    //Everything in Parameters that switches instead of ramping
+    void setSwitches(const Parameters& newParams)
+    {
+        //auto state left over from the last time it was on would hold the gain down
+        if (newParams.autoTiming && ! autoTiming)
+        {
+            compressor.resetAutoStates();
+            std::fill(bandAutoStates.begin(), bandAutoStates.end(), SampleType());
+        }
+        autoTiming = newParams.autoTiming;
+
+        bypassMix.setTargetValue(newParams.bypassed ? static_cast<SampleType>(1.0) : SampleType());
+        //listening, the lookahead's delay line carries the key instead of the signal
+        if (newParams.keyListen != keyListen)
+        {
+            lookahead.reset();
+        }
+        keyListen = newParams.keyListen;
+
+        //lookahead and oversampling set the plugin latency, so they switch instead of ramping
+        lookaheadMs = juce::jlimit(static_cast<SampleType>(0.0), static_cast<SampleType>(maxLookaheadMs), newParams.lookaheadMs);
+        oversamplingOrder = juce::jlimit(0, maxOversamplingOrder, newParams.oversamplingOrder);
+        linearPhaseOversampling = newParams.linearPhaseOversampling;
+        updateStages(false);
+
+        tameEnabled = newParams.tameEnabled;
+        tame.setShape(newParams.tameSlope, newParams.tameHighPass);
+        tameDynamic = newParams.tameDynamic;
+        compressor.setLinked(newParams.linked);
+        stereoMode = static_cast<StereoMode>(juce::jlimit(0, 1, newParams.stereoMode));
+
+        if (juce::jlimit(1, maxBands, newParams.numBands) != crossover.getNumBands())
+        {
+            crossover.setNumBands(newParams.numBands);
+            keyCrossover.setNumBands(newParams.numBands);
+            std::fill(bandEnvelopes.begin(), bandEnvelopes.end(), SampleType());
+            std::fill(bandAutoStates.begin(), bandAutoStates.end(), SampleType());
+            bandLookahead.reset();
+            bandDetector.reset();
+        }
+
+        keyFilter.setCutoffs(newParams.keyHighPassHz, newParams.keyLowPassHz);
+
+        const auto detectorMode = static_cast<typename KcompDetector<SampleType>::Mode>(juce::jlimit(0, 2, newParams.detectorMode));
+        for (auto* levelDetector : { &detector, &bandDetector })
+        {
+            levelDetector->setMode(detectorMode);
+            levelDetector->setWindow(newParams.rmsWindowMs);
+        }
+
+        requestedTopology = static_cast<Topology>(juce::jlimit(0, 2, newParams.topology));
+    }
+
+    //The ramped ones, the ones forEachRampedParameter() visits. Their smoothers get there in rampSamples, a whole
+    //sub-block while gliding so each one lands on its glide target, rampLengthSeconds otherwise.
+    void setTargets(const Parameters& newParams, int rampSamples)
+    {
+        setTargetRampLength(rampSamples);
+
+        inputGain.setTargetValue(newParams.inputGain);
+        makeUpGain.setTargetValue(newParams.makeUpGain);
+        outputGain.setTargetValue(newParams.outputGain);
+        log2Threshold.setTargetValue(KcompCompressor<SampleType>::thresholdToLog2(newParams.thresholdDb));
+        attackTime.setTargetValue(newParams.attackMs);
+        releaseTime.setTargetValue(newParams.releaseMs);
+
+        //DryWetMixingRule::squareRoot3dB, listening to the key is all wet
+        const auto mix = keyListen ? static_cast<SampleType>(1.0)
+                                   : juce::jlimit(static_cast<SampleType>(0.0), static_cast<SampleType>(1.0), newParams.dryWetMix);
+        dryVolume.setTargetValue(std::sqrt(static_cast<SampleType>(1.0) - mix));
+        wetVolume.setTargetValue(std::sqrt(mix));
+
+        tame.setFrequency(newParams.tameFrequencyHz);
+        tameLog2Threshold.setTargetValue(KcompCompressor<SampleType>::thresholdToLog2(newParams.tameThresholdDb));
+        tameCompressor.setRatio(juce::jmax(static_cast<SampleType>(1.0), newParams.tameRatio));
+        linkAmount.setTargetValue(juce::jlimit(static_cast<SampleType>(0.0), static_cast<SampleType>(1.0), newParams.linkAmount));
+        feedbackMix.setTargetValue(juce::jlimit(static_cast<SampleType>(0.0), static_cast<SampleType>(1.0), newParams.feedbackMix));
+
+        for (int index = 0; index < maxBands - 1; ++index)
+        {
+            crossover.setCrossoverFrequency(index, newParams.crossoverFrequencies[index]);
+            keyCrossover.setCrossoverFrequency(index, newParams.crossoverFrequencies[index]);
+        }
+
+        for (int band = 0; band < maxBands; ++band)
+        {
+            bandLog2Thresholds[band].setTargetValue(KcompCompressor<SampleType>::thresholdToLog2(newParams.bands[band].thresholdDb));
+            bandAttackTimes[band].setTargetValue(newParams.bands[band].attackMs);
+            bandReleaseTimes[band].setTargetValue(newParams.bands[band].releaseMs);
+        }
+    }
+
+    //Calls fn(a.x, b.x) for every parameter that glides in scheduleParameters()
+    template <typename ParametersA, typename ParametersB, typename Function>
+    static void forEachRampedParameter(ParametersA& a, ParametersB& b, Function&& fn)
+    {
+        fn(a.inputGain, b.inputGain);
+        fn(a.thresholdDb, b.thresholdDb);
+        fn(a.attackMs, b.attackMs);
+        fn(a.releaseMs, b.releaseMs);
+        fn(a.makeUpGain, b.makeUpGain);
+        fn(a.dryWetMix, b.dryWetMix);
+        fn(a.outputGain, b.outputGain);
+        fn(a.tameFrequencyHz, b.tameFrequencyHz);
+        fn(a.tameThresholdDb, b.tameThresholdDb);
+        fn(a.tameRatio, b.tameRatio);
+        fn(a.linkAmount, b.linkAmount);
+        fn(a.feedbackMix, b.feedbackMix);
+
+        for (int index = 0; index < maxBands - 1; ++index)
+        {
+            fn(a.crossoverFrequencies[index], b.crossoverFrequencies[index]);
+        }
+
+        for (int band = 0; band < maxBands; ++band)
+        {
+            fn(a.bands[band].thresholdDb, b.bands[band].thresholdDb);
+            fn(a.bands[band].attackMs, b.bands[band].attackMs);
+            fn(a.bands[band].releaseMs, b.bands[band].releaseMs);
+        }
+    }
+
+    //Ramp targets for samplesDone samples into a scheduled block of numSamples, the scheduled values at the end.
+    //rampSamples is how far off samplesDone is, the smoothers reach the targets there.
+    void updateGlide(int samplesDone, int numSamples, int rampSamples) noexcept
+    {
+        if (samplesDone >= numSamples)
+        {
+            setTargets(glideEnd, rampSamples);
+            gliding = false;
+            return;
+        }
+
+        const auto proportion = static_cast<SampleType>(samplesDone) / static_cast<SampleType>(numSamples);
+        auto params = glideEnd;
+        forEachRampedParameter(glideStart, params, [proportion](SampleType from, SampleType& to) { to = from + proportion * (to - from); });
+        setTargets(params, rampSamples);
+    }
+
+    //Gives the smoothers setTargets() moves a new ramp length. Smoother::reset() jumps to the target, so each
+    //one is pinned where it is first.
+    void setTargetRampLength(int rampSamples) noexcept
+    {
+        if (rampSamples == targetRampSamples)
+        {
+            return;
+        }
+
+        auto setLength = [rampSamples](Smoother& smoother)
+        {
+            smoother.setCurrentAndTargetValue(smoother.getCurrentValue());
+            smoother.reset(rampSamples);
+        };
+
+        for (auto* smoother : { &inputGain, &makeUpGain, &outputGain, &dryVolume, &wetVolume, &log2Threshold, &attackTime, &releaseTime, &tameLog2Threshold, &feedbackMix, &linkAmount })
+        {
+            setLength(*smoother);
+        }
+        for (int band = 0; band < maxBands; ++band)
+        {
+            setLength(bandLog2Thresholds[band]);
+            setLength(bandAttackTimes[band]);
+            setLength(bandReleaseTimes[band]);
+        }
+        targetRampSamples = rampSamples;
+    }
+
+    //0 front, 1 surround, 2 height, -1 for channels with their own detector
+    static int getLinkGroup(juce::AudioChannelSet::ChannelType type) noexcept
+    {
+        using Set = juce::AudioChannelSet;
+
+        switch (type)
+        {
+            case Set::LFE:
+            case Set::LFE2:
+                return -1;
+
+            case Set::leftSurround:
+            case Set::rightSurround:
+            case Set::centreSurround:
+            case Set::leftSurroundSide:
+            case Set::rightSurroundSide:
+            case Set::leftSurroundRear:
+            case Set::rightSurroundRear:
+                return 1;
+
+            case Set::topMiddle:
+            case Set::topFrontLeft:
+            case Set::topFrontCentre:
+            case Set::topFrontRight:
+            case Set::topRearLeft:
+            case Set::topRearCentre:
+            case Set::topRearRight:
+            case Set::topSideLeft:
+            case Set::topSideRight:
+                return 2;
+
+            default:
+                return 0;
+        }
+    }
+
+    //Flattens linkGroupOfChannel into member lists, groups of one channel are left out
+    void updateLinkGroups() noexcept
+    {
+        numLinkGroups = 0;
+        auto numMembers = 0;
+
+        for (int linkGroup = 0; linkGroup < 3; ++linkGroup)
+        {
+            const auto start = numMembers;
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                if (linkGroupOfChannel[channel] == linkGroup)
+                {
+                    linkMembers[numMembers++] = channel;
+                }
+            }
+
+            if (numMembers - start > 1)
+            {
+                linkGroupStarts[numLinkGroups++] = start;
+                linkGroupStarts[numLinkGroups] = numMembers;
+            }
+            else
+            {
+                numMembers = start;
+            }
+        }
+
+        linkFitsRegister = numGroups == 1 && numLinkGroups == 1 && numMembers == numChannels;
+    }
+
+    //Everything that holds audio on the wet side, the dry delay and the ramps are left alone
+    void resetWetPath()
+    {
+        tame.reset();
+        compressor.reset();
+        tameCompressor.reset();
+        lookahead.reset();
+
+        crossover.reset();
+        keyCrossover.reset();
+        keyFilter.reset();
+        detector.reset();
+        std::fill(bandEnvelopes.begin(), bandEnvelopes.end(), SampleType());
+        std::fill(bandAutoStates.begin(), bandAutoStates.end(), SampleType());
+        bandLookahead.reset();
+        bandDetector.reset();
+        clearFeedback();
+
+        if (oversampler != nullptr)
+        {
+            oversampler->reset();
+        }
+    }
+
+    void clearFeedback() noexcept
+    {
+        std::fill(feedbackFrames.begin(), feedbackFrames.end(), SampleType());
+        std::fill(bandFeedback.begin(), bandFeedback.end(), SampleType());
+    }
+
+    //The topology this block runs with. The output is only kept while it's fed back, so it starts from silence.
+    Topology updateTopology(bool hasSidechain) noexcept
+    {
+        const auto topology = hasSidechain || keyListen ? Topology::feedForward : requestedTopology;
+        if (topology != activeTopology && activeTopology == Topology::feedForward)
+        {
+            clearFeedback();
+        }
+
+        activeTopology = topology;
+        return topology;
+    }
+
+    void clearMeters() noexcept
+    {
+        inputLevels.reset();
+        outputLevels.reset();
+        std::fill(outputTruePeaks.begin(), outputTruePeaks.end(), SampleType());
+        std::fill(appliedGains.begin(), appliedGains.end(), static_cast<SampleType>(1.0));
+        std::fill(std::begin(bandMinGains), std::end(bandMinGains), static_cast<SampleType>(1.0));
+    }
+
+    //Hands the lowest gain of the sub-block to the fifo and starts the next one at 1
+    void pushAppliedGains(int numBufferChannels, int num) noexcept
+    {
+        if (gainFifo != nullptr)
+        {
+            gainFifo->push(appliedGains.data(), numBufferChannels, num);
+        }
+        std::fill(appliedGains.begin(), appliedGains.end(), static_cast<SampleType>(1.0));
+    }
+
+    //Hands the K-weighted power of the sub-block to the loudness meters
+    void pushLoudness(int num) noexcept
+    {
+        if (measureLoudness)
+        {
+            inputLoudness->add(inputLoudnessSum, num);
+            outputLoudness->add(outputLoudnessSum, num);
+            inputLoudnessSum = 0.0;
+            outputLoudnessSum = 0.0;
+        }
+    }
+
+    void processDryDelay(SampleType* const* channelData, int numBufferChannels, int numSamples) noexcept
+    {
+        if (dryDelay.getDelay() == 0)
+        {
+            return;
+        }
+
+        forEachGroup(numBufferChannels, [&](int group, int firstChannel, int groupChannels)
+        {
+            for (int i = 0; i < numSamples; ++i)
+            {
+                scatter(channelData, firstChannel, groupChannels, i, dryDelay.process(group, gather(channelData, firstChannel, groupChannels, i)));
+            }
+        });
+    }
+
+    static SampleType getPeak(const SampleType* data, int numSamples) noexcept
+    {
+        const auto range = juce::FloatVectorOperations::findMinAndMax(data, numSamples);
+        return juce::jmax(-range.getStart(), range.getEnd());
+    }
+
+    static SampleType getSilence() noexcept
+    {
+        return static_cast<SampleType>(juce::Decibels::decibelsToGain(silenceDb, silenceDb - 1.0));
+    }
+
+    static bool isKeySilent(const juce::dsp::AudioBlock<const SampleType>& key) noexcept
+    {
+        auto silent = true;
+        for (size_t channel = 0; channel < key.getNumChannels() && silent; ++channel)
+        {
+            silent = getPeak(key.getChannelPointer(channel), int(key.getNumSamples())) < getSilence();
+        }
+        return silent;
+    }
+
+    //After an awake block: quiet when inputStage() saw nothing above silence (after the input gain) and the key
+    //was silent too, then the next block is scanned by updateSleep()
+    void updateQuiet(int numBufferChannels, int numSamples, const juce::dsp::AudioBlock<const SampleType>& key) noexcept
+    {
+        auto silent = true;
+        for (int channel = 0; channel < numBufferChannels && silent; ++channel)
+        {
+            silent = inputLevels.getPeaks()[channel] < getSilence();
+        }
+
+        if (silent && isKeySilent(key))
+        {
+            quietSamples = numSamples;
+        }
+    }
+
+    //While the input stays quiet: true once the engine can leave the buffer alone, the input (after the input
+    //gain) and the key have been silent for longer than the latency and nothing is left in the envelopes
+    bool updateSleep(const juce::AudioBuffer<SampleType>& buffer, int numBufferChannels, const juce::dsp::AudioBlock<const SampleType>& key) noexcept
+    {
+        const auto silence = getSilence();
+        const auto numSamples = buffer.getNumSamples();
+        const auto gain = juce::jmax(inputGain.getCurrentValue(), inputGain.getTargetValue());
+
+        auto silent = true;
+        for (int channel = 0; channel < numBufferChannels && silent; ++channel)
+        {
+            silent = getPeak(buffer.getReadPointer(channel), numSamples) * gain < silence;
+        }
+        silent = silent && isKeySilent(key);
+
+        if (! silent)
+        {
+            quietSamples = 0;
+            sleeping = false;
+            return false;
+        }
+
+        quietSamples = juce::jmin(quietSamples + numSamples, std::numeric_limits<int>::max() / 2);
+        if (! sleeping && quietSamples > getLatencySamples() + subBlockSize)
+        {
+            sleeping = envelopesBelow(silence);
+        }
+
+        return sleeping;
+    }
+
+    bool envelopesBelow(SampleType silence) const noexcept
+    {
+        auto loudest = SampleType();
+        for (int group = 0; group < numGroups; ++group)
+        {
+            loudest = juce::jmax(loudest, KcompSIMD::horizontalMax(compressor.getEnvelope(group), lanes),
+                                 KcompSIMD::horizontalMax(tameCompressor.getEnvelope(group), lanes));
+            if (autoTiming)
+            {
+                loudest = juce::jmax(loudest, KcompSIMD::horizontalMax(compressor.getAutoState(group).slowEnv, lanes));
+            }
+        }
+        for (auto env : bandEnvelopes)
+        {
+            loudest = juce::jmax(loudest, env);
+        }
+        for (size_t slot = 0; autoTiming && slot < bandAutoStates.size(); slot += size_t(KcompCompressor<SampleType>::autoStateSize))
+        {
+            loudest = juce::jmax(loudest, KcompSIMD::horizontalMax(KcompCompressor<SampleType>::loadAutoState(bandAutoStates.data() + slot).slowEnv, lanes));
+        }
+        return loudest < silence;
+    }
+
+    int lookaheadMsToSamples(double ms) const noexcept
+    {
+        return juce::roundToInt(ms * 0.001 * sampleRate);
+    }
+
+    //Picks the oversampler and delay lengths for the current settings
+    void updateStages(bool force)
+    {
+        const auto type = linearPhaseOversampling ? 1 : 0;
+        if (force || oversamplingOrder != activeOversamplingOrder || type != activeOversamplingType)
+        {
+            activeOversamplingOrder = oversamplingOrder;
+            activeOversamplingType = type;
+            oversampler = oversamplingOrder > 0 ? oversamplers[type][oversamplingOrder - 1].get() : nullptr;
+
+            if (oversampler != nullptr)
+            {
+                oversampler->reset();
+            }
+
+            compressor.setSampleRate(sampleRate * double(1 << oversamplingOrder));
+            compressor.reset();
+            lookahead.reset();
+
+            crossover.setSampleRate(sampleRate * double(1 << oversamplingOrder));
+            crossover.reset();
+            keyCrossover.setSampleRate(sampleRate * double(1 << oversamplingOrder));
+            keyCrossover.reset();
+            keyFilter.setSampleRate(sampleRate * double(1 << oversamplingOrder));
+            keyFilter.reset();
+            detector.setOversamplingOrder(oversamplingOrder);
+            bandDetector.setOversamplingOrder(oversamplingOrder);
+            for (auto& bandCompressor : bandCompressors)
+            {
+                bandCompressor.setSampleRate(sampleRate * double(1 << oversamplingOrder));
+            }
+            std::fill(bandEnvelopes.begin(), bandEnvelopes.end(), SampleType());
+            std::fill(bandAutoStates.begin(), bandAutoStates.end(), SampleType());
+            bandLookahead.reset();
+        }
+
+        const auto lookaheadSamples = lookaheadMsToSamples(lookaheadMs);
+
+        lookahead.setDelay(lookaheadSamples << activeOversamplingOrder);
+        bandLookahead.setDelay(lookaheadSamples << activeOversamplingOrder);
+        dryDelay.setDelay(lookaheadSamples + oversamplingLatencies[activeOversamplingType][activeOversamplingOrder]);
+    }
+
+    BandFrameParameters getBandFrameParameters(int num) noexcept
+    {
+        for (int band = 0; band < maxBands; ++band)
+        {
+            if (bandAttackTimes[band].isSmoothing() || bandReleaseTimes[band].isSmoothing())
+            {
+                bandCompressors[band].setAttack(bandAttackTimes[band].skip(num));
+                bandCompressors[band].setRelease(bandReleaseTimes[band].skip(num));
+            }
+        }
+
+        BandFrameParameters packed;
+        for (int bandGroup = 0; bandGroup < maxBandGroups; ++bandGroup)
+        {
+            //lanes past the last band see silence, which reads as unity on any curve
+            SampleType cteAttacks[lanes]{}, cteReleases[lanes]{}, thresholds[lanes]{};
+            SampleType autoAttacks[lanes]{}, autoReleases[lanes]{}, cteSlows[lanes]{};
+            SampleType fades[lanes]{};
+            auto& curve = packed.curves[bandGroup];
+            for (int lane = 0; lane < lanes; ++lane)
+            {
+                const auto band = bandGroup * lanes + lane;
+                const auto& transferCurve = transferCurves[band < maxBands ? band : 0];
+                curve.tables[lane] = transferCurve.getTable();
+                curve.previousTables[lane] = transferCurve.getPreviousTable();
+                fades[lane] = static_cast<SampleType>(1.0);
+
+                if (band < maxBands)
+                {
+                    const auto coefficients = bandCompressors[band].getCoefficients();
+                    cteAttacks[lane] = coefficients.cteAttack;
+                    cteReleases[lane] = coefficients.cteRelease;
+                    autoAttacks[lane] = coefficients.autoAttack;
+                    autoReleases[lane] = coefficients.autoRelease;
+                    cteSlows[lane] = coefficients.cteSlow;
+                    thresholds[lane] = bandLog2Thresholds[band].skip(num);
+
+                    if (curveFades[band].isSmoothing())
+                    {
+                        curve.fading = true;
+                        fades[lane] = curveFades[band].skip(num);
+                    }
+                }
+            }
+
+            //the slope comes from the curves
+            packed.params[bandGroup] = { KcompSIMD::load(cteAttacks), KcompSIMD::load(cteReleases), Vec::expand(SampleType()),
+                                         KcompSIMD::load(autoAttacks), KcompSIMD::load(autoReleases), KcompSIMD::load(cteSlows) };
+            packed.log2Thresholds[bandGroup] = KcompSIMD::load(thresholds);
+            packed.curveFades[bandGroup] = KcompSIMD::load(fades);
+        }
+
+        return packed;
+    }
+
+    //Every lane of the single-band compressor reads curve 0
+    void updateMainCurve() noexcept
+    {
+        for (int lane = 0; lane < lanes; ++lane)
+        {
+            mainCurve.tables[lane] = transferCurves[0].getTable();
+            mainCurve.previousTables[lane] = transferCurves[0].getPreviousTable();
+        }
+    }
+
+    static void fillRamp(Smoother& smoother, SampleType* dest, int num) noexcept
+    {
+        if (smoother.isSmoothing())
+        {
+            for (int i = 0; i < num; ++i)
+            {
+                dest[i] = smoother.getNextValue();
+            }
+        }
+        else
+        {
+            std::fill(dest, dest + num, smoother.getTargetValue());
+        }
+    }
+
+    template <typename Function>
+    void forEachGroup(int numBufferChannels, Function&& fn) const
+    {
+        for (int group = 0; group < numGroups; ++group)
+        {
+            const auto firstChannel = group * lanes;
+            const auto groupChannels = juce::jmin(lanes, numBufferChannels - firstChannel);
+
+            if (groupChannels > 0)
+            {
+                fn(group, firstChannel, groupChannels);
+            }
+        }
+    }
+
+    static forcedinline Vec gather(const SampleType* const* data, int firstChannel, int groupChannels, int index) noexcept
+    {
+        SampleType frame[lanes]{};
+        for (int lane = 0; lane < groupChannels; ++lane)
+        {
+            frame[lane] = data[firstChannel + lane][index];
+        }
+        return KcompSIMD::load(frame);
+    }
+
+    static forcedinline void scatter(SampleType* const* data, int firstChannel, int groupChannels, int index, Vec x) noexcept
+    {
+        SampleType frame[lanes];
+        KcompSIMD::store(frame, x);
+        for (int lane = 0; lane < groupChannels; ++lane)
+        {
+            data[firstChannel + lane][index] = frame[lane];
+        }
+    }
+
+    GroupState loadGroupState(int group) const noexcept
+    {
+        const auto offset = size_t(group * lanes);
+
+        GroupState state;
+        state.tame = tame.load(group);
+        state.env = compressor.getEnvelope(group);
+        state.tameEnv = tameCompressor.getEnvelope(group);
+        if (autoTiming)
+        {
+            state.autoState = compressor.getAutoState(group);
+        }
+        state.inputLevels = inputLevels.load(group);
+        state.outputLevels = outputLevels.load(group);
+        state.minGain = KcompSIMD::load(appliedGains.data() + offset);
+        if (activeTopology != Topology::feedForward)
+        {
+            state.feedback = KcompSIMD::load(feedbackFrames.data() + offset);
+        }
+        if (measureLoudness)
+        {
+            state.inputK = inputKWeighting.load(group);
+            state.outputK = outputKWeighting.load(group);
+            state.inputLoudness = Vec::expand(SampleType());
+            state.outputLoudness = Vec::expand(SampleType());
+        }
+        if (measureTruePeak)
+        {
+            state.truePeak = truePeak.load(group);
+            state.outputTruePeak = KcompSIMD::load(outputTruePeaks.data() + offset);
+        }
+        return state;
+    }
+
+    void storeGroupState(int group, const GroupState& state) noexcept
+    {
+        const auto offset = size_t(group * lanes);
+
+        tame.store(group, state.tame);
+        compressor.setEnvelope(group, state.env);
+        tameCompressor.setEnvelope(group, state.tameEnv);
+        if (autoTiming)
+        {
+            compressor.setAutoState(group, state.autoState);
+        }
+        inputLevels.store(group, state.inputLevels);
+        outputLevels.store(group, state.outputLevels);
+        KcompSIMD::store(appliedGains.data() + offset, state.minGain);
+        if (activeTopology != Topology::feedForward)
+        {
+            KcompSIMD::store(feedbackFrames.data() + offset, state.feedback);
+        }
+
+        if (measureLoudness)
+        {
+            inputKWeighting.store(group, state.inputK);
+            outputKWeighting.store(group, state.outputK);
+
+            const auto weights = KcompSIMD::load(loudnessWeights + offset);
+            inputLoudnessSum += double((state.inputLoudness * weights).sum());
+            outputLoudnessSum += double((state.outputLoudness * weights).sum());
+        }
+
+        if (measureTruePeak)
+        {
+            truePeak.store(group, state.truePeak);
+            KcompSIMD::store(outputTruePeaks.data() + offset, state.outputTruePeak);
+        }
+    }
+
+    void loadBandState(int group, BandState& state) const noexcept
+    {
+        state.crossover = crossover.load(group);
+        state.keyCrossover = keyCrossover.load(group);
+        for (int lane = 0; lane < lanes; ++lane)
+        {
+            for (int bandGroup = 0; bandGroup < maxBandGroups; ++bandGroup)
+            {
+                state.envelopes[lane][bandGroup] = KcompSIMD::load(bandEnvelopes.data() + getBandSlot(group, lane, bandGroup) * lanes);
+                if (activeTopology != Topology::feedForward)
+                {
+                    state.feedback[lane][bandGroup] = KcompSIMD::load(bandFeedback.data() + getBandSlot(group, lane, bandGroup) * lanes);
+                }
+                if (autoTiming)
+                {
+                    state.autoStates[lane][bandGroup] = KcompCompressor<SampleType>::loadAutoState(getBandAutoState(group, lane, bandGroup));
+                }
+            }
+        }
+        for (int bandGroup = 0; bandGroup < maxBandGroups; ++bandGroup)
+        {
+            state.minGains[bandGroup] = KcompSIMD::load(bandMinGains + bandGroup * lanes);
+        }
+    }
+
+    void storeBandState(int group, const BandState& state) noexcept
+    {
+        crossover.store(group, state.crossover);
+        keyCrossover.store(group, state.keyCrossover);
+        for (int lane = 0; lane < lanes; ++lane)
+        {
+            for (int bandGroup = 0; bandGroup < maxBandGroups; ++bandGroup)
+            {
+                KcompSIMD::store(bandEnvelopes.data() + getBandSlot(group, lane, bandGroup) * lanes, state.envelopes[lane][bandGroup]);
+                if (activeTopology != Topology::feedForward)
+                {
+                    KcompSIMD::store(bandFeedback.data() + getBandSlot(group, lane, bandGroup) * lanes, state.feedback[lane][bandGroup]);
+                }
+                if (autoTiming)
+                {
+                    KcompCompressor<SampleType>::storeAutoState(getBandAutoState(group, lane, bandGroup), state.autoStates[lane][bandGroup]);
+                }
+            }
+        }
+        for (int bandGroup = 0; bandGroup < maxBandGroups; ++bandGroup)
+        {
+            KcompSIMD::store(bandMinGains + bandGroup * lanes, state.minGains[bandGroup]);
+        }
+    }
+
+    //One slot per channel and band group, for the band envelopes and the band lookahead
+    static int getBandSlot(int group, int lane, int bandGroup) noexcept
+    {
+        return (group * lanes + lane) * maxBandGroups + bandGroup;
+    }
+
+    SampleType* getBandAutoState(int group, int lane, int bandGroup) noexcept
+    {
+        return bandAutoStates.data() + size_t(getBandSlot(group, lane, bandGroup) * KcompCompressor<SampleType>::autoStateSize);
+    }
+
+    const SampleType* getBandAutoState(int group, int lane, int bandGroup) const noexcept
+    {
+        return bandAutoStates.data() + size_t(getBandSlot(group, lane, bandGroup) * KcompCompressor<SampleType>::autoStateSize);
+    }
+
+    //==============================================================================
+    //Input gain, input meters and Tame
+    forcedinline Vec inputStage(GroupState& state, Vec dry, int i) const noexcept
+    {
+        if (measureLoudness)
+        {
+            const auto weighted = inputKWeighting.process(state.inputK, dry);
+            state.inputLoudness += weighted * weighted;
+        }
+
+        auto x = dry * Vec::expand(inputGains[i]);
+
+        state.inputLevels.add(x);
+
+        if (tameEnabled)
+        {
+            const auto tamed = tame.process(state.tame, x, i);
+
+            //dynamic: the part Tame takes away has its own detector and is only turned down above the threshold
+            if (tameDynamic)
+            {
+                const auto removed = x - tamed;
+                const auto gain = KcompCompressor<SampleType>::processLevel(KcompSIMD::abs(removed), state.tameEnv,
+                                                                             Vec::expand(tameLog2Thresholds[i]), tameParams);
+
+                //under the threshold the gain is exactly 1, those lanes keep the input as it was instead of the two halves
+                if (gain.sum() < static_cast<SampleType>(lanes))
+                {
+                    x = KcompSIMD::select<SampleType>(Vec::greaterThan(Vec::expand(static_cast<SampleType>(1.0)), gain), tamed + removed * gain, x);
+                }
+            }
+            else
+            {
+                x = tamed;
+            }
+        }
+
+        return x;
+    }
+
+    //L/R to M/S and back inside one register, left and right in lanes 0 and 1: x * (1, -1) plus the swapped
+    //pair is (L + R, L - R). Halved on the way in, so mono comes out of the mid at the level it went in.
+    static forcedinline Vec matrixMidSide(Vec x) noexcept
+    {
+        SampleType signs[lanes];
+        for (int lane = 0; lane < lanes; ++lane)
+        {
+            signs[lane] = lane % 2 == 0 ? static_cast<SampleType>(1.0) : static_cast<SampleType>(-1.0);
+        }
+        return x * KcompSIMD::load(signs) + KcompSIMD::swapPairs(x);
+    }
+
+    static forcedinline Vec encodeMidSide(Vec x) noexcept        { return matrixMidSide(x) * Vec::expand(static_cast<SampleType>(0.5)); }
+    static forcedinline Vec decodeMidSide(Vec x) noexcept        { return matrixMidSide(x); }
+
+    //JUCE_USE_SIMD=0 builds have one lane, so left and right are matrixed in the scratch between the passes instead
+    static void matrixMidSideRows(SampleType* const* data, int num, SampleType scale) noexcept
+    {
+        for (int i = 0; i < num; ++i)
+        {
+            const auto left = data[0][i];
+            const auto right = data[1][i];
+            data[0][i] = (left + right) * scale;
+            data[1][i] = (left - right) * scale;
+        }
+    }
+
+    //Each channel's level pulled towards the loudest one by the link amount, all the way when it's at 100 %
+    forcedinline Vec linkLevel(Vec level, Vec loudest, int rampIndex) const noexcept
+    {
+        if (fullyLinked)
+        {
+            return loudest;
+        }
+        return loudest + (level - loudest) * Vec::expand(static_cast<SampleType>(1.0) - linkAmounts[rampIndex]);
+    }
+
+    //The frame the detector sees: the sidechain if there is one, the signal otherwise, through the key filters.
+    //A mono sidechain feeds every channel, in M/S a stereo one is matrixed like the signal.
+    forcedinline Vec keyStage(KeyState& keyState, Vec x, const KeyInput& keyInput, int firstChannel, int groupChannels, int index) const noexcept
+    {
+        if (keyInput.numChannels > 1 && midSide)
+        {
+            const auto left = keyInput.channels[0][index];
+            const auto right = keyInput.channels[1][index];
+
+            SampleType frame[lanes]{};
+            for (int lane = 0; lane < groupChannels; ++lane)
+            {
+                frame[lane] = (firstChannel + lane == 0 ? left + right : left - right) * static_cast<SampleType>(0.5);
+            }
+            x = KcompSIMD::load(frame);
+        }
+        else if (keyInput.numChannels > 0)
+        {
+            SampleType frame[lanes]{};
+            for (int lane = 0; lane < groupChannels; ++lane)
+            {
+                frame[lane] = keyInput.channels[juce::jmin(firstChannel + lane, keyInput.numChannels - 1)][index];
+            }
+            x = KcompSIMD::load(frame);
+        }
+
+        return keyFilter.isActive() ? keyFilter.process(keyState, x) : x;
+    }
+
+    //What goes into keyStage() in place of the signal: the signal, the last output, or a blend
+    template <Topology topology>
+    forcedinline Vec detectorInput(const GroupState& state, Vec x, int rampIndex) const noexcept
+    {
+        if (topology == Topology::feedback)
+        {
+            return state.feedback;
+        }
+        if (topology == Topology::hybrid)
+        {
+            return x + (state.feedback - x) * Vec::expand(feedbackMixes[rampIndex]);
+        }
+        return x;
+    }
+
+    //Lookahead, gain computer and make-up gain for one frame of detector levels
+    template <Topology topology>
+    forcedinline Vec compressStage(GroupState& state, Vec x, Vec level, int group, int groupChannels, bool sharedDetector, bool useLookahead,
+                                   int rampIndex, const FrameParameters& params) noexcept
+    {
+        if (useLookahead)
+        {
+            lookahead.process(group, groupChannels, sharedDetector, x, level);
+        }
+
+        const auto threshold = Vec::expand(log2Thresholds[rampIndex]);
+        const auto fade = Vec::expand(curveFadeGains[rampIndex]);
+        const auto gain = autoTiming ? KcompCompressor<SampleType>::processLevelAuto(level, state.env, state.autoState, threshold, params, autoConstants, mainCurve, fade)
+                                     : KcompCompressor<SampleType>::processLevel(level, state.env, threshold, params, mainCurve, fade);
+        state.minGain = Vec::min(state.minGain, gain);
+
+        const auto compressed = x * gain;
+        if (topology != Topology::feedForward)
+        {
+            state.feedback = compressed;
+        }
+        return compressed * Vec::expand(makeUpGains[rampIndex]);
+    }
+
+    //Detector, lookahead, gain computer and make-up gain, at the oversampled rate when oversampling is on.
+    //linked only covers channels in the same register, wider links go through processLinkedGainPass().
+    template <Topology topology>
+    forcedinline Vec gainStage(GroupState& state, Vec x, Vec key, int group, int groupChannels, bool linked, bool useLookahead,
+                               int rampIndex, const FrameParameters& params) noexcept
+    {
+        auto level = detector.process(group, key);
+        if (linked)
+        {
+            level = linkLevel(level, Vec::expand(KcompSIMD::horizontalMax(level, groupChannels)), rampIndex);
+        }
+
+        return compressStage<topology>(state, x, level, group, groupChannels, linked && fullyLinked, useLookahead, rampIndex, params);
+    }
+
+    //Splits one frame into bands and turns it around, so each channel has its bands side by side in the lanes.
+    //The band detectors hear the key split the same way, or in feedback and hybrid the last output of their band.
+    template <Topology topology>
+    forcedinline void splitBands(BandState& bandState, Vec x, Vec key, bool splitKey, int group, int groupChannels, int rampIndex, BandFrames& frames) noexcept
+    {
+        const auto numBands = crossover.getNumBands();
+        splitKey = splitKey && topology != Topology::feedback;
+
+        Vec bands[maxBands], keyBands[maxBands];
+        crossover.process(bandState.crossover, x, bands);
+        if (splitKey)
+        {
+            keyCrossover.process(bandState.keyCrossover, key, keyBands);
+        }
+
+        SampleType bandFrames[maxBands][lanes], keyBandFrames[maxBands][lanes];
+        for (int band = 0; band < numBands; ++band)
+        {
+            KcompSIMD::store(bandFrames[band], bands[band]);
+            KcompSIMD::store(keyBandFrames[band], splitKey ? keyBands[band] : bands[band]);
+        }
+
+        for (int channel = 0; channel < groupChannels; ++channel)
+        {
+            for (int bandGroup = 0; bandGroup < maxBandGroups; ++bandGroup)
+            {
+                SampleType frame[lanes]{}, keyFrame[lanes]{};
+                for (int lane = 0; lane < lanes; ++lane)
+                {
+                    const auto band = bandGroup * lanes + lane;
+                    if (band < numBands)
+                    {
+                        frame[lane] = bandFrames[band][channel];
+                        keyFrame[lane] = keyBandFrames[band][channel];
+                    }
+                }
+
+                auto bandKey = KcompSIMD::load(keyFrame);
+                if (topology == Topology::feedback)
+                {
+                    bandKey = bandState.feedback[channel][bandGroup];
+                }
+                else if (topology == Topology::hybrid)
+                {
+                    bandKey += (bandState.feedback[channel][bandGroup] - bandKey) * Vec::expand(feedbackMixes[rampIndex]);
+                }
+
+                frames.signals[channel][bandGroup] = KcompSIMD::load(frame);
+                frames.levels[channel][bandGroup] = bandDetector.process(getBandSlot(group, channel, bandGroup), bandKey);
+            }
+        }
+    }
+
+    //Compresses the bands of every channel and sums them back up
+    template <Topology topology>
+    forcedinline Vec compressBands(GroupState& state, BandState& bandState, BandFrames& frames, int group, int groupChannels, bool useLookahead,
+                                   int rampIndex, const BandFrameParameters& bandParams) noexcept
+    {
+        SampleType outputs[lanes]{}, channelGains[lanes];
+        std::fill(std::begin(channelGains), std::end(channelGains), static_cast<SampleType>(1.0));
+        for (int channel = 0; channel < groupChannels; ++channel)
+        {
+            auto sum = Vec::expand(SampleType());
+            auto lowest = Vec::expand(static_cast<SampleType>(1.0));
+            for (int bandGroup = 0; bandGroup < maxBandGroups; ++bandGroup)
+            {
+                auto& signal = frames.signals[channel][bandGroup];
+                auto& level = frames.levels[channel][bandGroup];
+
+                if (useLookahead)
+                {
+                    bandLookahead.process(getBandSlot(group, channel, bandGroup), lanes, false, signal, level);
+                }
+
+                const auto gain = autoTiming ? KcompCompressor<SampleType>::processLevelAuto(level, bandState.envelopes[channel][bandGroup], bandState.autoStates[channel][bandGroup],
+                                                                                             bandParams.log2Thresholds[bandGroup], bandParams.params[bandGroup], autoConstants,
+                                                                                             bandParams.curves[bandGroup], bandParams.curveFades[bandGroup])
+                                             : KcompCompressor<SampleType>::processLevel(level, bandState.envelopes[channel][bandGroup], bandParams.log2Thresholds[bandGroup],
+                                                                                         bandParams.params[bandGroup], bandParams.curves[bandGroup], bandParams.curveFades[bandGroup]);
+                bandState.minGains[bandGroup] = Vec::min(bandState.minGains[bandGroup], gain);
+                lowest = Vec::min(lowest, gain);
+
+                const auto compressed = signal * gain;
+                if (topology != Topology::feedForward)
+                {
+                    bandState.feedback[channel][bandGroup] = compressed;
+                }
+                sum += compressed;
+            }
+            outputs[channel] = sum.sum();
+
+            //lanes past the last band hear nothing, so they stay at 1
+            channelGains[channel] = KcompSIMD::horizontalMin(lowest, lanes);
+        }
+
+        state.minGain = Vec::min(state.minGain, KcompSIMD::load(channelGains));
+        return KcompSIMD::load(outputs) * Vec::expand(makeUpGains[rampIndex]);
+    }
+
+    //Same as gainStage, with every channel split into bands and the bands compressed side by side
+    template <Topology topology>
+    forcedinline Vec multibandGainStage(GroupState& state, BandState& bandState, Vec x, Vec key, bool splitKey, int group, int groupChannels, bool linked,
+                                        bool useLookahead, int rampIndex, const BandFrameParameters& bandParams) noexcept
+    {
+        BandFrames frames;
+        splitBands<topology>(bandState, x, key, splitKey, group, groupChannels, rampIndex, frames);
+
+        //linked per band: every channel is pulled towards the loudest channel of that band
+        if (linked)
+        {
+            for (int bandGroup = 0; bandGroup < maxBandGroups; ++bandGroup)
+            {
+                auto loudest = frames.levels[0][bandGroup];
+                for (int channel = 1; channel < groupChannels; ++channel)
+                {
+                    loudest = Vec::max(loudest, frames.levels[channel][bandGroup]);
+                }
+                for (int channel = 0; channel < groupChannels; ++channel)
+                {
+                    frames.levels[channel][bandGroup] = linkLevel(frames.levels[channel][bandGroup], loudest, rampIndex);
+                }
+            }
+        }
+
+        return compressBands<topology>(state, bandState, frames, group, groupChannels, useLookahead, rampIndex, bandParams);
+    }
+
+    //Output meter, latency-compensated dry/wet blend and output gain
+    forcedinline Vec outputStage(GroupState& state, Vec wet, Vec dry, int group, bool useDryDelay, int i) noexcept
+    {
+        if (useDryDelay)
+        {
+            dry = dryDelay.process(group, dry);
+        }
+
+        auto output = ((wet * Vec::expand(wetGains[i])) + (dry * Vec::expand(dryGains[i]))) * Vec::expand(outputGains[i]);
+
+        //bypass fades to the delayed dry signal as it came in
+        if (crossfadeBypass)
+        {
+            output = output + (dry - output) * Vec::expand(bypassGains[i]);
+        }
+
+        if (measureLoudness)
+        {
+            const auto weighted = outputKWeighting.process(state.outputK, output);
+            state.outputLoudness += weighted * weighted;
+        }
+
+        if (measureTruePeak)
+        {
+            state.outputTruePeak = Vec::max(state.outputTruePeak, truePeak.process(state.truePeak, output));
+        }
+
+        state.outputLevels.add(output);
+        return output;
+    }
+
+    //==============================================================================
+    template <Topology topology>
+    void processSubBlocks(SampleType* const* channelData, const juce::dsp::AudioBlock<const SampleType>& key, int numBufferChannels, int numSamples,
+                          bool crossfading, bool multiband, bool linked, bool linkAcrossRegisters) noexcept
+    {
+        for (int start = 0; start < numSamples; start += subBlockSize)
+        {
+            const auto num = juce::jmin(subBlockSize, numSamples - start);
+
+            //scheduled parameters move their targets on to where they should be by the end of this sub-block
+            if (gliding)
+            {
+                updateGlide(start + num, numSamples, num);
+            }
+
+            //the ramps are shared by every channel, so they are only advanced once per sample
+            fillRamp(inputGain, inputGains, num);
+            fillRamp(log2Threshold, log2Thresholds, num);
+            fillRamp(makeUpGain, makeUpGains, num);
+            fillRamp(dryVolume, dryGains, num);
+            fillRamp(wetVolume, wetGains, num);
+            fillRamp(outputGain, outputGains, num);
+            if (crossfading)
+            {
+                const auto held = juce::jmin(num, bypassHoldSamples);
+                std::fill(bypassGains, bypassGains + held, static_cast<SampleType>(1.0));
+                fillRamp(bypassMix, bypassGains + held, num - held);
+                bypassHoldSamples -= held;
+            }
+            crossfadeBypass = crossfading;
+            if (topology == Topology::hybrid)
+            {
+                fillRamp(feedbackMix, feedbackMixes, num);
+            }
+            fullyLinked = ! linkAmount.isSmoothing() && linkAmount.getTargetValue() >= static_cast<SampleType>(1.0);
+            if (compressor.isLinked())
+            {
+                fillRamp(linkAmount, linkAmounts, num);
+            }
+            if (tameEnabled)
+            {
+                tame.fillCoefficients(num);
+                fillRamp(tameLog2Threshold, tameLog2Thresholds, num);
+                tameParams = tameCompressor.getFrameParameters();
+            }
+
+            if (attackTime.isSmoothing() || releaseTime.isSmoothing())
+            {
+                compressor.setAttack(attackTime.skip(num));
+                compressor.setRelease(releaseTime.skip(num));
+            }
+
+            if (! multiband)
+            {
+                mainCurve.fading = curveFades[0].isSmoothing();
+                fillRamp(curveFades[0], curveFadeGains, num);
+            }
+
+            const auto params = compressor.getFrameParameters();
+            autoConstants = compressor.getAutoConstants();
+
+            //a view into the sidechain for this sub-block, nothing is copied
+            KeyInput keyInput;
+            if (key.getNumChannels() > 0)
+            {
+                const auto keyBlock = key.getSubBlock(size_t(start), size_t(num));
+                keyInput.numChannels = juce::jmin(int(keyBlock.getNumChannels()), maxChannels);
+                for (int channel = 0; channel < keyInput.numChannels; ++channel)
+                {
+                    keyInput.channels[channel] = keyBlock.getChannelPointer(size_t(channel));
+                }
+            }
+            keyInput.split = keyInput.numChannels > 0 || keyFilter.isActive();
+
+            //band settings only ramp once per sub-block
+            BandFrameParameters bandParams;
+            if (multiband)
+            {
+                bandParams = getBandFrameParameters(num);
+            }
+
+            //M/S needs left and right in the same register to stay in one pass
+            if (oversampler == nullptr && ! linkAcrossRegisters && ! (midSide && lanes < 2))
+            {
+                forEachGroup(numBufferChannels, [&](int group, int firstChannel, int groupChannels)
+                {
+                    if (multiband)
+                    {
+                        processSubBlock<true, topology>(channelData, keyInput, firstChannel, groupChannels, start, num, group, linked, params, bandParams);
+                    }
+                    else
+                    {
+                        processSubBlock<false, topology>(channelData, keyInput, firstChannel, groupChannels, start, num, group, linked, params, bandParams);
+                    }
+                });
+            }
+            else if (multiband)
+            {
+                processSubBlockInPasses<true, topology>(channelData, keyInput, numBufferChannels, start, num, linked, linkAcrossRegisters, params, bandParams);
+            }
+            else
+            {
+                processSubBlockInPasses<false, topology>(channelData, keyInput, numBufferChannels, start, num, linked, linkAcrossRegisters, params, bandParams);
+            }
+
+            pushAppliedGains(numBufferChannels, num);
+            pushLoudness(num);
+            inputLevels.endSubBlock(num);
+        }
+    }
+
+    template <bool multiband, Topology topology>
+    void processSubBlock(SampleType* const* channelData, const KeyInput& keyInput, int firstChannel, int groupChannels, int start, int num,
+                         int group, bool linked, const FrameParameters& params, const BandFrameParameters& bandParams) noexcept
+    {
+        const auto useLookahead = lookahead.getDelay() > 0;
+        const auto useDryDelay = dryDelay.getDelay() > 0;
+
+        auto state = loadGroupState(group);
+        auto keyState = keyFilter.load(group);
+        BandState bandState;
+        if (multiband)
+        {
+            loadBandState(group, bandState);
+        }
+
+        for (int i = 0; i < num; ++i)
+        {
+            const auto dry = gather(channelData, firstChannel, groupChannels, start + i);
+
+            auto x = inputStage(state, dry, i);
+            if (midSide)
+            {
+                x = encodeMidSide(x);
+            }
+
+            const auto key = keyStage(keyState, multiband ? x : detectorInput<topology>(state, x, i), keyInput, firstChannel, groupChannels, i);
+
+            if (keyListen)
+            {
+                x = useLookahead ? lookahead.delaySignal(group, key) : key;
+            }
+            else
+            {
+                x = multiband ? multibandGainStage<topology>(state, bandState, x, key, keyInput.split, group, groupChannels, linked, useLookahead, i, bandParams)
+                              : gainStage<topology>(state, x, key, group, groupChannels, linked, useLookahead, i, params);
+            }
+
+            if (midSide)
+            {
+                x = decodeMidSide(x);
+            }
+
+            scatter(channelData, firstChannel, groupChannels, start + i, outputStage(state, x, dry, group, useDryDelay, i));
+        }
+
+        storeGroupState(group, state);
+        keyFilter.store(group, keyState);
+        if (multiband)
+        {
+            storeBandState(group, bandState);
+        }
+    }
+
+    //Input stage, gain stage and output stage one after the other, for oversampling and for links wider than a register
+    template <bool multiband, Topology topology>
+    void processSubBlockInPasses(SampleType* const* channelData, const KeyInput& keyInput, int numBufferChannels, int start, int num,
+                                 bool linked, bool linkAcrossRegisters, const FrameParameters& params, const BandFrameParameters& bandParams) noexcept
+    {
+        const auto useDryDelay = dryDelay.getDelay() > 0;
+        auto* const* wetData = wetScratch.getArrayOfWritePointers();
+
+        forEachGroup(numBufferChannels, [&](int group, int firstChannel, int groupChannels)
+        {
+            auto state = loadGroupState(group);
+            for (int i = 0; i < num; ++i)
+            {
+                auto x = inputStage(state, gather(channelData, firstChannel, groupChannels, start + i), i);
+                if (midSide && lanes > 1)
+                {
+                    x = encodeMidSide(x);
+                }
+                scatter(wetData, firstChannel, groupChannels, i, x);
+            }
+            storeGroupState(group, state);
+        });
+
+        if (midSide && lanes < 2)
+        {
+            matrixMidSideRows(wetData, num, static_cast<SampleType>(0.5));
+        }
+
+        juce::dsp::AudioBlock<SampleType> wetBlock(wetData, size_t(numBufferChannels), size_t(num));
+
+        SampleType* detectorData[maxChannels]{};
+        auto numFrames = num;
+        if (oversampler != nullptr)
+        {
+            auto upBlock = oversampler->processSamplesUp(wetBlock);
+            numFrames = int(upBlock.getNumSamples());
+            for (int channel = 0; channel < numBufferChannels; ++channel)
+            {
+                detectorData[channel] = upBlock.getChannelPointer(size_t(channel));
+            }
+        }
+        else
+        {
+            std::copy(wetData, wetData + numBufferChannels, detectorData);
+        }
+
+        //the ramps and the sidechain stay at the base rate, each value covers 2^order oversampled frames
+        const auto rampShift = oversampler != nullptr ? activeOversamplingOrder : 0;
+
+        if (linkAcrossRegisters && topology != Topology::feedForward)
+        {
+            processLinkedFeedbackPass<multiband, topology>(detectorData, keyInput, numBufferChannels, numFrames, rampShift, params, bandParams);
+        }
+        else if (linkAcrossRegisters)
+        {
+            processLinkedGainPass<multiband>(detectorData, keyInput, numBufferChannels, numFrames, rampShift, params, bandParams);
+        }
+        else
+        {
+            processGainPass<multiband, topology>(detectorData, keyInput, numBufferChannels, numFrames, rampShift, linked, params, bandParams);
+        }
+
+        if (oversampler != nullptr)
+        {
+            oversampler->processSamplesDown(wetBlock);
+        }
+
+        if (midSide && lanes < 2)
+        {
+            matrixMidSideRows(wetData, num, static_cast<SampleType>(1.0));
+        }
+
+        forEachGroup(numBufferChannels, [&](int group, int firstChannel, int groupChannels)
+        {
+            auto state = loadGroupState(group);
+            for (int i = 0; i < num; ++i)
+            {
+                auto wet = gather(wetData, firstChannel, groupChannels, i);
+                if (midSide && lanes > 1)
+                {
+                    wet = decodeMidSide(wet);
+                }
+                const auto dry = gather(channelData, firstChannel, groupChannels, start + i);
+                scatter(channelData, firstChannel, groupChannels, start + i, outputStage(state, wet, dry, group, useDryDelay, i));
+            }
+            storeGroupState(group, state);
+        });
+    }
+
+    template <bool multiband, Topology topology>
+    void processGainPass(SampleType* const* data, const KeyInput& keyInput, int numBufferChannels, int numFrames, int rampShift, bool linked,
+                         const FrameParameters& params, const BandFrameParameters& bandParams) noexcept
+    {
+        const auto useLookahead = lookahead.getDelay() > 0;
+
+        forEachGroup(numBufferChannels, [&](int group, int firstChannel, int groupChannels)
+        {
+            auto state = loadGroupState(group);
+            auto keyState = keyFilter.load(group);
+            BandState bandState;
+            if (multiband)
+            {
+                loadBandState(group, bandState);
+            }
+
+            for (int i = 0; i < numFrames; ++i)
+            {
+                auto x = gather(data, firstChannel, groupChannels, i);
+                const auto key = keyStage(keyState, multiband ? x : detectorInput<topology>(state, x, i >> rampShift),
+                                          keyInput, firstChannel, groupChannels, i >> rampShift);
+
+                if (keyListen)
+                {
+                    x = useLookahead ? lookahead.delaySignal(group, key) : key;
+                }
+                else
+                {
+                    x = multiband ? multibandGainStage<topology>(state, bandState, x, key, keyInput.split, group, groupChannels, linked, useLookahead, i >> rampShift, bandParams)
+                                  : gainStage<topology>(state, x, key, group, groupChannels, linked, useLookahead, i >> rampShift, params);
+                }
+
+                scatter(data, firstChannel, groupChannels, i, x);
+            }
+
+            storeGroupState(group, state);
+            keyFilter.store(group, keyState);
+            if (multiband)
+            {
+                storeBandState(group, bandState);
+            }
+        });
+    }
+
+    //Linked gain stage for layouts that span several registers: every channel is measured first,
+    //the levels are maxed within each link group, then the gains are computed
+    template <bool multiband>
+    void processLinkedGainPass(SampleType* const* data, const KeyInput& keyInput, int numBufferChannels, int numFrames, int rampShift,
+                               const FrameParameters& params, const BandFrameParameters& bandParams) noexcept
+    {
+        const auto useLookahead = lookahead.getDelay() > 0;
+        auto* const* levelRows = levelScratch.getArrayOfWritePointers();
+
+        forEachGroup(numBufferChannels, [&](int group, int firstChannel, int groupChannels)
+        {
+            auto keyState = keyFilter.load(group);
+            BandState bandState;
+            if (multiband)
+            {
+                loadBandState(group, bandState);
+            }
+
+            for (int i = 0; i < numFrames; ++i)
+            {
+                const auto x = gather(data, firstChannel, groupChannels, i);
+                const auto key = keyStage(keyState, x, keyInput, firstChannel, groupChannels, i >> rampShift);
+
+                if (keyListen)
+                {
+                    scatter(data, firstChannel, groupChannels, i, useLookahead ? lookahead.delaySignal(group, key) : key);
+                }
+                else if (multiband)
+                {
+                    BandFrames frames;
+                    splitBands<Topology::feedForward>(bandState, x, key, keyInput.split, group, groupChannels, i >> rampShift, frames);
+                    storeBandFrames(group, groupChannels, i, frames);
+                }
+                else
+                {
+                    scatter(levelRows, firstChannel, groupChannels, i, detector.process(group, key));
+                }
+            }
+
+            keyFilter.store(group, keyState);
+            if (multiband)
+            {
+                storeBandState(group, bandState);
+            }
+        });
+
+        if (keyListen)
+        {
+            return;
+        }
+
+        if (multiband)
+        {
+            linkBandLevels(numBufferChannels, numFrames, 0, rampShift);
+        }
+        else
+        {
+            linkLevels(levelRows, numBufferChannels, numFrames, 0, rampShift);
+        }
+
+        forEachGroup(numBufferChannels, [&](int group, int firstChannel, int groupChannels)
+        {
+            auto state = loadGroupState(group);
+            BandState bandState;
+            if (multiband)
+            {
+                loadBandState(group, bandState);
+            }
+
+            for (int i = 0; i < numFrames; ++i)
+            {
+                auto x = gather(data, firstChannel, groupChannels, i);
+
+                if (multiband)
+                {
+                    BandFrames frames;
+                    loadBandFrames(group, groupChannels, i, frames);
+                    x = compressBands<Topology::feedForward>(state, bandState, frames, group, groupChannels, useLookahead, i >> rampShift, bandParams);
+                }
+                else
+                {
+                    const auto level = gather(levelRows, firstChannel, groupChannels, i);
+                    x = compressStage<Topology::feedForward>(state, x, level, group, groupChannels, false, useLookahead, i >> rampShift, params);
+                }
+
+                scatter(data, firstChannel, groupChannels, i, x);
+            }
+
+            storeGroupState(group, state);
+            if (multiband)
+            {
+                storeBandState(group, bandState);
+            }
+        });
+    }
+
+    //Same for feedback and hybrid: the levels need the last output, so the groups take turns frame by frame.
+    //Each frame's levels are linked in column 0 of the scratch.
+    template <bool multiband, Topology topology>
+    void processLinkedFeedbackPass(SampleType* const* data, const KeyInput& keyInput, int numBufferChannels, int numFrames, int rampShift,
+                                   const FrameParameters& params, const BandFrameParameters& bandParams) noexcept
+    {
+        const auto useLookahead = lookahead.getDelay() > 0;
+        auto* const* levelRows = levelScratch.getArrayOfWritePointers();
+
+        GroupState states[maxGroups];
+        KeyState keyStates[maxGroups];
+        BandState bandStates[maxGroups];
+        forEachGroup(numBufferChannels, [&](int group, int, int)
+        {
+            states[group] = loadGroupState(group);
+            keyStates[group] = keyFilter.load(group);
+            if (multiband)
+            {
+                loadBandState(group, bandStates[group]);
+            }
+        });
+
+        for (int i = 0; i < numFrames; ++i)
+        {
+            const auto rampIndex = i >> rampShift;
+
+            forEachGroup(numBufferChannels, [&](int group, int firstChannel, int groupChannels)
+            {
+                const auto x = gather(data, firstChannel, groupChannels, i);
+                if (multiband)
+                {
+                    const auto key = keyStage(keyStates[group], x, keyInput, firstChannel, groupChannels, rampIndex);
+                    BandFrames frames;
+                    splitBands<topology>(bandStates[group], x, key, keyInput.split, group, groupChannels, rampIndex, frames);
+                    storeBandFrames(group, groupChannels, 0, frames);
+                }
+                else
+                {
+                    const auto key = keyStage(keyStates[group], detectorInput<topology>(states[group], x, rampIndex), keyInput, firstChannel, groupChannels, rampIndex);
+                    scatter(levelRows, firstChannel, groupChannels, 0, detector.process(group, key));
+                }
+            });
+
+            if (multiband)
+            {
+                linkBandLevels(numBufferChannels, 1, i, rampShift);
+            }
+            else
+            {
+                linkLevels(levelRows, numBufferChannels, 1, i, rampShift);
+            }
+
+            forEachGroup(numBufferChannels, [&](int group, int firstChannel, int groupChannels)
+            {
+                auto x = gather(data, firstChannel, groupChannels, i);
+                if (multiband)
+                {
+                    BandFrames frames;
+                    loadBandFrames(group, groupChannels, 0, frames);
+                    x = compressBands<topology>(states[group], bandStates[group], frames, group, groupChannels, useLookahead, rampIndex, bandParams);
+                }
+                else
+                {
+                    x = compressStage<topology>(states[group], x, gather(levelRows, firstChannel, groupChannels, 0), group, groupChannels, false, useLookahead, rampIndex, params);
+                }
+                scatter(data, firstChannel, groupChannels, i, x);
+            });
+        }
+
+        forEachGroup(numBufferChannels, [&](int group, int, int)
+        {
+            storeGroupState(group, states[group]);
+            keyFilter.store(group, keyStates[group]);
+            if (multiband)
+            {
+                storeBandState(group, bandStates[group]);
+            }
+        });
+    }
+
+    //Each member of a link group pulled towards the group's loudest level, a register of frames at a time.
+    //Column 0 of the rows is frame firstFrame of the pass, for the link amount ramp.
+    void linkLevels(SampleType* const* levelRows, int numBufferChannels, int numFrames, int firstFrame, int rampShift) const noexcept
+    {
+        for (int linkGroup = 0; linkGroup < numLinkGroups; ++linkGroup)
+        {
+            const auto* members = linkMembers + linkGroupStarts[linkGroup];
+            const auto numMembers = linkGroupStarts[linkGroup + 1] - linkGroupStarts[linkGroup];
+
+            for (int i = 0; i < numFrames; i += lanes)
+            {
+                auto loudest = Vec::expand(SampleType());
+                for (int member = 0; member < numMembers; ++member)
+                {
+                    if (members[member] < numBufferChannels)
+                    {
+                        loudest = Vec::max(loudest, KcompSIMD::load(levelRows[members[member]] + i));
+                    }
+                }
+
+                //the frames run along the lanes here, so each lane has its own point on the ramp
+                auto unlinked = Vec::expand(SampleType());
+                if (! fullyLinked)
+                {
+                    SampleType amounts[lanes];
+                    for (int lane = 0; lane < lanes; ++lane)
+                    {
+                        amounts[lane] = static_cast<SampleType>(1.0) - linkAmounts[juce::jmin((firstFrame + i + lane) >> rampShift, subBlockSize - 1)];
+                    }
+                    unlinked = KcompSIMD::load(amounts);
+                }
+
+                for (int member = 0; member < numMembers; ++member)
+                {
+                    if (members[member] < numBufferChannels)
+                    {
+                        auto* levels = levelRows[members[member]] + i;
+                        KcompSIMD::store(levels, fullyLinked ? loudest : loudest + (KcompSIMD::load(levels) - loudest) * unlinked);
+                    }
+                }
+            }
+        }
+    }
+
+    //Same per band, the bands of a channel are already side by side in the lanes
+    void linkBandLevels(int numBufferChannels, int numFrames, int firstFrame, int rampShift) noexcept
+    {
+        for (int linkGroup = 0; linkGroup < numLinkGroups; ++linkGroup)
+        {
+            const auto* members = linkMembers + linkGroupStarts[linkGroup];
+            const auto numMembers = linkGroupStarts[linkGroup + 1] - linkGroupStarts[linkGroup];
+
+            for (int bandGroup = 0; bandGroup < maxBandGroups; ++bandGroup)
+            {
+                for (int i = 0; i < numFrames; ++i)
+                {
+                    auto loudest = Vec::expand(SampleType());
+                    for (int member = 0; member < numMembers; ++member)
+                    {
+                        if (members[member] < numBufferChannels)
+                        {
+                            loudest = Vec::max(loudest, KcompSIMD::load(getBandFrame(bandLevelScratch, members[member], bandGroup, i)));
+                        }
+                    }
+                    for (int member = 0; member < numMembers; ++member)
+                    {
+                        if (members[member] < numBufferChannels)
+                        {
+                            auto* levels = getBandFrame(bandLevelScratch, members[member], bandGroup, i);
+                            KcompSIMD::store(levels, linkLevel(KcompSIMD::load(levels), loudest, (firstFrame + i) >> rampShift));
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    SampleType* getBandFrame(std::vector<SampleType>& scratch, int channel, int bandGroup, int i) noexcept
+    {
+        return scratch.data() + size_t(((channel * maxBandGroups + bandGroup) * maxDetectorFrames + i) * lanes);
+    }
+
+    void storeBandFrames(int group, int groupChannels, int i, const BandFrames& frames) noexcept
+    {
+        for (int channel = 0; channel < groupChannels; ++channel)
+        {
+            for (int bandGroup = 0; bandGroup < maxBandGroups; ++bandGroup)
+            {
+                KcompSIMD::store(getBandFrame(bandSignalScratch, group * lanes + channel, bandGroup, i), frames.signals[channel][bandGroup]);
+                KcompSIMD::store(getBandFrame(bandLevelScratch, group * lanes + channel, bandGroup, i), frames.levels[channel][bandGroup]);
+            }
+        }
+    }
+
+    void loadBandFrames(int group, int groupChannels, int i, BandFrames& frames) noexcept
+    {
+        for (int channel = 0; channel < groupChannels; ++channel)
+        {
+            for (int bandGroup = 0; bandGroup < maxBandGroups; ++bandGroup)
+            {
+                frames.signals[channel][bandGroup] = KcompSIMD::load(getBandFrame(bandSignalScratch, group * lanes + channel, bandGroup, i));
+                frames.levels[channel][bandGroup] = KcompSIMD::load(getBandFrame(bandLevelScratch, group * lanes + channel, bandGroup, i));
+            }
+        }
+    }
+
+    double sampleRate{ 44100.0 };
+    int numChannels{ 0 };
+    int numGroups{ 0 };
+
+    Smoother inputGain{ 1 }, makeUpGain{ 1 }, outputGain{ 1 };
+    Smoother dryVolume{ 0 }, wetVolume{ 1 };
+    Smoother log2Threshold{ 0 };
+    Smoother attackTime{ 1 }, releaseTime{ 100 };
+    bool autoTiming{ false };
+    typename KcompCompressor<SampleType>::AutoConstants autoConstants;
+
+    //per-sample ramp values for the current sub-block
+    SampleType inputGains[subBlockSize]{}, makeUpGains[subBlockSize]{}, outputGains[subBlockSize]{};
+    SampleType dryGains[subBlockSize]{}, wetGains[subBlockSize]{};
+    SampleType log2Thresholds[subBlockSize]{};
+
+    //bypass crossfade, 1 is fully bypassed
+    Smoother bypassMix{ 0 };
+    SampleType bypassGains[subBlockSize]{};
+    bool crossfadeBypass{ false }, bypassedLastBlock{ false };
+    int bypassHoldSamples{ 0 };
+
+    int quietSamples{ 0 };
+    bool sleeping{ false };
+
+    bool tameEnabled{ false }, tameDynamic{ false };
+    KcompTame<SampleType> tame;
+    KcompCompressor<SampleType> tameCompressor;
+    Smoother tameLog2Threshold{ 0 };
+    SampleType tameLog2Thresholds[subBlockSize]{};
+    FrameParameters tameParams;
+
+    KcompCompressor<SampleType> compressor;
+
+    //[0] is the single-band compressor and band 1, crossfades run from 0 (previous curve) to 1
+    KcompTransferCurve<SampleType> transferCurves[maxBands];
+    Smoother curveFades[maxBands];
+    SampleType curveFadeGains[subBlockSize]{};
+    Curve mainCurve;
+
+    KcompLookahead<SampleType> lookahead;
+    SampleType lookaheadMs{ 0 };
+
+    //[IIR, FIR][order - 1]
+    std::unique_ptr<juce::dsp::Oversampling<SampleType>> oversamplers[2][maxOversamplingOrder];
+    juce::dsp::Oversampling<SampleType>* oversampler = nullptr;
+    int oversamplingLatencies[2][maxOversamplingOrder + 1]{};
+    juce::AudioBuffer<SampleType> wetScratch;
+    int oversamplingOrder{ 0 }, activeOversamplingOrder{ 0 };
+    bool linearPhaseOversampling{ false };
+    int activeOversamplingType{ 0 };
+
+    KcompFrameDelay<SampleType> dryDelay;
+
+    KcompCrossover<SampleType> crossover, keyCrossover;
+    KcompCompressor<SampleType> bandCompressors[maxBands];
+    Smoother bandLog2Thresholds[maxBands], bandAttackTimes[maxBands], bandReleaseTimes[maxBands];
+    std::vector<SampleType> bandEnvelopes, bandAutoStates;
+    KcompLookahead<SampleType> bandLookahead;
+    SampleType bandMinGains[maxBandGroups * lanes]{};
+
+    KcompKeyFilter<SampleType> keyFilter;
+    bool keyListen{ false };
+
+    KcompDetector<SampleType> detector, bandDetector;
+
+    //feedback and hybrid: the last output of every channel and of every band of every channel
+    Topology requestedTopology{ Topology::feedForward }, activeTopology{ Topology::feedForward };
+    Smoother feedbackMix{ 0.5 };
+    SampleType feedbackMixes[subBlockSize]{};
+    std::vector<SampleType> feedbackFrames, bandFeedback;
+
+    //link groups as runs in linkMembers, linkGroupStarts[numLinkGroups] is one past the last member
+    int linkGroupOfChannel[maxChannels]{};
+    int linkMembers[maxChannels]{};
+    int linkGroupStarts[4]{};
+    int numLinkGroups{ 0 };
+    bool linkFitsRegister{ true };
+
+    //scheduleParameters(): the ramped parameters glide from glideStart to glideEnd over one process() call
+    Parameters glideStart, glideEnd;
+    bool gliding{ false };
+    int defaultRampSamples{ 0 }, targetRampSamples{ 0 };      //samples to rampLengthSeconds, what setTargets() ramps over now
+
+    //link amount, fullyLinked while it sits at 100 % and the plain shared detector does
+    Smoother linkAmount{ 1 };
+    SampleType linkAmounts[subBlockSize]{};
+    bool fullyLinked{ true };
+
+    StereoMode stereoMode{ StereoMode::leftRight };
+    bool midSide{ false };      //M/S this block, only with two channels
+
+    //detector levels of the whole sub-block for links across registers, channel rows / [channel][band group][frame] registers
+    juce::AudioBuffer<SampleType> levelScratch;
+    std::vector<SampleType> bandSignalScratch, bandLevelScratch;
+
+    //meter taps, summed inside the sample loop
+    KcompLevelStats<SampleType> inputLevels, outputLevels;
+
+    //lowest gain of each channel in the current sub-block
+    std::vector<SampleType> appliedGains;
+    KcompGainFifo* gainFifo = nullptr;
+
+    //loudness: K-weighting inside the sample loop, the channel-weighted power of each sub-block goes to the meters
+    KcompKWeighting<SampleType> inputKWeighting, outputKWeighting;
+    SampleType loudnessWeights[maxGroups * lanes]{};
+    double inputLoudnessSum{ 0.0 }, outputLoudnessSum{ 0.0 };
+    KcompLoudnessMeter* inputLoudness = nullptr;
+    KcompLoudnessMeter* outputLoudness = nullptr;
+    bool measureLoudness{ false };
+
+    //true peak of the output, oversampled inside the sample loop
+    KcompTruePeak<SampleType> truePeak;
+    std::vector<SampleType> outputTruePeaks;
+    bool measureTruePeak{ false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(KcompEngine)
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    The gain the compressor actually applied, from the audio thread to
+    whoever draws or analyses it. The engine pushes one Frame per sub-block
+    holding the lowest gain of each channel over those samples, so the
+    meters see every peak of gain reduction without getting every sample.
+
+    One writer, one reader, no locks: juce::AbstractFifo over storage that
+    is allocated once in the constructor. When the reader falls behind,
+    push() drops the new frame instead of waiting and counts it.
+*/
+class KcompGainFifo
+{
+public:
+
+    static constexpr int maxChannels = 16;
+
+    struct Frame
+    {
+        float gains[maxChannels];   //linear, 1 is no reduction
+        int numChannels;
+        int numSamples;             //how many samples the frame covers
+    };
+
+    //2048 frames of 32 samples is about 1.4 s at 48 kHz, plenty for a 30 Hz reader
+    explicit KcompGainFifo(int capacity = 2048)
+        : fifo(capacity),
+          frames(size_t(capacity))
+    {
+    }
+
+    //==============================================================================
+    //Writer: false when the reader is too far behind, the frame is dropped
+    template <typename SampleType>
+    bool push(const SampleType* gains, int numChannels, int numSamples) noexcept
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite(1, start1, size1, start2, size2);
+
+        if (size1 < 1)
+        {
+            numDropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        auto& frame = frames[size_t(start1)];
+        frame.numChannels = juce::jmin(numChannels, maxChannels);
+        frame.numSamples = numSamples;
+        for (int channel = 0; channel < frame.numChannels; ++channel)
+        {
+            frame.gains[channel] = float(gains[channel]);
+        }
+
+        fifo.finishedWrite(1);
+        return true;
+    }
+
+    //==============================================================================
+    //Reader: calls readFrame(const Frame&) for everything pushed so far, oldest first, returns how many
+    template <typename FrameReader>
+    int read(FrameReader&& readFrame) noexcept
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead(fifo.getNumReady(), start1, size1, start2, size2);
+
+        for (int i = 0; i < size1; ++i)
+        {
+            readFrame(frames[size_t(start1 + i)]);
+        }
+        for (int i = 0; i < size2; ++i)
+        {
+            readFrame(frames[size_t(start2 + i)]);
+        }
+
+        fifo.finishedRead(size1 + size2);
+        return size1 + size2;
+    }
+
+    int getNumReady() const noexcept        { return fifo.getNumReady(); }
+
+    //Frames push() had to throw away since the last call, reader only
+    int getAndClearNumDropped() noexcept    { return numDropped.exchange(0, std::memory_order_relaxed); }
+
+private:
+
+    juce::AbstractFifo fifo;
+    std::vector<Frame> frames;
+    std::atomic<int> numDropped{ 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(KcompGainFifo)
+};
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "KcompSIMD.h"
+
+//==============================================================================
+/*
+    High-pass and low-pass (12 dB/oct, Butterworth) for the detector key,
+    channels in SIMD lanes. Both are TPT state variable filters, so the
+    cutoffs can move every block without zipper noise or blowing up.
+
+    A cutoff of 0 switches that filter off. It runs at whatever rate the
+    detector runs at, KcompEngine sets that with setSampleRate().
+*/
+template <typename SampleType>
+class KcompKeyFilter
+{
+public:
+
+    using Vec = KcompSIMD::Register<SampleType>;
+    static constexpr int lanes = int(Vec::SIMDNumElements);
+
+    struct State
+    {
+        Vec highPass[2], lowPass[2];
+    };
+
+    void prepare(int newNumGroups)
+    {
+        numGroups = newNumGroups;
+        states.assign(size_t(numGroups * 4 * lanes), SampleType());
+        reset();
+    }
+
+    void reset()
+    {
+        std::fill(states.begin(), states.end(), SampleType());
+    }
+
+    void setSampleRate(double newSampleRate)
+    {
+        if (sampleRate != newSampleRate)
+        {
+            sampleRate = newSampleRate;
+            update();
+        }
+    }
+
+    void setCutoffs(SampleType newHighPassHz, SampleType newLowPassHz)
+    {
+        if (highPassHz != newHighPassHz || lowPassHz != newLowPassHz)
+        {
+            highPassHz = newHighPassHz;
+            lowPassHz = newLowPassHz;
+            update();
+        }
+    }
+
+    bool isActive() const noexcept      { return highPassOn || lowPassOn; }
+
+    State load(int group) const noexcept
+    {
+        const auto* source = states.data() + size_t(group * 4 * lanes);
+        return { { KcompSIMD::load(source), KcompSIMD::load(source + lanes) },
+                 { KcompSIMD::load(source + 2 * lanes), KcompSIMD::load(source + 3 * lanes) } };
+    }
+
+    void store(int group, const State& state) noexcept
+    {
+        auto* destination = states.data() + size_t(group * 4 * lanes);
+        KcompSIMD::store(destination, state.highPass[0]);
+        KcompSIMD::store(destination + lanes, state.highPass[1]);
+        KcompSIMD::store(destination + 2 * lanes, state.lowPass[0]);
+        KcompSIMD::store(destination + 3 * lanes, state.lowPass[1]);
+    }
+
+    forcedinline Vec process(State& state, Vec x) const noexcept
+    {
+        if (highPassOn)
+        {
+            Vec band, low;
+            tick(state.highPass, highPass, x, band, low);
+            x = x - Vec::expand(k) * band - low;
+        }
+
+        if (lowPassOn)
+        {
+            Vec band;
+            tick(state.lowPass, lowPass, x, band, x);
+        }
+
+        return x;
+    }
+
+private:
+
+    static constexpr SampleType k = static_cast<SampleType>(1.4142135623730951);
+
+    struct Coefficients
+    {
+        SampleType a1{}, a2{}, a3{};
+    };
+
+    static forcedinline void tick(Vec* s, const Coefficients& c, Vec x, Vec& band, Vec& low) noexcept
+    {
+        const auto v3 = x - s[1];
+        band = Vec::expand(c.a1) * s[0] + Vec::expand(c.a2) * v3;
+        low = s[1] + Vec::expand(c.a2) * s[0] + Vec::expand(c.a3) * v3;
+        s[0] = band + band - s[0];
+        s[1] = low + low - s[1];
+    }
+
+    Coefficients makeCoefficients(SampleType frequency) const
+    {
+        frequency = juce::jlimit(static_cast<SampleType>(10.0), static_cast<SampleType>(sampleRate * 0.49), frequency);
+        const auto g = static_cast<SampleType>(std::tan(juce::MathConstants<double>::pi * frequency / sampleRate));
+
+        Coefficients c;
+        c.a1 = static_cast<SampleType>(1.0) / (static_cast<SampleType>(1.0) + g * (g + k));
+        c.a2 = g * c.a1;
+        c.a3 = g * c.a2;
+        return c;
+    }
+
+    void update()
+    {
+        highPassOn = highPassHz > SampleType() && sampleRate > 0.0;
+        lowPassOn = lowPassHz > SampleType() && sampleRate > 0.0;
+
+        if (highPassOn)
+        {
+            highPass = makeCoefficients(highPassHz);
+        }
+        if (lowPassOn)
+        {
+            lowPass = makeCoefficients(lowPassHz);
+        }
+    }
+
+    double sampleRate{ 0.0 };
+    int numGroups{ 0 };
+
+    SampleType highPassHz{ 0 }, lowPassHz{ 0 };
+    bool highPassOn{ false }, lowPassOn{ false };
+    Coefficients highPass, lowPass;
+
+    std::vector<SampleType> states;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(KcompKeyFilter)
+};
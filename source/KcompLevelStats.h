@@ -0,0 +1,214 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "KcompSIMD.h"
+
+//==============================================================================
+/*
+    Level statistics for the meter taps: peak, RMS, DC offset and crest factor
+    of each channel, all from one look at every sample.
+
+    Sums of squares and sums go into doubles a sub-block at a time, so long
+    blocks don't lose the quiet end of the signal to float rounding. finish()
+    turns them into levels once the block is done, endSubBlock() keeps the
+    sums of squares of each sub-block for the meter's RMS window.
+
+    measure() is the same thing for a buffer that is already written out,
+    one channel at a time, SIMD across the samples.
+
+    Levels are linear, the crest factor is peak over RMS (0 for silence).
+*/
+template <typename SampleType>
+class KcompLevelStats
+{
+public:
+
+    using Vec = KcompSIMD::Register<SampleType>;
+    static constexpr int lanes = int(Vec::SIMDNumElements);
+
+    //One register's worth of running statistics, one channel per lane
+    struct Accumulator
+    {
+        Vec peak, sumOfSquares, sum;
+
+        forcedinline void add(Vec x) noexcept
+        {
+            peak = Vec::max(peak, KcompSIMD::abs(x));
+            sumOfSquares += x * x;
+            sum += x;
+        }
+    };
+
+    //Levels of one channel
+    struct Levels
+    {
+        SampleType peak{}, rms{}, dcOffset{}, crestFactor{};
+    };
+
+    //numLanes a whole number of registers, maxSubBlocks the most endSubBlock() calls a block will have
+    void prepare(int numLanes, int maxSubBlocks = 1)
+    {
+        jassert(numLanes % lanes == 0);
+
+        const auto size = size_t(numLanes);
+        peaks.assign(size, SampleType());
+        rmsLevels.assign(size, SampleType());
+        dcOffsets.assign(size, SampleType());
+        crestFactors.assign(size, SampleType());
+        sumsOfSquares.assign(size, 0.0);
+        sums.assign(size, 0.0);
+        subBlockStarts.assign(size, 0.0);
+        subBlockSumsOfSquares.assign(size * size_t(juce::jmax(1, maxSubBlocks)), 0.0);
+        subBlockLengths.assign(size_t(juce::jmax(1, maxSubBlocks)), 0);
+        numSubBlocks = 0;
+    }
+
+    void reset() noexcept
+    {
+        std::fill(peaks.begin(), peaks.end(), SampleType());
+        std::fill(rmsLevels.begin(), rmsLevels.end(), SampleType());
+        std::fill(dcOffsets.begin(), dcOffsets.end(), SampleType());
+        std::fill(crestFactors.begin(), crestFactors.end(), SampleType());
+        std::fill(sumsOfSquares.begin(), sumsOfSquares.end(), 0.0);
+        std::fill(sums.begin(), sums.end(), 0.0);
+        std::fill(subBlockStarts.begin(), subBlockStarts.end(), 0.0);
+        numSubBlocks = 0;
+    }
+
+    //==============================================================================
+    //For the engine's sample loop: the peak carries on from what was stored, the sums start at 0 for each pass
+    Accumulator load(int group) const noexcept
+    {
+        Accumulator accumulator;
+        accumulator.peak = KcompSIMD::load(peaks.data() + size_t(group * lanes));
+        accumulator.sumOfSquares = Vec::expand(SampleType());
+        accumulator.sum = Vec::expand(SampleType());
+        return accumulator;
+    }
+
+    void store(int group, const Accumulator& accumulator) noexcept
+    {
+        const auto offset = size_t(group * lanes);
+        KcompSIMD::store(peaks.data() + offset, accumulator.peak);
+
+        SampleType laneSumsOfSquares[lanes], laneSums[lanes];
+        KcompSIMD::store(laneSumsOfSquares, accumulator.sumOfSquares);
+        KcompSIMD::store(laneSums, accumulator.sum);
+        for (int lane = 0; lane < lanes; ++lane)
+        {
+            sumsOfSquares[offset + size_t(lane)] += laneSumsOfSquares[lane];
+            sums[offset + size_t(lane)] += laneSums[lane];
+        }
+    }
+
+    //The levels of everything stored since reset(), over numSamples samples
+    void finish(int numSamples) noexcept
+    {
+        for (size_t lane = 0; lane < peaks.size(); ++lane)
+        {
+            const auto levels = getLevels(peaks[lane], sumsOfSquares[lane], sums[lane], numSamples);
+            rmsLevels[lane] = levels.rms;
+            dcOffsets[lane] = levels.dcOffset;
+            crestFactors[lane] = levels.crestFactor;
+        }
+    }
+
+    //Keeps the sums of squares stored since the last call as one sub-block of num samples. A block with more
+    //sub-blocks than prepare() was told about adds the rest to its last one.
+    void endSubBlock(int num) noexcept
+    {
+        const auto maxSubBlocks = int(subBlockLengths.size());
+        const auto index = juce::jmin(numSubBlocks, maxSubBlocks - 1);
+        const auto size = sumsOfSquares.size();
+        auto* row = subBlockSumsOfSquares.data() + size_t(index) * size;
+
+        if (index == numSubBlocks)
+        {
+            std::fill(row, row + size, 0.0);
+            subBlockLengths[size_t(index)] = 0;
+            ++numSubBlocks;
+        }
+
+        for (size_t lane = 0; lane < size; ++lane)
+        {
+            row[lane] += sumsOfSquares[lane] - subBlockStarts[lane];
+            subBlockStarts[lane] = sumsOfSquares[lane];
+        }
+        subBlockLengths[size_t(index)] += num;
+    }
+
+    const SampleType* getPeaks() const noexcept             { return peaks.data(); }
+    const SampleType* getRMSLevels() const noexcept         { return rmsLevels.data(); }
+    const SampleType* getDCOffsets() const noexcept         { return dcOffsets.data(); }
+    const SampleType* getCrestFactors() const noexcept      { return crestFactors.data(); }
+
+    //The sub-blocks since reset(), one row of sums of squares per sub-block with a value for each lane
+    int getNumSubBlocks() const noexcept                    { return numSubBlocks; }
+    int getNumLanes() const noexcept                        { return int(sumsOfSquares.size()); }
+    const double* getSubBlockSumsOfSquares() const noexcept { return subBlockSumsOfSquares.data(); }
+    const int* getSubBlockLengths() const noexcept          { return subBlockLengths.data(); }
+
+    //==============================================================================
+    //One pass over numSamples samples of one channel
+    static Levels measure(const SampleType* data, int numSamples) noexcept
+    {
+        auto peak = SampleType();
+        auto sumOfSquares = 0.0, sum = 0.0;
+
+        //two accumulators so the adds don't wait on each other, flushed to the doubles every chunk
+        constexpr int chunkSize = 256;
+        int i = 0;
+        while (i + 2 * lanes <= numSamples)
+        {
+            Accumulator a{ Vec::expand(SampleType()), Vec::expand(SampleType()), Vec::expand(SampleType()) };
+            auto b = a;
+
+            const auto chunkEnd = juce::jmin(numSamples, i + chunkSize) - 2 * lanes;
+            for (; i <= chunkEnd; i += 2 * lanes)
+            {
+                a.add(KcompSIMD::load(data + i));
+                b.add(KcompSIMD::load(data + i + lanes));
+            }
+
+            peak = juce::jmax(peak, KcompSIMD::horizontalMax(Vec::max(a.peak, b.peak), lanes));
+            sumOfSquares += double((a.sumOfSquares + b.sumOfSquares).sum());
+            sum += double((a.sum + b.sum).sum());
+        }
+
+        for (; i < numSamples; ++i)
+        {
+            const auto x = data[i];
+            peak = juce::jmax(peak, std::abs(x));
+            sumOfSquares += double(x * x);
+            sum += double(x);
+        }
+
+        return getLevels(peak, sumOfSquares, sum, numSamples);
+    }
+
+    static Levels getLevels(SampleType peak, double sumOfSquares, double sum, int numSamples) noexcept
+    {
+        Levels levels;
+        levels.peak = peak;
+        if (numSamples > 0)
+        {
+            levels.rms = static_cast<SampleType>(std::sqrt(sumOfSquares / numSamples));
+            levels.dcOffset = static_cast<SampleType>(sum / numSamples);
+        }
+        if (levels.rms > SampleType())
+        {
+            levels.crestFactor = peak / levels.rms;
+        }
+        return levels;
+    }
+
+private:
+
+    std::vector<SampleType> peaks, rmsLevels, dcOffsets, crestFactors;
+    std::vector<double> sumsOfSquares, sums;
+    std::vector<double> subBlockStarts, subBlockSumsOfSquares;      //sumsOfSquares when the sub-block began, [sub-block][lane]
+    std::vector<int> subBlockLengths;
+    int numSubBlocks{ 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(KcompLevelStats)
+};
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "KcompSIMD.h"
+
+//==============================================================================
+/*
+    Circular delay line for whole SIMD frames, one line per channel group.
+    Frames are stored interleaved, so a delayed frame is one load and one store.
+*/
+template <typename SampleType>
+class KcompFrameDelay
+{
+public:
+
+    using Vec = KcompSIMD::Register<SampleType>;
+    static constexpr int lanes = int(Vec::SIMDNumElements);
+
+    void prepare(int newNumGroups, int maxDelaySamples)
+    {
+        numGroups = newNumGroups;
+        capacity = maxDelaySamples + 1;
+
+        frames.assign(size_t(numGroups * capacity * lanes), SampleType());
+        writePositions.assign(size_t(numGroups), 0);
+
+        delay = juce::jmin(delay, capacity - 1);
+        reset();
+    }
+
+    void reset()
+    {
+        std::fill(frames.begin(), frames.end(), SampleType());
+        std::fill(writePositions.begin(), writePositions.end(), 0);
+    }
+
+    //Only moves the read position, the line always holds the last capacity frames
+    void setDelay(int newDelaySamples)
+    {
+        delay = juce::jlimit(0, juce::jmax(0, capacity - 1), newDelaySamples);
+    }
+
+    int getDelay() const noexcept       { return delay; }
+
+    forcedinline Vec process(int group, Vec x) noexcept
+    {
+        auto& writePos = writePositions[size_t(group)];
+        auto* line = frames.data() + size_t(group * capacity * lanes);
+        const auto readPos = writePos >= delay ? writePos - delay : writePos - delay + capacity;
+
+        KcompSIMD::store(line + writePos * lanes, x);
+        x = KcompSIMD::load(line + readPos * lanes);
+
+        writePos = writePos + 1 < capacity ? writePos + 1 : 0;
+        return x;
+    }
+
+private:
+
+    int numGroups{ 0 };
+    int capacity{ 1 };
+    int delay{ 0 };
+
+    std::vector<SampleType> frames;
+    std::vector<int> writePositions;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(KcompFrameDelay)
+};
+
+//==============================================================================
+/*
+    Lookahead stage for the fused engine.
+
+    The signal going into the gain stage is delayed by the lookahead length,
+    while the detector sees the loudest level of the last delay + 1 samples.
+    The gain computer reacts to a transient by the time it comes out of the
+    delay line, so even a few ms of attack can catch it. The dry signal has to
+    be delayed by the caller (KcompEngine does it at the base rate).
+
+    The sliding maximum is a monotonic deque per lane: every level is pushed
+    and popped at most once, so the cost per sample doesn't depend on the
+    window size. Everything is allocated in prepare() for the longest delay.
+*/
+template <typename SampleType>
+class KcompLookahead
+{
+public:
+
+    using Vec = KcompSIMD::Register<SampleType>;
+    static constexpr int lanes = int(Vec::SIMDNumElements);
+
+    void prepare(int newNumGroups, int maxDelaySamples)
+    {
+        numGroups = newNumGroups;
+        capacity = maxDelaySamples + 1;
+
+        const auto size = size_t(numGroups * lanes * capacity);
+        dequeValues.assign(size, SampleType());
+        dequeTimes.assign(size, 0);
+
+        dequeFronts.assign(size_t(numGroups * lanes), 0);
+        dequeSizes.assign(size_t(numGroups * lanes), 0);
+        sampleCounters.assign(size_t(numGroups), 0);
+
+        signalDelay.prepare(numGroups, maxDelaySamples);
+        reset();
+    }
+
+    void reset()
+    {
+        std::fill(dequeSizes.begin(), dequeSizes.end(), 0);
+        signalDelay.reset();
+    }
+
+    //The deques keep their levels, the next push drops whatever falls out of a shorter window
+    void setDelay(int newDelaySamples)
+    {
+        signalDelay.setDelay(newDelaySamples);
+    }
+
+    int getDelay() const noexcept       { return signalDelay.getDelay(); }
+
+    //Delays one frame of the signal and replaces level with the maximum over the window.
+    //With a shared detector every lane holds the same level, so only the first lane runs the deque.
+    forcedinline void process(int group, int numActiveLanes, bool sharedDetector, Vec& signal, Vec& level) noexcept
+    {
+        signal = signalDelay.process(group, signal);
+
+        SampleType levels[lanes];
+        KcompSIMD::store(levels, level);
+
+        const auto now = sampleCounters[size_t(group)]++;
+        const auto numDeques = sharedDetector ? 1 : numActiveLanes;
+
+        for (int lane = 0; lane < numDeques; ++lane)
+        {
+            levels[lane] = pushLevel(group * lanes + lane, levels[lane], now);
+        }
+
+        level = sharedDetector ? Vec::expand(levels[0]) : KcompSIMD::load(levels);
+    }
+
+    //Only the delay, for a signal that skips the gain stage but has to stay in time with it
+    forcedinline Vec delaySignal(int group, Vec signal) noexcept
+    {
+        return signalDelay.process(group, signal);
+    }
+
+private:
+
+    //Monotonic deque: values decrease from front to back, the front is the window maximum
+    SampleType pushLevel(int lane, SampleType value, juce::uint32 now) noexcept
+    {
+        const auto line = size_t(lane * capacity);
+        const auto delay = juce::uint32(signalDelay.getDelay());
+        auto& front = dequeFronts[size_t(lane)];
+        auto& size = dequeSizes[size_t(lane)];
+
+        //out of the window first, so the deque never holds more than delay + 1 levels.
+        //Unsigned difference, so the counter is free to wrap.
+        while (size > 0 && now - dequeTimes[line + size_t(front)] > delay)
+        {
+            front = front + 1 < capacity ? front + 1 : 0;
+            --size;
+        }
+
+        //anything quieter than the new level can never be the maximum again
+        while (size > 0)
+        {
+            const auto back = front + size - 1 < capacity ? front + size - 1 : front + size - 1 - capacity;
+            if (dequeValues[line + size_t(back)] > value)
+            {
+                break;
+            }
+            --size;
+        }
+
+        const auto newBack = front + size < capacity ? front + size : front + size - capacity;
+        dequeValues[line + size_t(newBack)] = value;
+        dequeTimes[line + size_t(newBack)] = now;
+        ++size;
+
+        return dequeValues[line + size_t(front)];
+    }
+
+    int numGroups{ 0 };
+    int capacity{ 1 };
+
+    KcompFrameDelay<SampleType> signalDelay;
+
+    std::vector<SampleType> dequeValues;
+    std::vector<juce::uint32> dequeTimes;
+    std::vector<int> dequeFronts, dequeSizes;
+    std::vector<juce::uint32> sampleCounters;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(KcompLookahead)
+};
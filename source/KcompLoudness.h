@@ -0,0 +1,380 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "KcompSIMD.h"
+
+//==============================================================================
+/*
+    ITU-R BS.1770 K-weighting, channels in SIMD lanes: the head shelf and the
+    RLB high-pass as two transposed direct form II biquads.
+
+    The coefficients are worked out for the sample rate from the analog
+    prototypes, at 48 kHz they are the ones in the recommendation.
+*/
+template <typename SampleType>
+class KcompKWeighting
+{
+public:
+
+    using Vec = KcompSIMD::Register<SampleType>;
+    static constexpr int lanes = int(Vec::SIMDNumElements);
+
+    struct State
+    {
+        Vec s1[2], s2[2];
+    };
+
+    void prepare(double sampleRate, int newNumGroups)
+    {
+        numGroups = newNumGroups;
+        states.assign(size_t(numGroups * 4 * lanes), SampleType());
+
+        //shelf
+        {
+            const auto k = std::tan(juce::MathConstants<double>::pi * 1681.974450955533 / sampleRate);
+            const auto q = 0.7071752369554196;
+            const auto vh = std::pow(10.0, 3.999843853973347 / 20.0);
+            const auto vb = std::pow(vh, 0.4996667741545416);
+            const auto a0 = 1.0 + k / q + k * k;
+            setSection(0, (vh + vb * k / q + k * k) / a0, 2.0 * (k * k - vh) / a0, (vh - vb * k / q + k * k) / a0,
+                          2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0);
+        }
+
+        //RLB high-pass
+        {
+            const auto k = std::tan(juce::MathConstants<double>::pi * 38.13547087602444 / sampleRate);
+            const auto q = 0.5003270373238773;
+            const auto a0 = 1.0 + k / q + k * k;
+            setSection(1, 1.0, -2.0, 1.0, 2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0);
+        }
+    }
+
+    void reset()
+    {
+        std::fill(states.begin(), states.end(), SampleType());
+    }
+
+    State load(int group) const noexcept
+    {
+        const auto* source = states.data() + size_t(group * 4 * lanes);
+
+        State state;
+        for (int section = 0; section < 2; ++section)
+        {
+            state.s1[section] = KcompSIMD::load(source + (section * 2) * lanes);
+            state.s2[section] = KcompSIMD::load(source + (section * 2 + 1) * lanes);
+        }
+        return state;
+    }
+
+    void store(int group, const State& state) noexcept
+    {
+        auto* destination = states.data() + size_t(group * 4 * lanes);
+        for (int section = 0; section < 2; ++section)
+        {
+            KcompSIMD::store(destination + (section * 2) * lanes, state.s1[section]);
+            KcompSIMD::store(destination + (section * 2 + 1) * lanes, state.s2[section]);
+        }
+    }
+
+    //One frame from the engine's sample loop
+    forcedinline Vec process(State& state, Vec x) const noexcept
+    {
+        for (int section = 0; section < 2; ++section)
+        {
+            const auto& c = coefficients[section];
+            auto& s1 = state.s1[section];
+            auto& s2 = state.s2[section];
+
+            const auto y = Vec::expand(c.b0) * x + s1;
+            s1 = Vec::expand(c.b1) * x - Vec::expand(c.a1) * y + s2;
+            s2 = Vec::expand(c.b2) * x - Vec::expand(c.a2) * y;
+            x = y;
+        }
+
+        return x;
+    }
+
+    //BS.1770 channel weights: 1.41 for the surrounds beside the listener, nothing for the LFE, 1 for the rest
+    static SampleType getChannelWeight(juce::AudioChannelSet::ChannelType type) noexcept
+    {
+        using Set = juce::AudioChannelSet;
+
+        switch (type)
+        {
+            case Set::LFE:
+            case Set::LFE2:
+                return SampleType();
+
+            case Set::leftSurround:
+            case Set::rightSurround:
+            case Set::leftSurroundSide:
+            case Set::rightSurroundSide:
+                return static_cast<SampleType>(1.41);
+
+            default:
+                return static_cast<SampleType>(1.0);
+        }
+    }
+
+private:
+
+    struct Coefficients
+    {
+        SampleType b0{}, b1{}, b2{}, a1{}, a2{};
+    };
+
+    void setSection(int section, double b0, double b1, double b2, double a1, double a2) noexcept
+    {
+        auto& c = coefficients[section];
+        c.b0 = static_cast<SampleType>(b0);
+        c.b1 = static_cast<SampleType>(b1);
+        c.b2 = static_cast<SampleType>(b2);
+        c.a1 = static_cast<SampleType>(a1);
+        c.a2 = static_cast<SampleType>(a2);
+    }
+
+    int numGroups{ 0 };
+    Coefficients coefficients[2];
+    std::vector<SampleType> states;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(KcompKWeighting)
+};
+
+//==============================================================================
+/*
+    EBU R128 loudness from K-weighted power: momentary (400 ms), short-term
+    (3 s), gated integrated loudness and loudness range (EBU Tech 3342).
+
+    add() takes the channel-weighted sum of squares of a stretch of samples
+    and sums it into 100 ms blocks. Momentary and short-term are running
+    sums over the last 4 and 30 blocks. The integrated loudness and the
+    range keep 0.1 LU histograms of every 400 ms and 3 s window instead of
+    the windows themselves, so memory stays the same however long the
+    programme runs, and both are worked out again once per 100 ms block.
+
+    Everything is in LUFS (LU for the range), minimumLufs when there's
+    nothing to show. Audio thread only.
+*/
+class KcompLoudnessMeter
+{
+public:
+
+    static constexpr double minimumLufs = -100.0;
+
+    struct Reading
+    {
+        float momentary{ float(minimumLufs) };
+        float shortTerm{ float(minimumLufs) };
+        float integrated{ float(minimumLufs) };
+        float range{ 0.0f };
+    };
+
+    KcompLoudnessMeter()
+    {
+        reset();
+    }
+
+    void prepare(double sampleRate)
+    {
+        blockSamples = juce::jmax(1, juce::roundToInt(sampleRate * 0.1));
+        reset();
+    }
+
+    //Starts the integrated loudness and the range over
+    void reset() noexcept
+    {
+        std::fill(std::begin(blockPowers), std::end(blockPowers), 0.0);
+        std::fill(std::begin(gatedCounts), std::end(gatedCounts), juce::int64());
+        std::fill(std::begin(gatedPowers), std::end(gatedPowers), 0.0);
+        std::fill(std::begin(shortTermCounts), std::end(shortTermCounts), juce::int64());
+        blockSum = 0.0;
+        blockFill = 0;
+        blockIndex = 0;
+        numBlocks = 0;
+        momentarySum = 0.0;
+        shortTermSum = 0.0;
+        gatedCount = 0;
+        gatedPower = 0.0;
+        shortTermCount = 0;
+        shortTermPower = 0.0;
+        reading = Reading();
+    }
+
+    //weightedSumOfSquares over numSamples samples of K-weighted signal. A stretch that runs past the end of
+    //a 100 ms block is shared out in proportion, so the blocks don't depend on how the caller splits the audio.
+    void add(double weightedSumOfSquares, int numSamples) noexcept
+    {
+        while (blockFill + numSamples >= blockSamples)
+        {
+            const auto num = blockSamples - blockFill;
+            const auto share = weightedSumOfSquares * num / numSamples;
+            finishBlock((blockSum + share) / blockSamples);
+
+            weightedSumOfSquares -= share;
+            numSamples -= num;
+            blockSum = 0.0;
+            blockFill = 0;
+        }
+
+        blockSum += weightedSumOfSquares;
+        blockFill += numSamples;
+    }
+
+    const Reading& getReading() const noexcept      { return reading; }
+
+    static double powerToLufs(double power) noexcept
+    {
+        return power > 0.0 ? juce::jmax(minimumLufs, -0.691 + 10.0 * std::log10(power)) : minimumLufs;
+    }
+
+private:
+
+    static constexpr int momentaryBlocks = 4;
+    static constexpr int shortTermBlocks = 30;
+
+    //0.1 LU bins from the absolute gate up, louder windows go in the top bin
+    static constexpr double absoluteGateLufs = -70.0;
+    static constexpr double binsPerLu = 10.0;
+    static constexpr int numBins = 800;
+
+    static int getBin(double lufs) noexcept
+    {
+        return juce::jlimit(0, numBins - 1, int((lufs - absoluteGateLufs) * binsPerLu));
+    }
+
+    static double getBinLufs(int bin) noexcept
+    {
+        return absoluteGateLufs + (bin + 0.5) / binsPerLu;
+    }
+
+    void finishBlock(double power) noexcept
+    {
+        //running sums over the last 4 and 30 blocks, clamped so rounding never takes them below 0
+        auto& oldest = blockPowers[blockIndex];
+        const auto fourBack = blockPowers[(blockIndex + shortTermBlocks - momentaryBlocks) % shortTermBlocks];
+        momentarySum = juce::jmax(0.0, momentarySum + power - fourBack);
+        shortTermSum = juce::jmax(0.0, shortTermSum + power - oldest);
+        oldest = power;
+        blockIndex = (blockIndex + 1) % shortTermBlocks;
+        ++numBlocks;
+
+        const auto momentaryPower = momentarySum / momentaryBlocks;
+        const auto shortTermWindowPower = shortTermSum / shortTermBlocks;
+        reading.momentary = float(powerToLufs(momentaryPower));
+        reading.shortTerm = float(powerToLufs(shortTermWindowPower));
+
+        //gating blocks are the 400 ms windows, overlapping by 75 %
+        if (numBlocks >= momentaryBlocks && powerToLufs(momentaryPower) >= absoluteGateLufs)
+        {
+            const auto bin = getBin(powerToLufs(momentaryPower));
+            ++gatedCounts[bin];
+            gatedPowers[bin] += momentaryPower;
+            ++gatedCount;
+            gatedPower += momentaryPower;
+        }
+
+        if (numBlocks >= shortTermBlocks && powerToLufs(shortTermWindowPower) >= absoluteGateLufs)
+        {
+            ++shortTermCounts[getBin(powerToLufs(shortTermWindowPower))];
+            ++shortTermCount;
+            shortTermPower += shortTermWindowPower;
+        }
+
+        updateIntegrated();
+        updateRange();
+    }
+
+    //BS.1770-4: the mean of the gating blocks above the absolute gate and 10 LU under their mean
+    void updateIntegrated() noexcept
+    {
+        if (gatedCount == 0)
+        {
+            return;
+        }
+
+        const auto firstBin = getBin(powerToLufs(gatedPower / double(gatedCount)) - 10.0);
+
+        juce::int64 count = 0;
+        auto power = 0.0;
+        for (int bin = firstBin; bin < numBins; ++bin)
+        {
+            count += gatedCounts[bin];
+            power += gatedPowers[bin];
+        }
+
+        reading.integrated = float(count > 0 ? powerToLufs(power / double(count)) : minimumLufs);
+    }
+
+    //Tech 3342: the spread between the 10th and 95th percentile of the short-term values above the absolute
+    //gate and 20 LU under their mean
+    void updateRange() noexcept
+    {
+        if (shortTermCount == 0)
+        {
+            return;
+        }
+
+        const auto firstBin = getBin(powerToLufs(shortTermPower / double(shortTermCount)) - 20.0);
+
+        juce::int64 count = 0;
+        for (int bin = firstBin; bin < numBins; ++bin)
+        {
+            count += shortTermCounts[bin];
+        }
+
+        if (count == 0)
+        {
+            reading.range = 0.0f;
+            return;
+        }
+
+        const auto low = juce::int64(double(count - 1) * 0.1);
+        const auto high = juce::int64(double(count - 1) * 0.95);
+        auto lowLufs = 0.0, highLufs = 0.0;
+
+        juce::int64 seen = 0;
+        for (int bin = firstBin; bin < numBins; ++bin)
+        {
+            if (shortTermCounts[bin] == 0)
+            {
+                continue;
+            }
+
+            if (seen <= low && low < seen + shortTermCounts[bin])
+            {
+                lowLufs = getBinLufs(bin);
+            }
+            if (seen <= high && high < seen + shortTermCounts[bin])
+            {
+                highLufs = getBinLufs(bin);
+                break;
+            }
+            seen += shortTermCounts[bin];
+        }
+
+        reading.range = float(highLufs - lowLufs);
+    }
+
+    int blockSamples{ 4410 };
+    double blockSum{ 0.0 };
+    int blockFill{ 0 };
+
+    double blockPowers[shortTermBlocks];
+    int blockIndex{ 0 };
+    juce::int64 numBlocks{ 0 };
+    double momentarySum{ 0.0 }, shortTermSum{ 0.0 };
+
+    juce::int64 gatedCounts[numBins];
+    double gatedPowers[numBins];
+    juce::int64 gatedCount{ 0 };
+    double gatedPower{ 0.0 };
+
+    juce::int64 shortTermCounts[numBins];
+    juce::int64 shortTermCount{ 0 };
+    double shortTermPower{ 0.0 };
+
+    Reading reading;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(KcompLoudnessMeter)
+};
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "KcompSIMD.h"
+
+//==============================================================================
+/*
+    Fast log2/exp2 and decibel conversions for the gain computer and the
+    meters, in place of std::log10/std::pow.
+
+    Both work on the bits of the float: log2 adds the exponent to a polynomial
+    in the mantissa, exp2 builds 2^floor(x) and multiplies it by a polynomial
+    in the fraction. The polynomials are minimax fits, and Accuracy picks how
+    many terms they get. The worst case over the whole audio range, in dB:
+
+        coarse  log2 0.0047, exp2 0.0008   for anything that ends up as pixels
+        fine    log2 0.0001, exp2 0.00003  for the gain computer and readouts
+
+    Every function takes a KcompSIMD::Register or a plain float/double. log2
+    of 1 and exp2 of 0 are exact, so unity gain is exactly 0 dB and back. log2
+    wants x > 0 and normal, exp2 clamps its input to [-126, 126]. The decibel
+    conversions handle zero and the -inf floor the same way juce::Decibels
+    does.
+*/
+namespace KcompMath
+{
+    enum class Accuracy
+    {
+        coarse,     //within 0.005 dB
+        fine        //within 0.0001 dB
+    };
+
+    constexpr double log2ToDecibels = 6.0205999132796239;     //20 * log10(2)
+    constexpr double decibelsToLog2 = 0.16609640474436813;    //1 / (20 * log10(2))
+
+    //==============================================================================
+    template <Accuracy accuracy, typename RegisterType, typename T = typename RegisterType::ElementType>
+    forcedinline RegisterType log2(RegisterType x) noexcept
+    {
+        RegisterType exponent, mantissa;
+        KcompSIMD::native::splitFloat(x.value, exponent.value, mantissa.value, T());
+
+        const auto t = mantissa - RegisterType::expand(T(1));
+        RegisterType p;
+
+        if (accuracy == Accuracy::fine)
+        {
+            p = RegisterType::expand(static_cast<T>(0.0463853404));
+            p = p * t + RegisterType::expand(static_cast<T>(-0.196269587));
+            p = p * t + RegisterType::expand(static_cast<T>(0.417595744));
+            p = p * t + RegisterType::expand(static_cast<T>(-0.709662795));
+            p = p * t + RegisterType::expand(static_cast<T>(1.44196558));
+        }
+        else
+        {
+            p = RegisterType::expand(static_cast<T>(0.165383711));
+            p = p * t + RegisterType::expand(static_cast<T>(-0.589206576));
+            p = p * t + RegisterType::expand(static_cast<T>(1.42459381));
+        }
+
+        return exponent + p * t;
+    }
+
+    template <Accuracy accuracy, typename RegisterType, typename T = typename RegisterType::ElementType>
+    forcedinline RegisterType exp2(RegisterType x) noexcept
+    {
+        x = RegisterType::min(RegisterType::max(x, RegisterType::expand(T(-126))), RegisterType::expand(T(126)));
+
+        RegisterType n;
+        n.value = KcompSIMD::native::floorFloat(x.value, T());
+        const auto f = x - n;
+        RegisterType p;
+
+        if (accuracy == Accuracy::fine)
+        {
+            p = RegisterType::expand(static_cast<T>(0.0134266848));
+            p = p * f + RegisterType::expand(static_cast<T>(0.0522424728));
+            p = p * f + RegisterType::expand(static_cast<T>(0.241280198));
+            p = p * f + RegisterType::expand(static_cast<T>(0.693044841));
+        }
+        else
+        {
+            p = RegisterType::expand(static_cast<T>(0.0770670399));
+            p = p * f + RegisterType::expand(static_cast<T>(0.227644995));
+            p = p * f + RegisterType::expand(static_cast<T>(0.695116758));
+        }
+
+        RegisterType scale;
+        scale.value = KcompSIMD::native::powerOfTwoFloat(n.value, T());
+
+        return scale * (p * f + RegisterType::expand(T(1)));
+    }
+
+    //Gains at or below zero give minusInfinityDb
+    template <Accuracy accuracy, typename RegisterType, typename T = typename RegisterType::ElementType>
+    forcedinline RegisterType gainToDecibels(RegisterType gain, T minusInfinityDb = T(-100)) noexcept
+    {
+        const auto safeGain = RegisterType::max(gain, RegisterType::expand(std::numeric_limits<T>::min()));
+        return RegisterType::max(log2<accuracy>(safeGain) * RegisterType::expand(static_cast<T>(log2ToDecibels)),
+                                 RegisterType::expand(minusInfinityDb));
+    }
+
+    //Decibels at or below minusInfinityDb give 0
+    template <Accuracy accuracy, typename RegisterType, typename T = typename RegisterType::ElementType>
+    forcedinline RegisterType decibelsToGain(RegisterType decibels, T minusInfinityDb = T(-100)) noexcept
+    {
+        const auto gain = exp2<accuracy>(decibels * RegisterType::expand(static_cast<T>(decibelsToLog2)));
+        return KcompSIMD::select<T>(RegisterType::greaterThan(decibels, RegisterType::expand(minusInfinityDb)),
+                                    gain, RegisterType::expand(T()));
+    }
+
+    //==============================================================================
+    //Scalar versions, for the meters and anything else that works one value at a time
+    template <Accuracy accuracy>
+    forcedinline float log2(float x) noexcept
+    {
+        return log2<accuracy>(KcompSIMD::ScalarRegister<float>::expand(x)).value;
+    }
+
+    template <Accuracy accuracy>
+    forcedinline double log2(double x) noexcept
+    {
+        return log2<accuracy>(KcompSIMD::ScalarRegister<double>::expand(x)).value;
+    }
+
+    template <Accuracy accuracy>
+    forcedinline float exp2(float x) noexcept
+    {
+        return exp2<accuracy>(KcompSIMD::ScalarRegister<float>::expand(x)).value;
+    }
+
+    template <Accuracy accuracy>
+    forcedinline double exp2(double x) noexcept
+    {
+        return exp2<accuracy>(KcompSIMD::ScalarRegister<double>::expand(x)).value;
+    }
+
+    template <Accuracy accuracy>
+    forcedinline float gainToDecibels(float gain, float minusInfinityDb = -100.0f) noexcept
+    {
+        return gain > 0.0f ? juce::jmax(minusInfinityDb, log2<accuracy>(gain) * static_cast<float>(log2ToDecibels)) : minusInfinityDb;
+    }
+
+    template <Accuracy accuracy>
+    forcedinline double gainToDecibels(double gain, double minusInfinityDb = -100.0) noexcept
+    {
+        return gain > 0.0 ? juce::jmax(minusInfinityDb, log2<accuracy>(gain) * log2ToDecibels) : minusInfinityDb;
+    }
+
+    template <Accuracy accuracy>
+    forcedinline float decibelsToGain(float decibels, float minusInfinityDb = -100.0f) noexcept
+    {
+        return decibels > minusInfinityDb ? exp2<accuracy>(decibels * static_cast<float>(decibelsToLog2)) : 0.0f;
+    }
+
+    template <Accuracy accuracy>
+    forcedinline double decibelsToGain(double decibels, double minusInfinityDb = -100.0) noexcept
+    {
+        return decibels > minusInfinityDb ? exp2<accuracy>(decibels * decibelsToLog2) : 0.0;
+    }
+}
@@ -0,0 +1,318 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    Small helpers on top of juce::dsp::SIMDRegister that the Kcomp DSP code
+    needs but SIMDRegister doesn't provide: unaligned loads/stores, select,
+    horizontal max and min, swapping neighbouring lanes, division, a square
+    root, and the float splitting that KcompMath builds its log2/exp2 on.
+
+    The bit tricks have native SSE2 versions for float and double, and a
+    generic version that works lane by lane on whatever native type JUCE
+    picked (NEON or its own fallback). Builds with JUCE_USE_SIMD=0 get a
+    one-lane ScalarRegister with the same interface.
+*/
+namespace KcompSIMD
+{
+    //One lane with the SIMDRegister interface, for JUCE_USE_SIMD=0 builds and for scalar calls into SIMD code
+    template <typename T>
+    struct ScalarRegister
+    {
+        using ElementType = T;
+        using vSIMDType = T;
+        using vMaskType = bool;
+        static constexpr size_t SIMDNumElements = 1;
+
+        static constexpr size_t size() noexcept                                 { return 1; }
+        static ScalarRegister expand(T s) noexcept                              { return { s }; }
+        static ScalarRegister min(ScalarRegister a, ScalarRegister b) noexcept  { return { juce::jmin(a.value, b.value) }; }
+        static ScalarRegister max(ScalarRegister a, ScalarRegister b) noexcept  { return { juce::jmax(a.value, b.value) }; }
+        static bool greaterThan(ScalarRegister a, ScalarRegister b) noexcept    { return a.value > b.value; }
+        T sum() const noexcept                                                  { return value; }
+
+        ScalarRegister operator+ (ScalarRegister o) const noexcept              { return { value + o.value }; }
+        ScalarRegister operator- (ScalarRegister o) const noexcept              { return { value - o.value }; }
+        ScalarRegister operator* (ScalarRegister o) const noexcept              { return { value * o.value }; }
+        ScalarRegister& operator+= (ScalarRegister o) noexcept                  { value += o.value; return *this; }
+        ScalarRegister& operator*= (ScalarRegister o) noexcept                  { value *= o.value; return *this; }
+
+        T value;
+    };
+
+   #if JUCE_USE_SIMD
+    template <typename T>
+    using Register = juce::dsp::SIMDRegister<T>;
+   #else
+    template <typename T>
+    using Register = ScalarRegister<T>;
+   #endif
+
+    //==============================================================================
+    //Loads/stores don't need aligned memory, so the DSP state can live in plain members
+    template <typename T>
+    forcedinline Register<T> load(const T* src) noexcept
+    {
+        Register<T> r;
+        std::memcpy(&r.value, src, sizeof(r.value));
+        return r;
+    }
+
+    template <typename T>
+    forcedinline void store(T* dst, Register<T> r) noexcept
+    {
+        std::memcpy(dst, &r.value, sizeof(r.value));
+    }
+
+    template <typename T>
+    forcedinline Register<T> select(typename Register<T>::vMaskType mask, Register<T> ifTrue, Register<T> ifFalse) noexcept
+    {
+       #if JUCE_USE_SIMD
+        return (ifTrue & mask) + (ifFalse & ~mask);
+       #else
+        return mask ? ifTrue : ifFalse;
+       #endif
+    }
+
+    template <typename T>
+    forcedinline Register<T> abs(Register<T> x) noexcept
+    {
+        return Register<T>::max(x, Register<T>::expand(T()) - x);
+    }
+
+    //Max over the first numLanes lanes only, the rest may hold padding
+    template <typename T>
+    forcedinline T horizontalMax(Register<T> x, int numLanes) noexcept
+    {
+        T lanes[Register<T>::SIMDNumElements];
+        store(lanes, x);
+
+        auto result = lanes[0];
+        for (int lane = 1; lane < numLanes; ++lane)
+        {
+            result = juce::jmax(result, lanes[lane]);
+        }
+        return result;
+    }
+
+    //Min over the first numLanes lanes
+    template <typename T>
+    forcedinline T horizontalMin(Register<T> x, int numLanes) noexcept
+    {
+        T lanes[Register<T>::SIMDNumElements];
+        store(lanes, x);
+
+        auto result = lanes[0];
+        for (int lane = 1; lane < numLanes; ++lane)
+        {
+            result = juce::jmin(result, lanes[lane]);
+        }
+        return result;
+    }
+
+    //==============================================================================
+    namespace native
+    {
+        //Bit layout of the IEEE types, so the generic versions below work for float and double
+        template <typename T> struct FloatBits;
+
+        template <> struct FloatBits<float>
+        {
+            using Bits = juce::uint32;
+            static constexpr int mantissaBits = 23;
+            static constexpr int bias = 127;
+        };
+
+        template <> struct FloatBits<double>
+        {
+            using Bits = juce::uint64;
+            static constexpr int mantissaBits = 52;
+            static constexpr int bias = 1023;
+        };
+
+        //Splits positive, normal x into its unbiased exponent and a mantissa in [1, 2)
+        template <typename NativeType, typename T>
+        forcedinline void splitFloat(NativeType x, NativeType& exponent, NativeType& mantissa, T) noexcept
+        {
+            using Bits = typename FloatBits<T>::Bits;
+            constexpr auto mantissaBits = FloatBits<T>::mantissaBits;
+            constexpr auto mantissaMask = (Bits(1) << mantissaBits) - 1;
+            constexpr auto one = Bits(FloatBits<T>::bias) << mantissaBits;
+            constexpr size_t numLanes = sizeof(NativeType) / sizeof(T);
+
+            T xs[numLanes], es[numLanes], ms[numLanes];
+            std::memcpy(xs, &x, sizeof(x));
+
+            for (size_t lane = 0; lane < numLanes; ++lane)
+            {
+                Bits bits;
+                std::memcpy(&bits, &xs[lane], sizeof(bits));
+                es[lane] = T(int(bits >> mantissaBits) - FloatBits<T>::bias);
+                bits = (bits & mantissaMask) | one;
+                std::memcpy(&ms[lane], &bits, sizeof(bits));
+            }
+
+            std::memcpy(&exponent, es, sizeof(exponent));
+            std::memcpy(&mantissa, ms, sizeof(mantissa));
+        }
+
+        //2^n for integral n in [-126, 127]
+        template <typename NativeType, typename T>
+        forcedinline NativeType powerOfTwoFloat(NativeType n, T) noexcept
+        {
+            using Bits = typename FloatBits<T>::Bits;
+            constexpr size_t numLanes = sizeof(NativeType) / sizeof(T);
+
+            T ns[numLanes];
+            std::memcpy(ns, &n, sizeof(n));
+
+            for (size_t lane = 0; lane < numLanes; ++lane)
+            {
+                const auto bits = Bits(int(ns[lane]) + FloatBits<T>::bias) << FloatBits<T>::mantissaBits;
+                std::memcpy(&ns[lane], &bits, sizeof(bits));
+            }
+
+            std::memcpy(&n, ns, sizeof(n));
+            return n;
+        }
+
+        template <typename NativeType, typename T>
+        forcedinline NativeType floorFloat(NativeType x, T) noexcept
+        {
+            constexpr size_t numLanes = sizeof(NativeType) / sizeof(T);
+            T xs[numLanes];
+            std::memcpy(xs, &x, sizeof(x));
+
+            for (size_t lane = 0; lane < numLanes; ++lane)
+            {
+                xs[lane] = std::floor(xs[lane]);
+            }
+
+            std::memcpy(&x, xs, sizeof(x));
+            return x;
+        }
+
+        template <typename NativeType, typename T>
+        forcedinline NativeType divideFloat(NativeType a, NativeType b, T) noexcept
+        {
+            constexpr size_t numLanes = sizeof(NativeType) / sizeof(T);
+            T as[numLanes], bs[numLanes];
+            std::memcpy(as, &a, sizeof(a));
+            std::memcpy(bs, &b, sizeof(b));
+
+            for (size_t lane = 0; lane < numLanes; ++lane)
+            {
+                as[lane] /= bs[lane];
+            }
+
+            std::memcpy(&a, as, sizeof(a));
+            return a;
+        }
+
+        template <typename NativeType, typename T>
+        forcedinline NativeType swapPairsFloat(NativeType x, T) noexcept
+        {
+            constexpr size_t numLanes = sizeof(NativeType) / sizeof(T);
+            T xs[numLanes];
+            std::memcpy(xs, &x, sizeof(x));
+
+            for (size_t lane = 0; lane + 1 < numLanes; lane += 2)
+            {
+                std::swap(xs[lane], xs[lane + 1]);
+            }
+
+            std::memcpy(&x, xs, sizeof(x));
+            return x;
+        }
+
+        template <typename NativeType, typename T>
+        forcedinline NativeType sqrtFloat(NativeType x, T) noexcept
+        {
+            constexpr size_t numLanes = sizeof(NativeType) / sizeof(T);
+            T xs[numLanes];
+            std::memcpy(xs, &x, sizeof(x));
+
+            for (size_t lane = 0; lane < numLanes; ++lane)
+            {
+                xs[lane] = std::sqrt(xs[lane]);
+            }
+
+            std::memcpy(&x, xs, sizeof(x));
+            return x;
+        }
+
+       #if JUCE_USE_SIMD && JUCE_USE_SSE_INTRINSICS
+        forcedinline void splitFloat(__m128 x, __m128& exponent, __m128& mantissa, float) noexcept
+        {
+            const auto bits = _mm_castps_si128(x);
+            exponent = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+            mantissa = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f800000)));
+        }
+
+        forcedinline __m128 powerOfTwoFloat(__m128 n, float) noexcept
+        {
+            return _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(_mm_cvttps_epi32(n), _mm_set1_epi32(127)), 23));
+        }
+
+        forcedinline __m128 floorFloat(__m128 x, float) noexcept
+        {
+            const auto truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+            return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, x), _mm_set1_ps(1.0f)));
+        }
+
+        forcedinline __m128 sqrtFloat(__m128 x, float) noexcept                     { return _mm_sqrt_ps(x); }
+        forcedinline __m128d sqrtFloat(__m128d x, double) noexcept                  { return _mm_sqrt_pd(x); }
+        forcedinline __m128 divideFloat(__m128 a, __m128 b, float) noexcept         { return _mm_div_ps(a, b); }
+        forcedinline __m128d divideFloat(__m128d a, __m128d b, double) noexcept     { return _mm_div_pd(a, b); }
+        forcedinline __m128 swapPairsFloat(__m128 x, float) noexcept                { return _mm_shuffle_ps(x, x, _MM_SHUFFLE(2, 3, 0, 1)); }
+        forcedinline __m128d swapPairsFloat(__m128d x, double) noexcept             { return _mm_shuffle_pd(x, x, 1); }
+
+        //SSE2 has no 64-bit integer conversions, the exponents fit in the low half of each lane
+        forcedinline void splitFloat(__m128d x, __m128d& exponent, __m128d& mantissa, double) noexcept
+        {
+            const auto bits = _mm_castpd_si128(x);
+            const auto biased = _mm_shuffle_epi32(_mm_srli_epi64(bits, 52), _MM_SHUFFLE(2, 0, 2, 0));
+            exponent = _mm_cvtepi32_pd(_mm_sub_epi32(biased, _mm_set1_epi32(1023)));
+            mantissa = _mm_castsi128_pd(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi64x(0x000fffffffffffffLL)),
+                                                     _mm_set1_epi64x(0x3ff0000000000000LL)));
+        }
+
+        forcedinline __m128d powerOfTwoFloat(__m128d n, double) noexcept
+        {
+            const auto biased = _mm_add_epi32(_mm_cvttpd_epi32(n), _mm_set1_epi32(1023));
+            return _mm_castsi128_pd(_mm_slli_epi64(_mm_unpacklo_epi32(biased, _mm_setzero_si128()), 52));
+        }
+
+        forcedinline __m128d floorFloat(__m128d x, double) noexcept
+        {
+            const auto truncated = _mm_cvtepi32_pd(_mm_cvttpd_epi32(x));
+            return _mm_sub_pd(truncated, _mm_and_pd(_mm_cmpgt_pd(truncated, x), _mm_set1_pd(1.0)));
+        }
+       #endif
+    }
+
+    //Exact square root, x >= 0
+    template <typename RegisterType>
+    forcedinline RegisterType sqrt(RegisterType x) noexcept
+    {
+        x.value = native::sqrtFloat(x.value, typename RegisterType::ElementType());
+        return x;
+    }
+
+    //SIMDRegister has no operator/
+    template <typename RegisterType>
+    forcedinline RegisterType divide(RegisterType a, RegisterType b) noexcept
+    {
+        a.value = native::divideFloat(a.value, b.value, typename RegisterType::ElementType());
+        return a;
+    }
+
+    //Lane 0 trades places with lane 1, 2 with 3 and so on. A one-lane register stays as it is.
+    template <typename RegisterType>
+    forcedinline RegisterType swapPairs(RegisterType x) noexcept
+    {
+        x.value = native::swapPairsFloat(x.value, typename RegisterType::ElementType());
+        return x;
+    }
+}
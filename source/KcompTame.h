@@ -0,0 +1,184 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "KcompSIMD.h"
+
+//==============================================================================
+/*
+    The Tame filter: Butterworth low-pass or high-pass at 12, 24, 36 or
+    48 dB/oct, channels in SIMD lanes. Each 12 dB/oct is one TPT state
+    variable filter section, which stays stable however fast the frequency
+    moves.
+
+    The frequency glides multiplicatively. While it glides, fillCoefficients()
+    works out the section coefficients once per sample for the sub-block
+    (one tan() and one division per section), every channel shares them.
+*/
+template <typename SampleType>
+class KcompTame
+{
+public:
+
+    using Vec = KcompSIMD::Register<SampleType>;
+    static constexpr int lanes = int(Vec::SIMDNumElements);
+
+    static constexpr int maxSections = 4;
+    static constexpr int maxBlockSize = 32;
+    static constexpr double rampLengthSeconds = 0.05;
+
+    struct State
+    {
+        Vec s1[maxSections], s2[maxSections];
+    };
+
+    void prepare(double newSampleRate, int newNumGroups)
+    {
+        sampleRate = newSampleRate;
+        numGroups = newNumGroups;
+        states.assign(size_t(numGroups * maxSections * 2 * lanes), SampleType());
+        frequency.reset(sampleRate, rampLengthSeconds);
+        frequency.setCurrentAndTargetValue(limitFrequency(frequency.getTargetValue()));
+        updateDamping();
+        fillCoefficients(maxBlockSize);
+        reset();
+    }
+
+    void reset()
+    {
+        std::fill(states.begin(), states.end(), SampleType());
+        frequency.setCurrentAndTargetValue(frequency.getTargetValue());
+    }
+
+    //numSections is the slope in 12 dB/oct steps
+    void setShape(int newNumSections, bool shouldBeHighPass)
+    {
+        newNumSections = juce::jlimit(1, maxSections, newNumSections);
+        if (newNumSections != numSections)
+        {
+            numSections = newNumSections;
+            updateDamping();
+        }
+        highPass = shouldBeHighPass;
+    }
+
+    void setFrequency(SampleType newFrequency)
+    {
+        frequency.setTargetValue(limitFrequency(newFrequency));
+    }
+
+    //Coefficients for the next num samples, ramped if the frequency is still gliding
+    void fillCoefficients(int num) noexcept
+    {
+        jassert(num <= maxBlockSize);
+
+        if (! frequency.isSmoothing() && coefficientsFrequency == frequency.getTargetValue())
+        {
+            return;
+        }
+
+        const auto ramping = frequency.isSmoothing();
+        for (int i = 0; i < (ramping ? num : maxBlockSize); ++i)
+        {
+            const auto g = static_cast<SampleType>(std::tan(juce::MathConstants<double>::pi * frequency.getNextValue() / sampleRate));
+            for (int section = 0; section < numSections; ++section)
+            {
+                auto& c = coefficients[section];
+                c.a1[i] = static_cast<SampleType>(1.0) / (static_cast<SampleType>(1.0) + g * (g + damping[section]));
+                c.a2[i] = g * c.a1[i];
+                c.a3[i] = g * c.a2[i];
+            }
+        }
+
+        //after the glide every sample uses the target
+        coefficientsFrequency = ramping ? SampleType() : frequency.getTargetValue();
+    }
+
+    State load(int group) const noexcept
+    {
+        const auto* source = states.data() + size_t(group * maxSections * 2 * lanes);
+
+        State state;
+        for (int section = 0; section < maxSections; ++section)
+        {
+            state.s1[section] = KcompSIMD::load(source + (section * 2) * lanes);
+            state.s2[section] = KcompSIMD::load(source + (section * 2 + 1) * lanes);
+        }
+        return state;
+    }
+
+    void store(int group, const State& state) noexcept
+    {
+        auto* destination = states.data() + size_t(group * maxSections * 2 * lanes);
+        for (int section = 0; section < maxSections; ++section)
+        {
+            KcompSIMD::store(destination + (section * 2) * lanes, state.s1[section]);
+            KcompSIMD::store(destination + (section * 2 + 1) * lanes, state.s2[section]);
+        }
+    }
+
+    //i indexes the coefficients from the last fillCoefficients() call
+    forcedinline Vec process(State& state, Vec x, int i) const noexcept
+    {
+        for (int section = 0; section < numSections; ++section)
+        {
+            const auto& c = coefficients[section];
+            auto& s1 = state.s1[section];
+            auto& s2 = state.s2[section];
+
+            const auto v3 = x - s2;
+            const auto band = Vec::expand(c.a1[i]) * s1 + Vec::expand(c.a2[i]) * v3;
+            const auto low = s2 + Vec::expand(c.a2[i]) * s1 + Vec::expand(c.a3[i]) * v3;
+            s1 = band + band - s1;
+            s2 = low + low - s2;
+
+            x = highPass ? x - Vec::expand(damping[section]) * band - low : low;
+        }
+
+        return x;
+    }
+
+    void snapToZero() noexcept
+    {
+        for (auto& value : states)
+        {
+            juce::dsp::util::snapToZero(value);
+        }
+    }
+
+private:
+
+    struct Coefficients
+    {
+        SampleType a1[maxBlockSize]{}, a2[maxBlockSize]{}, a3[maxBlockSize]{};
+    };
+
+    SampleType limitFrequency(SampleType newFrequency) const noexcept
+    {
+        return juce::jlimit(static_cast<SampleType>(20.0), static_cast<SampleType>(sampleRate * 0.49), newFrequency);
+    }
+
+    //Butterworth: section s of an order 2n filter has damping 2cos((2s + 1)pi / 4n)
+    void updateDamping() noexcept
+    {
+        for (int section = 0; section < numSections; ++section)
+        {
+            damping[section] = static_cast<SampleType>(2.0 * std::cos(juce::MathConstants<double>::pi * (2 * section + 1) / (4.0 * numSections)));
+        }
+        coefficientsFrequency = SampleType();
+    }
+
+    double sampleRate{ 44100.0 };
+    int numGroups{ 0 };
+
+    int numSections{ 1 };
+    bool highPass{ false };
+    SampleType damping[maxSections]{};
+
+    juce::SmoothedValue<SampleType, juce::ValueSmoothingTypes::Multiplicative> frequency{ 10000 };
+    SampleType coefficientsFrequency{};
+    Coefficients coefficients[maxSections];
+
+    std::vector<SampleType> states;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(KcompTame)
+};
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "KcompSIMD.h"
+#include "KcompMath.h"
+#include "KcompTripleBuffer.h"
+
+//==============================================================================
+/*
+    Static curve of the gain computer as a lookup table: gain for how far the
+    envelope is over the threshold, both in log2 units (dB over 6.02), with
+    linear interpolation between the points.
+
+    The curve is a continuous ratio with a quadratic soft knee around the
+    threshold, plus an optional upper stage with its own ratio further up,
+    sharing the knee. However it's set, the audio thread only does one
+    interpolated read per lane.
+
+    publish() builds a new table on whatever thread calls it and hands it
+    over through a KcompTripleBuffer. acquire() picks it up on the audio
+    thread, keeping a copy of the old curve so the engine can crossfade
+    from one to the other instead of jumping.
+*/
+template <typename SampleType>
+class KcompTransferCurve
+{
+public:
+
+    using Vec = KcompSIMD::Register<SampleType>;
+    static constexpr int lanes = int(Vec::SIMDNumElements);
+
+    static constexpr SampleType maxKneeDb = 24;
+    static constexpr SampleType maxUpperThresholdDb = 48;
+
+    //-12 dB to +96 dB over the threshold, a point every 0.094 dB. Past the end the last slope carries on.
+    static constexpr int firstLog2 = -2;
+    static constexpr int lastLog2 = 16;
+    static constexpr int pointsPerLog2 = 64;
+    static constexpr int tableSize = (lastLog2 - firstLog2) * pointsPerLog2 + 1;
+
+    //Ratios are x:1, the upper stage takes over upperThresholdDb above the threshold
+    struct Settings
+    {
+        SampleType ratio{ 1 };
+        SampleType kneeDb{ 0 };
+        bool upperStage{ false };
+        SampleType upperThresholdDb{ 12 };
+        SampleType upperRatio{ 10 };
+
+        bool operator== (const Settings& other) const noexcept
+        {
+            return ratio == other.ratio && kneeDb == other.kneeDb && upperStage == other.upperStage
+                && upperThresholdDb == other.upperThresholdDb && upperRatio == other.upperRatio;
+        }
+
+        bool operator!= (const Settings& other) const noexcept     { return ! operator== (other); }
+    };
+
+    //The tables one register reads, lane by lane, and the ones they fade from while a new curve comes in
+    struct Frame
+    {
+        const SampleType* tables[lanes]{};
+        const SampleType* previousTables[lanes]{};
+        bool fading{ false };
+
+        //Gain in log2 units, fade 0 is the previous curve and 1 the current one
+        forcedinline Vec getGain(Vec overshoot, Vec fade) const noexcept
+        {
+            const auto gain = lookup(tables, overshoot);
+            if (! fading)
+            {
+                return gain;
+            }
+
+            const auto previousGain = lookup(previousTables, overshoot);
+            return previousGain + fade * (gain - previousGain);
+        }
+    };
+
+    //Starts out flat, 1:1 everywhere
+    KcompTransferCurve()
+        : tables(std::vector<SampleType>(size_t(tableSize), SampleType())),
+          previous(size_t(tableSize), SampleType())
+    {
+    }
+
+    //==============================================================================
+    //Builds the table for newSettings and hands it to the audio thread. Never call it from two threads at once.
+    void publish(const Settings& newSettings) noexcept
+    {
+        auto& table = tables.getWriteSlot();
+        for (int point = 0; point < tableSize; ++point)
+        {
+            table[size_t(point)] = computeGain(newSettings, static_cast<SampleType>(firstLog2) + static_cast<SampleType>(point) / pointsPerLog2);
+        }
+
+        tables.publish();
+    }
+
+    //Audio thread: takes the newest published table. fade is how far the crossfade to the current one has got,
+    //the blend at that point becomes the curve to fade from. Returns true when a new crossfade should start.
+    bool acquire(SampleType fade) noexcept
+    {
+        if (! tables.hasFreshSlot())
+        {
+            return false;
+        }
+
+        const auto& current = tables.getReadSlot();
+        for (size_t point = 0; point < previous.size(); ++point)
+        {
+            previous[point] += fade * (current[point] - previous[point]);
+        }
+
+        tables.acquire();
+        return true;
+    }
+
+    const SampleType* getTable() const noexcept             { return tables.getReadSlot().data(); }
+    const SampleType* getPreviousTable() const noexcept     { return previous.data(); }
+
+    //==============================================================================
+    //Interpolated table read, each lane from its own table
+    static forcedinline Vec lookup(const SampleType* const* laneTables, Vec overshoot) noexcept
+    {
+        const auto position = Vec::max((overshoot - Vec::expand(static_cast<SampleType>(firstLog2))) * Vec::expand(static_cast<SampleType>(pointsPerLog2)),
+                                       Vec::expand(SampleType()));
+
+        SampleType positions[lanes], gains[lanes];
+        KcompSIMD::store(positions, position);
+
+        for (int lane = 0; lane < lanes; ++lane)
+        {
+            const auto index = juce::jmin(int(positions[lane]), tableSize - 2);
+            const auto* table = laneTables[lane] + index;
+            gains[lane] = table[0] + (positions[lane] - static_cast<SampleType>(index)) * (table[1] - table[0]);
+        }
+
+        return KcompSIMD::load(gains);
+    }
+
+    //The curve the table samples, gain in log2 units for an overshoot in log2 units
+    static SampleType computeGain(const Settings& settings, SampleType overshoot) noexcept
+    {
+        const auto one = static_cast<SampleType>(1.0);
+        const auto toLog2 = static_cast<SampleType>(KcompMath::decibelsToLog2);
+        const auto knee = juce::jlimit(SampleType(), maxKneeDb, settings.kneeDb) * toLog2;
+        const auto ratio = juce::jmax(one, settings.ratio);
+
+        auto gain = (one / ratio - one) * softKnee(overshoot, knee);
+
+        //the upper stage only changes the slope from its own threshold on
+        if (settings.upperStage)
+        {
+            const auto upperThreshold = juce::jlimit(SampleType(), maxUpperThresholdDb, settings.upperThresholdDb) * toLog2;
+            gain += (one / juce::jmax(one, settings.upperRatio) - one / ratio) * softKnee(overshoot - upperThreshold, knee);
+        }
+
+        return gain;
+    }
+
+private:
+
+    //max(x, 0) with the corner rounded off over width (Giannoulis, Massberg & Reiss), a hard corner at 0
+    static SampleType softKnee(SampleType x, SampleType width) noexcept
+    {
+        const auto half = width * static_cast<SampleType>(0.5);
+        if (x <= -half)
+        {
+            return SampleType();
+        }
+        if (x >= half)
+        {
+            return x;
+        }
+
+        return (x + half) * (x + half) / (width + width);
+    }
+
+    KcompTripleBuffer<std::vector<SampleType>> tables;
+    std::vector<SampleType> previous;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(KcompTransferCurve)
+};
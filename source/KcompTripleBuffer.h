@@ -0,0 +1,70 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    Hands whole objects from one writer thread to one reader thread without
+    locks or copies. There are three slots: the writer fills its own, the
+    reader reads its own, and publish()/acquire() swap them with the one in
+    the middle through a single atomic exchange. Neither side ever waits,
+    and the reader always gets the newest published slot.
+
+    The slots are built up front, so anything that allocates (a vector) must
+    be sized before it's handed around, the reader never frees or grows it.
+    Only one thread may write at a time.
+*/
+template <typename ObjectType>
+class KcompTripleBuffer
+{
+public:
+
+    KcompTripleBuffer() = default;
+
+    explicit KcompTripleBuffer(const ObjectType& initial)
+    {
+        for (auto& slot : slots)
+        {
+            slot = initial;
+        }
+    }
+
+    //Writer: fill this in, then publish() it. It may still hold anything published before.
+    ObjectType& getWriteSlot() noexcept                 { return slots[writeIndex]; }
+
+    void publish() noexcept
+    {
+        writeIndex = middle.exchange(writeIndex | freshFlag, std::memory_order_acq_rel) & indexMask;
+    }
+
+    //Reader: true when something was published since the last acquire(). Only the reader clears it.
+    bool hasFreshSlot() const noexcept
+    {
+        return (middle.load(std::memory_order_relaxed) & freshFlag) != 0;
+    }
+
+    //Reader: swaps in the newest published slot, false if nothing came in since the last time
+    bool acquire() noexcept
+    {
+        if ((middle.load(std::memory_order_relaxed) & freshFlag) == 0)
+        {
+            return false;
+        }
+
+        readIndex = middle.exchange(readIndex, std::memory_order_acq_rel) & indexMask;
+        return true;
+    }
+
+    const ObjectType& getReadSlot() const noexcept      { return slots[readIndex]; }
+
+private:
+
+    static constexpr int indexMask = 3;
+    static constexpr int freshFlag = 4;
+
+    ObjectType slots[3];
+    int writeIndex{ 0 }, readIndex{ 1 };
+    std::atomic<int> middle{ 2 };
+
+    JUCE_DECLARE_NON_COPYABLE(KcompTripleBuffer)
+};
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "KcompSIMD.h"
+
+//==============================================================================
+/*
+    ITU-R BS.1770 true-peak, channels in SIMD lanes: the signal is
+    oversampled 4x by the 48-tap polyphase FIR from the recommendation, and
+    each frame reads the largest of its four interpolated points and the
+    sample itself.
+
+    Each phase only needs the last 12 frames. They are kept twice over in
+    the ring, so the taps always read one contiguous run and nothing is
+    shifted.
+*/
+template <typename SampleType>
+class KcompTruePeak
+{
+public:
+
+    using Vec = KcompSIMD::Register<SampleType>;
+    static constexpr int lanes = int(Vec::SIMDNumElements);
+
+    static constexpr int factor = 4;
+    static constexpr int tapsPerPhase = 12;
+
+    struct State
+    {
+        Vec history[2 * tapsPerPhase];
+        int position;
+    };
+
+    KcompTruePeak()
+    {
+        //BS.1770-4 Annex 2
+        static const double table[factor][tapsPerPhase]
+        {
+            {  0.0017089843750,  0.0109863281250, -0.0196533203125,  0.0332031250000, -0.0594482421875,  0.1373291015625,
+               0.9721679687500, -0.1022949218750,  0.0476074218750, -0.0266113281250,  0.0148925781250, -0.0083007812500 },
+            { -0.0291748046875,  0.0292968750000, -0.0517578125000,  0.0891113281250, -0.1665039062500,  0.4650878906250,
+               0.7797851562500, -0.2003173828125,  0.1015625000000, -0.0582275390625,  0.0330810546875, -0.0189208984375 },
+            { -0.0189208984375,  0.0330810546875, -0.0582275390625,  0.1015625000000, -0.2003173828125,  0.7797851562500,
+               0.4650878906250, -0.1665039062500,  0.0891113281250, -0.0517578125000,  0.0292968750000, -0.0291748046875 },
+            { -0.0083007812500,  0.0148925781250, -0.0266113281250,  0.0476074218750, -0.1022949218750,  0.9721679687500,
+               0.1373291015625, -0.0594482421875,  0.0332031250000, -0.0196533203125,  0.0109863281250,  0.0017089843750 }
+        };
+
+        for (int phase = 0; phase < factor; ++phase)
+        {
+            for (int tap = 0; tap < tapsPerPhase; ++tap)
+            {
+                coefficients[phase][tap] = static_cast<SampleType>(table[phase][tap]);
+            }
+        }
+    }
+
+    void prepare(int newNumGroups)
+    {
+        numGroups = newNumGroups;
+        histories.assign(size_t(numGroups * 2 * tapsPerPhase * lanes), SampleType());
+        positions.assign(size_t(numGroups), 0);
+    }
+
+    void reset()
+    {
+        std::fill(histories.begin(), histories.end(), SampleType());
+        std::fill(positions.begin(), positions.end(), 0);
+    }
+
+    State load(int group) const noexcept
+    {
+        const auto* source = histories.data() + size_t(group * 2 * tapsPerPhase * lanes);
+
+        State state;
+        for (int frame = 0; frame < 2 * tapsPerPhase; ++frame)
+        {
+            state.history[frame] = KcompSIMD::load(source + frame * lanes);
+        }
+        state.position = positions[size_t(group)];
+        return state;
+    }
+
+    void store(int group, const State& state) noexcept
+    {
+        auto* destination = histories.data() + size_t(group * 2 * tapsPerPhase * lanes);
+        for (int frame = 0; frame < 2 * tapsPerPhase; ++frame)
+        {
+            KcompSIMD::store(destination + frame * lanes, state.history[frame]);
+        }
+        positions[size_t(group)] = state.position;
+    }
+
+    //The true peak around frame x, linear, for the engine's sample loop with its State in registers
+    forcedinline Vec process(State& state, Vec x) const noexcept
+    {
+        state.history[state.position] = x;
+        state.history[state.position + tapsPerPhase] = x;
+        state.position = state.position + 1 == tapsPerPhase ? 0 : state.position + 1;
+
+        const auto* frames = state.history + state.position;
+        return getPeak(x, [frames](int frame) { return frames[frame]; });
+    }
+
+    //The same on the history of group kept here
+    forcedinline Vec process(int group, Vec x) noexcept
+    {
+        auto* history = histories.data() + size_t(group * 2 * tapsPerPhase * lanes);
+        auto& position = positions[size_t(group)];
+        KcompSIMD::store(history + position * lanes, x);
+        KcompSIMD::store(history + (position + tapsPerPhase) * lanes, x);
+        position = position + 1 == tapsPerPhase ? 0 : position + 1;
+
+        const auto* frames = history + position * lanes;
+        return getPeak(x, [frames](int frame) { return KcompSIMD::load(frames + frame * lanes); });
+    }
+
+private:
+
+    //frame(0) to frame(tapsPerPhase - 1) run oldest to newest, x is the last one
+    template <typename FrameFunction>
+    forcedinline Vec getPeak(Vec x, FrameFunction&& frame) const noexcept
+    {
+        auto peak = KcompSIMD::abs(x);
+        for (int phase = 0; phase < factor; ++phase)
+        {
+            auto sum = Vec::expand(SampleType());
+            for (int tap = 0; tap < tapsPerPhase; ++tap)
+            {
+                sum += Vec::expand(coefficients[phase][tap]) * frame(tapsPerPhase - 1 - tap);
+            }
+            peak = Vec::max(peak, KcompSIMD::abs(sum));
+        }
+
+        return peak;
+    }
+
+    int numGroups{ 0 };
+    SampleType coefficients[factor][tapsPerPhase]{};
+    std::vector<SampleType> histories;
+    std::vector<int> positions;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(KcompTruePeak)
+};
@@ -11,6 +11,11 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "KcompMath.h"
+#include "KcompGainFifo.h"
+#include "KcompTripleBuffer.h"
+#include "KcompLoudness.h"
+#include "KcompLevelStats.h"
 
 //==============================================================================
 /*
@@ -22,173 +27,181 @@ class LevelMeter  : public juce::Component,
                     public juce::MouseListener*/
 {
 public:
+    //Levels go from the audio thread to the editor as whole snapshots through a KcompTripleBuffer. The audio
+    //thread owns the ballistics (peak hold, RMS window, clip and overall peak) and publishes what the meters
+    //should show after every block, the editor picks up the newest one on its timer. Nothing is shared but
+    //the triple buffer and a few atomics, and nothing is allocated outside prepare().
+    //
+    //The ballistics run in sample time, so they're the same whatever the host's block size. The RMS is a
+    //running sum over a ring of 32-sample bins, filled from the sums of squares of the engine's sub-blocks.
     class LevelMeterGetter
     {
-        class LevelMeterData
-        {
-        public:
-            LevelMeterData(size_t rmsWindow = 8):
-                max(),
-                maxOverall(),
-                clip(false),
-                reduction(1.0f),
-                hold(0),
-                rmsHistory((size_t) rmsWindow, 0.0),
-                rmsSum(0.0),
-                rmsPtr(0)
-            {}
-
-            LevelMeterData(const LevelMeterData& other) :
-                max(other.max.load()),
-                maxOverall(other.maxOverall.load()),
-                clip(other.clip.load()),
-                reduction(other.reduction.load()),
-                hold(other.hold.load()),
-                rmsHistory(8, 0.0),
-                rmsSum(0.0),
-                rmsPtr(0)
-            {}
-            
-            LevelMeterData& operator=(const LevelMeterData& other)
-            {
-                max.store(other.max.load());
-                maxOverall.store(other.maxOverall.load());
-                clip.store(other.clip.load());
-                reduction.store(other.reduction.load());
-                hold.store(other.hold.load());
-                rmsHistory.resize(other.rmsHistory.size(), 0.0);
-                rmsSum = 0.0;
-                rmsPtr = 0;
-                return (*this);
-            }
-
-            std::atomic<float> max;
-            std::atomic<float> maxOverall;
-            std::atomic<bool> clip;
-            std::atomic<float> reduction;
-            std::atomic<float> prevReduction;
+    public:
 
-            std::atomic<double> rmsSum;
-            std::atomic<juce::int64> hold;
-            std::vector<double> rmsHistory;
-            size_t rmsPtr;
+        static constexpr int maxChannels = KcompGainFifo::maxChannels;
+        static constexpr int rmsBinSamples = 32;
 
+        //Windows and times in ms, fall in dB per second (0 drops straight back to the level after the hold),
+        //reference is where the scale's 0 sits in dBFS, 0 for none
+        struct Ballistics
+        {
+            const char* name;
+            float rmsWindowMs;
+            float peakHoldMs;
+            float peakFallDbPerSecond;
+            float referenceDb;
+        };
 
-            float getAvgRMS() const
+        //The PPMs (IEC 60268-10) read the sample peak with their return times, their integration time is the
+        //RMS window. VU (IEC 60268-17) with 0 VU at -18 dBFS. K-System with Katz's 600 ms average.
+        static constexpr int numBallistics = 7;
+        static const Ballistics& getBallistics(const int index)
+        {
+            static const Ballistics ballistics[numBallistics]
             {
-                if (rmsHistory.size() > 0)
-                {
-                    return(std::sqrt(std::accumulate(rmsHistory.begin(), rmsHistory.end(), 0.0f) / static_cast<float>(rmsHistory.size())));
-                }
-                return float(std::sqrt(rmsSum));
-            }
+                { "Kcomp",          1000.0f,  100.0f,  0.0f,           0.0f },
+                { "PPM Type I",     5.0f,     0.0f,    20.0f / 1.5f,   0.0f },
+                { "PPM Type II",    10.0f,    0.0f,    24.0f / 2.8f,   0.0f },
+                { "VU",             300.0f,   100.0f,  0.0f,          -18.0f },
+                { "K-12",           600.0f,   1000.0f, 0.0f,          -12.0f },
+                { "K-14",           600.0f,   1000.0f, 0.0f,          -14.0f },
+                { "K-20",           600.0f,   1000.0f, 0.0f,          -20.0f }
+            };
+
+            return ballistics[juce::jlimit(0, numBallistics - 1, index)];
+        }
 
-            
-            void pushNextRMS(const float newRMS)
+        static juce::StringArray getBallisticsNames()
+        {
+            juce::StringArray names;
+            for (int index = 0; index < numBallistics; ++index)
             {
-                const double squaredRMS = std::min(newRMS * newRMS, 1.0f);
-                if (rmsHistory.size() > 0)
-                {
-                    rmsHistory[(size_t)rmsPtr] = squaredRMS;
-                    rmsPtr = (rmsPtr + 1) % rmsHistory.size();
-                }
-                else
-                {
-                    rmsSum = squaredRMS;
-                }
+                names.add(getBallistics(index).name);
             }
+            return names;
+        }
 
+        //What the meters show, one array per value so a snapshot covers every channel
+        struct Snapshot
+        {
+            float peaks[maxChannels]{};             //held peak, falls after the hold
+            float overallPeaks[maxChannels]{};     //true peaks when there are any, see loadMeterData()
+            float rmsLevels[maxChannels]{};
+            bool clips[maxChannels]{};
+            int numChannels{ 0 };
+            bool truePeak{ false };                 //overallPeaks and clips come from true peaks
+            float referenceDb{ 0.0f };
+            KcompLoudnessMeter::Reading inputLoudness, outputLoudness;
+            float inputCrestFactors[maxChannels]{}, outputCrestFactors[maxChannels]{};     //linear, 0 for silence
+            float dcOffsets[maxChannels]{};         //of the input
+        };
 
-            void setLevels(const juce::int64 time, const float newMax, const float newRMS, const juce::int64 newHoldms)
-            {
-                if (newMax > 1.0 || newRMS > 1.0)
-                {
-                    clip = true;
-                }
-
-                maxOverall = fmaxf(maxOverall, newMax);
+        LevelMeterGetter()
+        {
+            std::fill(std::begin(reductions), std::end(reductions), 1.0f);
+        }
 
-                if (newMax >= max)
-                {
-                    max = std::min(1.0f, newMax);
-                    hold = time + newHoldms;
-                }
-                else if (time > hold)
-                {
-                    max = std::min(1.0f, newMax);
-                }
+        ~LevelMeterGetter()
+        {
+            masterReference.clear();
+        }
 
-                pushNextRMS(std::min(1.0f, newRMS));
-            }
+        //Not while the audio thread is measuring. The RMS bins are sized for the longest window of any ballistics.
+        void prepare(const int channels, const double newSampleRate)
+        {
+            sampleRate = newSampleRate;
 
-            void setRMSSize(const size_t numBlocks)
+            auto longestWindowMs = 0.0f;
+            for (int index = 0; index < numBallistics; ++index)
             {
-                rmsHistory.assign(numBlocks, 0.0);
-                rmsSum = 0.0;
-                if (numBlocks > 1)
-                {
-                    rmsPtr %= rmsHistory.size();
-                }
-                else
-                {
-                    rmsPtr = 0;
-                }
+                longestWindowMs = juce::jmax(longestWindowMs, getBallistics(index).rmsWindowMs);
             }
+            maxRmsBins = size_t(juce::jmax(1, juce::roundToInt(longestWindowMs * 0.001 * sampleRate / rmsBinSamples)));
+            rmsBins.assign(size_t(maxChannels) * maxRmsBins, 0.0);
 
-        };
-          //LevelMeterGetter Class Continues 
-    public:
+            measured = Snapshot();
+            measured.numChannels = juce::jlimit(0, maxChannels, channels);
+            updateBallistics();
+            inputLoudness.prepare(sampleRate);
+            outputLoudness.prepare(sampleRate);
 
-        ~LevelMeterGetter()
-        {
-            masterReference.clear();
+            levels.getWriteSlot() = measured;
+            levels.publish();
         }
 
-        void resize(const int channels, const int rmsWindow)
+        //Audio thread, an index into getBallistics()
+        void setBallistics(const int newIndex)
         {
-            meterData.resize(size_t(channels), LevelMeterData(size_t(rmsWindow)));
-            for (auto& d : meterData)
+            const auto index = juce::jlimit(0, numBallistics - 1, newIndex);
+            if (index != ballisticsIndex)
             {
-                d.setRMSSize(size_t(rmsWindow));
+                ballisticsIndex = index;
+                updateBallistics();
             }
-            updateMeter = true;
         }
 
+        //Crest factors and DC offsets the engine measured in its sample loop, before loadMeterData(). Audio thread.
         template<typename FloatType>
-        void loadMeterData(const juce::AudioBuffer<FloatType>& buffer)
+        void loadLevelStats(const KcompLevelStats<FloatType>& input, const KcompLevelStats<FloatType>& output, const int numChannels)
         {
-            if (!suspended)
+            for (int channel = 0; channel < juce::jmin(numChannels, maxChannels); ++channel)
             {
-                const int numChannels = buffer.getNumChannels();
-                const int numSamples = buffer.getNumSamples();
+                measured.inputCrestFactors[channel] = float(input.getCrestFactors()[channel]);
+                measured.outputCrestFactors[channel] = float(output.getCrestFactors()[channel]);
+                measured.dcOffsets[channel] = float(input.getDCOffsets()[channel]);
+            }
+        }
 
-                meterData.resize(size_t(numChannels));
+        //Levels the engine measured while processing: the input peaks, and the sums of squares
+        //of each sub-block for the RMS (a sleeping engine has none, its block counts as silence). Audio thread.
+        //The overall peaks and the clip flags follow truePeaks when there are any (dBTP, the engine's output
+        //tap), the sample peaks otherwise.
+        template<typename FloatType>
+        void loadMeterData(const KcompLevelStats<FloatType>& input, const int numChannels, const int numSamples,
+                           const FloatType* truePeaks = nullptr)
+        {
+            loadMeterData(input.getPeaks(), input.getSubBlockSumsOfSquares(), size_t(input.getNumLanes()), input.getSubBlockLengths(),
+                          input.getNumSubBlocks(), juce::jmin(numChannels, input.getNumLanes()), numSamples, truePeaks);
+        }
 
-                for (int channel = 0; channel < std::min(numChannels, int(meterData.size())); ++channel)
-                {
-                    meterData[size_t(channel)].setLevels(lastMeasurement,
-                        buffer.getMagnitude(channel, 0, numSamples),
-                        buffer.getRMSLevel(channel, 0, numSamples),
-                        holdMS);
-                }
+        //Message thread: takes the newest levels, true when there were any
+        bool readLevels()
+        {
+            if (! levels.acquire())
+            {
+                return false;
             }
+
+            shown = levels.getReadSlot();
+            msSinceLevels = 0;
             updateMeter = true;
+            return true;
         }
 
-        void decay()
+        //Message thread, elapsedMs after the last call: the reductions recover while nothing comes in, and the
+        //levels fall once the audio stops
+        void decay(const int elapsedMs)
         {
-            juce::int64 time = juce::Time::currentTimeMillis();
-            if (time - lastMeasurement < holdMS)
+            msSinceLevels += elapsedMs;
+            if (msSinceLevels >= silenceAfterMs)
             {
-                return;
+                std::fill(std::begin(shown.peaks), std::end(shown.peaks), 0.0f);
+                std::fill(std::begin(shown.rmsLevels), std::end(shown.rmsLevels), 0.0f);
             }
 
-            lastMeasurement = time;
-            for (size_t channel = 0; channel < meterData.size(); ++channel)
+            //a tenth of the way back every 100 ms, readReductions() sets the real value while the audio runs
+            const auto recovery = 1.0f - std::pow(0.9f, float(elapsedMs) * 0.01f);
+            for (auto& reduction : reductions)
             {
-                meterData[channel].setLevels(lastMeasurement, 0.0f, 0.0f, holdMS);
-                meterData[0].reduction = meterData[0].reduction * 0.9f;
-                meterData[1].reduction = meterData[1].reduction * 0.9f;
+                reduction = reduction + (1.0f - reduction) * recovery;
+            }
+
+            for (auto& bandReduction : bandReductions)
+            {
+                auto current = bandReduction.load();
+                while (!bandReduction.compare_exchange_weak(current, current + (1.0f - current) * recovery))
+                {
+                }
             }
             
             updateMeter = true;
@@ -209,29 +222,78 @@ public:
             suspended = shouldBeSus;
         }
 
-        void setMaxHoldMs(const juce::int64 millis)
+        //Lowest gain of each band since the editor last looked, the editor lets it recover in decay()
+        template<typename FloatType>
+        void setBandReductions(const FloatType* bandGains, const int newNumBands)
+        {
+            numBands = juce::jlimit(1, maxBands, newNumBands);
+            for (int band = 0; band < numBands; ++band)
+            {
+                const auto gain = float(bandGains[band]);
+                auto current = bandReductions[band].load();
+                while (gain < current && !bandReductions[band].compare_exchange_weak(current, gain))
+                {
+                }
+            }
+        }
+
+        int getNumBands() const
         {
-            holdMS = millis;
+            return numBands;
         }
 
-        void setReductionLevel(const float newMag, int channel)
+        float getBandReduction(const int band) const
         {
-            if (updateMeter)
+            return bandReductions[band];
+        }
+
+        //The engine pushes the gain it applied into this, see KcompEngine::setGainFifo()
+        void setGainFifo(KcompGainFifo* newFifo)
+        {
+            gainFifo = newFifo;
+        }
+
+        //For KcompEngine::setLoudnessMeters(), the engine feeds them on the audio thread while it processes
+        KcompLoudnessMeter* getInputLoudnessMeter()     { return &inputLoudness; }
+        KcompLoudnessMeter* getOutputLoudnessMeter()    { return &outputLoudness; }
+
+        //Message thread: the lowest gain of each channel since the last call becomes its reduction
+        void readReductions()
+        {
+            if (gainFifo == nullptr)
             {
-                meterData[channel].reduction = juce::jmap<float>(meterData[channel].max - newMag, 1.0f, 0.0f);
+                return;
             }
-            /*else
+
+            float lowest[KcompGainFifo::maxChannels];
+            std::fill(std::begin(lowest), std::end(lowest), 1.0f);
+
+            const auto numFrames = gainFifo->read([&lowest](const KcompGainFifo::Frame& frame)
             {
-                meterData[channel].reduction = 1.0f;
-            }*/
-            
+                for (int channel = 0; channel < frame.numChannels; ++channel)
+                {
+                    lowest[channel] = juce::jmin(lowest[channel], frame.gains[channel]);
+                }
+            });
+
+            if (numFrames > 0)
+            {
+                std::copy(std::begin(lowest), std::end(lowest), std::begin(reductions));
+                updateMeter = true;
+            }
+        }
+
+        //The getters below are for the message thread and read the levels readLevels() took last
+        int getNumChannels() const
+        {
+            return shown.numChannels;
         }
 
         float getReductionLevel(const int channel) const
         {
             if (updateMeter)
             {
-                return meterData.at(size_t(channel)).reduction;
+                return reductions[channel];
             }
             else
             {
@@ -242,56 +304,274 @@ public:
         float getPrevReduction(const int channel)
         {
 
-            return meterData.at(size_t(channel)).prevReduction;
+            return prevReductions[channel];
 
         }
 
         void setPrevReduction(const float newPrev, int channel)
         {
-            meterData[channel].prevReduction = newPrev;
+            prevReductions[channel] = newPrev;
         }
 
         float getRMSLevel(const int channel) const
         {
-            return meterData.at(size_t(channel)).getAvgRMS();
+            return shown.rmsLevels[channel];
         }
 
         float getMaxLevel(const int channel) const
         {
-            return meterData.at(size_t(channel)).max;
+            return shown.peaks[channel];
         }
 
         float getMaxOverallLevel(const int channel)
         {
-            return meterData.at(size_t(channel)).maxOverall;
+            return shown.overallPeaks[channel];
         }
 
+        //the audio thread clears its own copy before the next block
         void clearMaxOveralls()
         {
-            for (LevelMeterData& channel : meterData)
+            std::fill(std::begin(shown.overallPeaks), std::end(shown.overallPeaks), infinity);
+            clearOverallsRequested = true;
+        }
+
+        bool getClipFlag(const int channel) const
+        {
+            return shown.clips[channel];
+        }
+
+        //True when the overall peaks and the clip flags are true peaks
+        bool isTruePeak() const
+        {
+            return shown.truePeak;
+        }
+
+        //EBU R128 loudness of the input and the output
+        const KcompLoudnessMeter::Reading& getInputLoudness() const
+        {
+            return shown.inputLoudness;
+        }
+
+        const KcompLoudnessMeter::Reading& getOutputLoudness() const
+        {
+            return shown.outputLoudness;
+        }
+
+        //Highest crest factor of any channel in the last block, linear
+        float getCrestFactor(const bool output) const
+        {
+            const auto* crestFactors = output ? shown.outputCrestFactors : shown.inputCrestFactors;
+            return *std::max_element(crestFactors, crestFactors + juce::jmax(1, shown.numChannels));
+        }
+
+        //Largest DC offset of any channel in the last block, with its sign
+        float getDCOffset() const
+        {
+            auto offset = 0.0f;
+            for (int channel = 0; channel < shown.numChannels; ++channel)
             {
-                channel.maxOverall = infinity;
+                if (std::abs(shown.dcOffsets[channel]) > std::abs(offset))
+                {
+                    offset = shown.dcOffsets[channel];
+                }
             }
+            return offset;
         }
 
-        bool getClipFlag(const int channel) const
+        //Integrated loudness and range start over, on the audio thread before the next block
+        void resetLoudness()
+        {
+            resetLoudnessRequested = true;
+        }
+
+        //Where the scale's 0 sits for the current ballistics, 0 dBFS when it has none
+        float getReferenceDb() const
         {
-            return meterData.at(size_t(channel)).clip;
+            return shown.referenceDb;
         }
 
         void clearAllClipFlags()
         {
-            for (LevelMeterData& l : meterData)
+            std::fill(std::begin(shown.clips), std::end(shown.clips), false);
+            clearClipsRequested = true;
+        }
+
+        static constexpr int maxBands = 4;
+
+    private:
+
+        //Audio thread: peaks, and the sums of squares of numStretches consecutive stretches of the block, stride
+        //apart with one value per channel
+        template<typename FloatType>
+        void loadMeterData(const FloatType* peaks, const double* sumsOfSquares, const size_t stride, const int* lengths, const int numStretches,
+                           const int numChannels, const int numSamples, const FloatType* truePeaks)
+        {
+            if (suspended || rmsBins.empty())
+            {
+                return;
+            }
+
+            if (clearClipsRequested.exchange(false, std::memory_order_relaxed))
+            {
+                std::fill(std::begin(measured.clips), std::end(measured.clips), false);
+            }
+            if (clearOverallsRequested.exchange(false, std::memory_order_relaxed))
+            {
+                std::fill(std::begin(measured.overallPeaks), std::end(measured.overallPeaks), infinity);
+            }
+            if (resetLoudnessRequested.exchange(false, std::memory_order_relaxed))
+            {
+                inputLoudness.reset();
+                outputLoudness.reset();
+            }
+
+            measured.numChannels = juce::jmin(numChannels, maxChannels);
+            measured.truePeak = truePeaks != nullptr;
+            for (int channel = 0; channel < measured.numChannels; ++channel)
+            {
+                updatePeak(channel, float(peaks[channel]), numSamples);
+                updateOverall(channel, float(truePeaks != nullptr ? truePeaks[channel] : peaks[channel]));
+            }
+            updateRMS(sumsOfSquares, stride, lengths, numStretches, numSamples);
+            measured.inputLoudness = inputLoudness.getReading();
+            measured.outputLoudness = outputLoudness.getReading();
+
+            levels.getWriteSlot() = measured;
+            levels.publish();
+        }
+
+        //Audio thread: windows and times of the current ballistics in samples. Starts the RMS over.
+        void updateBallistics()
+        {
+            const auto& ballistics = getBallistics(ballisticsIndex);
+            rmsNumBins = juce::jlimit(size_t(1), maxRmsBins, size_t(juce::roundToInt(ballistics.rmsWindowMs * 0.001 * sampleRate / rmsBinSamples)));
+            holdSamples = juce::int64(ballistics.peakHoldMs * 0.001 * sampleRate);
+            fallPerSample = ballistics.peakFallDbPerSecond > 0.0f
+                          ? std::pow(10.0, -ballistics.peakFallDbPerSecond / (20.0 * sampleRate))
+                          : 0.0;
+            measured.referenceDb = ballistics.referenceDb;
+
+            std::fill(rmsBins.begin(), rmsBins.end(), 0.0);
+            std::fill(std::begin(binSums), std::end(binSums), 0.0);
+            std::fill(std::begin(rmsSums), std::end(rmsSums), 0.0);
+            std::fill(std::begin(holdRemaining), std::end(holdRemaining), juce::int64());
+            binIndex = 0;
+            binFill = 0;
+        }
+
+        //Audio thread: anything over full scale is a clip, between the samples too when newMax is a true peak
+        void updateOverall(const int channel, const float newMax)
+        {
+            if (newMax > 1.0f)
+            {
+                measured.clips[channel] = true;
+            }
+
+            measured.overallPeaks[channel] = fmaxf(measured.overallPeaks[channel], newMax);
+        }
+
+        //Audio thread: peak hold, then the fall, over a block of numSamples
+        void updatePeak(const int channel, const float newMax, const int numSamples)
+        {
+            auto& peak = measured.peaks[channel];
+            if (newMax >= peak)
+            {
+                peak = std::min(1.0f, newMax);
+                holdRemaining[channel] = holdSamples;
+                return;
+            }
+
+            const auto falling = numSamples - holdRemaining[channel];
+            holdRemaining[channel] = juce::jmax(juce::int64(), holdRemaining[channel] - numSamples);
+            if (falling > 0)
+            {
+                const auto fallen = fallPerSample > 0.0 ? float(peak * std::pow(fallPerSample, double(falling))) : 0.0f;
+                peak = std::min(1.0f, juce::jmax(newMax, fallen));
+            }
+        }
+
+        //Audio thread: each stretch's sums of squares go into the bins it covers, spread evenly when it runs into the
+        //next bin, O(1) per finished bin. Whatever numSamples has left after the stretches is silence.
+        void updateRMS(const double* sumsOfSquares, const size_t stride, const int* lengths, const int numStretches, const int numSamples)
+        {
+            auto remaining = numSamples;
+            for (int stretch = 0; stretch <= numStretches && remaining > 0; ++stretch)
+            {
+                const auto* sums = stretch < numStretches ? sumsOfSquares + size_t(stretch) * stride : nullptr;
+                const auto length = sums != nullptr ? juce::jmin(lengths[stretch], remaining) : remaining;
+                remaining -= length;
+
+                for (int done = 0; done < length;)
+                {
+                    const auto num = juce::jmin(length - done, rmsBinSamples - binFill);
+                    if (sums != nullptr)
+                    {
+                        const auto share = double(num) / length;
+                        for (int channel = 0; channel < measured.numChannels; ++channel)
+                        {
+                            binSums[channel] += sums[channel] * share;
+                        }
+                    }
+
+                    done += num;
+                    binFill += num;
+                    if (binFill == rmsBinSamples)
+                    {
+                        finishBin();
+                    }
+                }
+            }
+
+            const auto windowSamples = double(rmsNumBins * rmsBinSamples);
+            for (int channel = 0; channel < measured.numChannels; ++channel)
+            {
+                measured.rmsLevels[channel] = float(std::sqrt(juce::jmin(1.0, rmsSums[channel] / windowSamples)));
+            }
+        }
+
+        //Audio thread: the finished bin takes the place of the oldest one in the window
+        void finishBin()
+        {
+            for (int channel = 0; channel < measured.numChannels; ++channel)
             {
-                l.clip = false;
+                auto& oldest = rmsBins[size_t(channel) * maxRmsBins + binIndex];
+                rmsSums[channel] = juce::jmax(0.0, rmsSums[channel] + binSums[channel] - oldest);
+                oldest = binSums[channel];
+                binSums[channel] = 0.0;
             }
+            binIndex = (binIndex + 1) % rmsNumBins;
+            binFill = 0;
         }
 
+        //audio thread
+        Snapshot measured;
+        std::vector<double> rmsBins;        //maxRmsBins summed squares per channel, the first rmsNumBins are the window
+        size_t maxRmsBins{ 0 }, rmsNumBins{ 1 }, binIndex{ 0 };
+        int binFill{ 0 };
+        double binSums[maxChannels]{}, rmsSums[maxChannels]{};
+        juce::int64 holdRemaining[maxChannels]{};
+        juce::int64 holdSamples{ 0 };
+        double fallPerSample{ 0.0 };
+        double sampleRate{ 44100.0 };
+        int ballisticsIndex{ 0 };
+
+        KcompLoudnessMeter inputLoudness, outputLoudness;
+
+        KcompTripleBuffer<Snapshot> levels;
+        std::atomic<bool> clearClipsRequested{ false }, clearOverallsRequested{ false }, resetLoudnessRequested{ false };
+        std::atomic<bool> suspended{ false };
+
+        //message thread
+        Snapshot shown;
+        float reductions[maxChannels];
+        float prevReductions[maxChannels]{};
+        static constexpr int silenceAfterMs = 100;
+        int msSinceLevels{ 0 };
         bool updateMeter{ true };
-        bool suspended{ false };
-        std::vector<LevelMeterData> meterData;
-        std::atomic<juce::int64> lastMeasurement;
-        juce::int64 holdMS{100};
+
+        std::atomic<int> numBands{ 1 };
+        std::atomic<float> bandReductions[maxBands]{ {1.0f}, {1.0f}, {1.0f}, {1.0f} };
+        KcompGainFifo* gainFifo = nullptr;
 
         juce::WeakReference<LevelMeterGetter>::Master masterReference;
         friend class juce::WeakReference<LevelMeterGetter>;
@@ -313,14 +593,14 @@ public:
         peakLLabel.setFont({ 10.0f, juce::Font::FontStyleFlags::plain });
         peakLLabel.setJustificationType(juce::Justification::centred);
         peakLLabel.setEditable(false);
-        peakLLabel.setTooltip("Double-Click anywhere on the meter to reset.");
+        peakLLabel.setTooltip("Highest peak of the output, between the samples too. Double-Click anywhere on the meter to reset.");
 
         addAndMakeVisible(peakRLabel);
         peakRLabel.setText("0.00", juce::dontSendNotification);
         peakRLabel.setFont({ 10.0f, juce::Font::FontStyleFlags::plain });
         peakRLabel.setJustificationType(juce::Justification::centred);
         peakRLabel.setEditable(false);
-        peakRLabel.setTooltip("Double-Click anywhere on the meter to reset.");
+        peakRLabel.setTooltip("Highest peak of the output, between the samples too. Double-Click anywhere on the meter to reset.");
 
         //Gain Reduction Labels
         addAndMakeVisible(grLLabel);
@@ -358,7 +638,14 @@ public:
         
 
 
-        for (auto channel = 0; channel < source->meterData.size() ; ++channel)
+        //one more rectangle than channels, the layout can change after the editor was built
+        while (levelMeters.size() < source->getNumChannels() + 1)
+        {
+            levelMeters.add(new juce::Rectangle<float>);
+        }
+        levelMeters.removeRange(source->getNumChannels() + 1, levelMeters.size());
+
+        for (auto channel = 0; channel < source->getNumChannels() ; ++channel)
         {
             g.setColour(meterColor);
             juce::Rectangle<float> channelRect = { area.getX(), area.getY() + grLabelOffset, area.getWidth(), area.getHeight() - peakLabelOffset - grLabelOffset };
@@ -380,12 +667,12 @@ public:
 
 
             //draws Level Meter
-            rmsDB = juce::Decibels::gainToDecibels(source->getRMSLevel(channel), infinity);
+            rmsDB = KcompMath::gainToDecibels<KcompMath::Accuracy::coarse>(source->getRMSLevel(channel), infinity);
             g.fillRect(meter->withTop(meter->getY() + rmsDB * meter->getHeight() / infinity));
 
 
             //draws Peak bar
-            peakDB = juce::Decibels::gainToDecibels(source->getMaxLevel(channel), infinity);
+            peakDB = KcompMath::gainToDecibels<KcompMath::Accuracy::coarse>(source->getMaxLevel(channel), infinity);
             if (peakDB > -80)
             {
                 g.drawHorizontalLine(juce::jmax<float>(meter->getY() + peakDB * meter->getHeight() / infinity, grLabelOffset), meter->getX(), meter->getRight());
@@ -400,7 +687,28 @@ public:
             
         }
         
-        source->decay();
+        //draws the scale's 0 of the ballistics that have one
+        if (source->getReferenceDb() < 0.0f)
+        {
+            g.setColour(juce::Colours::white.withAlpha(0.6f));
+            g.drawHorizontalLine(juce::roundToInt(metersBackground.getY() + source->getReferenceDb() * metersBackground.getHeight() / infinity),
+                                 metersBackground.getX(), metersBackground.getRight());
+        }
+
+        //draws per-band Reduction bars, hanging from the top of the meters
+        if (source->getNumBands() > 1)
+        {
+            const auto numBands = source->getNumBands();
+            const auto bandWidth = metersBackground.getWidth() / numBands;
+
+            g.setColour(juce::Colours::orange.withAlpha(0.8f));
+            for (int band = 0; band < numBands; ++band)
+            {
+                auto reductionDB = KcompMath::gainToDecibels<KcompMath::Accuracy::coarse>(source->getBandReduction(band), bandReductionRange);
+                g.fillRect(metersBackground.getX() + band * bandWidth + 2.0f, metersBackground.getY(),
+                           bandWidth - 4.0f, reductionDB * metersBackground.getHeight() / bandReductionRange);
+            }
+        }
 
         //draws Reduction Meter
         //auto reInfinity = infinity + 50.0f;
@@ -469,29 +777,42 @@ public:
 
     void timerCallback() override
     {
+        if (source)
+        {
+            source->readLevels();
+            source->readReductions();
+            source->decay(1000 / refreshRate);
+        }
+
         if ((source && source->shouldUpdateMeter()) || bgNeedsRepaint)
         {
-            
-            if (source->getClipFlag(0))
+            if (source == nullptr || source->getNumChannels() == 0)
             {
-                peakLLabel.setText("CLIP", juce::dontSendNotification);
-            }
-            if (source->getClipFlag(1))
-            {
-                peakRLabel.setText("CLIP", juce::dontSendNotification);
+                return;
             }
-            else
+
+            //the labels show the first two channels, mono shows the same channel twice
+            const auto right = juce::jmin(1, source->getNumChannels() - 1);
+
+            //highest peak since the reset, in dBTP when it's the true peak of the output
+            const auto unit = source->isTruePeak() ? " dBTP" : " dB";
+            auto showPeak = [&](juce::Label& label, const int channel)
             {
-                auto leftPeak = juce::Decibels::gainToDecibels(juce::jmin<float>(source->getMaxOverallLevel(0), 1.0f));
-                auto rightPeak = juce::Decibels::gainToDecibels(juce::jmin<float>(source->getMaxOverallLevel(1), 1.0f));
-                
-                peakLLabel.setText(juce::String(leftPeak).dropLastCharacters(3) + " dB", juce::dontSendNotification);
-                peakRLabel.setText(juce::String(rightPeak).dropLastCharacters(3) + " dB", juce::dontSendNotification);
-                
-            }
+                if (source->getClipFlag(channel))
+                {
+                    label.setText("CLIP", juce::dontSendNotification);
+                    return;
+                }
 
-            auto leftGR = juce::Decibels::gainToDecibels(source->getReductionLevel(0));
-            auto rightGR = juce::Decibels::gainToDecibels(source->getReductionLevel(1));
+                auto peak = KcompMath::gainToDecibels<KcompMath::Accuracy::fine>(juce::jmin<float>(source->getMaxOverallLevel(channel), 1.0f));
+                label.setText(juce::String(peak, 1) + unit, juce::dontSendNotification);
+            };
+
+            showPeak(peakLLabel, 0);
+            showPeak(peakRLabel, right);
+
+            auto leftGR = KcompMath::gainToDecibels<KcompMath::Accuracy::fine>(source->getReductionLevel(0));
+            auto rightGR = KcompMath::gainToDecibels<KcompMath::Accuracy::fine>(source->getReductionLevel(right));
 
             if (leftGR < -1.0f || rightGR < -1.0f)
             {
@@ -504,6 +825,11 @@ public:
                 grRLabel.setText("0.0 dB", juce::dontSendNotification);
             }
 
+            setTooltip("In:  " + getLoudnessText(source->getInputLoudness()) + "\nOut: " + getLoudnessText(source->getOutputLoudness())
+                       + "\nCrest " + getCrestText(source->getCrestFactor(false)) + " > " + getCrestText(source->getCrestFactor(true))
+                       + " dB  DC " + juce::String(source->getDCOffset(), 4)
+                       + "\nDouble-click to reset.");
+
             if (source)
             {
                 source->resetUpdateMeter();
@@ -518,11 +844,28 @@ public:
     {
         source->clearAllClipFlags();
         source->clearMaxOveralls();
+        source->resetLoudness();
     }
 
 
 private:
 
+    static juce::String getLoudnessText(const KcompLoudnessMeter::Reading& reading)
+    {
+        auto lufs = [](float value)
+        {
+            return value > float(KcompLoudnessMeter::minimumLufs) ? juce::String(value, 1) : juce::String("-inf");
+        };
+
+        return "M " + lufs(reading.momentary) + "  S " + lufs(reading.shortTerm) + "  I " + lufs(reading.integrated)
+             + " LUFS  LRA " + juce::String(reading.range, 1) + " LU";
+    }
+
+    static juce::String getCrestText(float crestFactor)
+    {
+        return crestFactor > 0.0f ? juce::String(juce::Decibels::gainToDecibels(crestFactor), 1) : juce::String("-");
+    }
+
     juce::WeakReference<LevelMeterGetter> source;
     
 
@@ -538,6 +881,7 @@ private:
     juce::Colour meterColor{ juce::Colours::lime };
 
     int refreshRate = 30;
+    float bandReductionRange = -30.0f;
     
     int peakLabelOffset = 25;
     int grLabelOffset = 25;
@@ -15,7 +15,7 @@
 
 //==============================================================================
 KcompAudioProcessorEditor::KcompAudioProcessorEditor(KcompAudioProcessor& p, juce::AudioProcessorValueTreeState& vts)
-    : AudioProcessorEditor(&p), audioProcessor(p), valueTreeState(vts), levelMeter(p.getTotalNumInputChannels())
+    : AudioProcessorEditor(&p), audioProcessor(p), valueTreeState(vts), levelMeter(p.getMainBusNumInputChannels())
 {
 
     
@@ -78,8 +78,46 @@ KcompAudioProcessorEditor::KcompAudioProcessorEditor(KcompAudioProcessor& p, juc
         root->addSubMenu(presetsHeadingStrings[heading], *subMenus[heading]);
     }
     presetsCombo.onChange = [this] { logger->printDebug(juce::String(presetsCombo.getSelectedId()), "Currently Selected Preset ID"); };
+
+    //Oversampling, items have to be there before the attachments
+    addAndMakeVisible(oversamplingCombo);
+    oversamplingCombo.addItemList({ "1x", "2x", "4x", "8x" }, 1);
+    oversamplingCombo.setTooltip("Oversamples the compressor and make-up gain. Adds latency.");
+    oversamplingComboAttachment.reset(new ComboBoxAttachment(valueTreeState, oversamplingParam_ID, oversamplingCombo));
+
+    addAndMakeVisible(oversamplingFilterCombo);
+    oversamplingFilterCombo.addItemList({ "Low Latency", "Linear Phase" }, 1);
+    oversamplingFilterComboAttachment.reset(new ComboBoxAttachment(valueTreeState, oversamplingFilterParam_ID, oversamplingFilterCombo));
     
 
+    //Sidechain key
+    addAndMakeVisible(sidechainButton);
+    sidechainButton.setClickingTogglesState(true);
+    sidechainButton.setButtonText("SC");
+    sidechainButton.setTooltip("Compresses with the sidechain input as the key, when the host connects one.");
+    sidechainButtonAttachment.reset(new ButtonAttachment(valueTreeState, sidechainParam_ID, sidechainButton));
+
+    addAndMakeVisible(keyListenButton);
+    keyListenButton.setClickingTogglesState(true);
+    keyListenButton.setButtonText("Listen");
+    keyListenButton.setTooltip("Plays the filtered key instead of the compressed signal.");
+    keyListenButtonAttachment.reset(new ButtonAttachment(valueTreeState, keyListenParam_ID, keyListenButton));
+
+    for (auto* slider : { &keyHighPassSlider, &keyLowPassSlider })
+    {
+        addAndMakeVisible(slider);
+        slider->setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
+        slider->setTextBoxStyle(juce::Slider::TextEntryBoxPosition::TextBoxRight, false, 65, 20);
+        slider->setColour(juce::Slider::ColourIds::textBoxOutlineColourId, juce::Colours::transparentBlack);
+        slider->setColour(juce::Slider::ColourIds::textBoxBackgroundColourId, juce::Colours::transparentBlack);
+    }
+    keyHighPassSlider.setTooltip("High-pass on the key. Off all the way left.");
+    keyHighPassSliderAttachment.reset(new SliderAttachment(valueTreeState, keyHighPassParam_ID, keyHighPassSlider));
+    keyHighPassSlider.setTextValueSuffix(" Hz");
+    keyLowPassSlider.setTooltip("Low-pass on the key. Off all the way right.");
+    keyLowPassSliderAttachment.reset(new SliderAttachment(valueTreeState, keyLowPassParam_ID, keyLowPassSlider));
+    keyLowPassSlider.setTextValueSuffix(" Hz");
+
     //Input 
     addAndMakeVisible(inputSlider);
     inputSlider.setSliderStyle(juce::Slider::SliderStyle::RotaryHorizontalVerticalDrag);
@@ -87,7 +125,6 @@ KcompAudioProcessorEditor::KcompAudioProcessorEditor(KcompAudioProcessor& p, juc
     inputSlider.setColour(juce::Slider::ColourIds::textBoxOutlineColourId, juce::Colours::transparentBlack);
     inputSlider.setColour(juce::Slider::ColourIds::textBoxBackgroundColourId, juce::Colours::transparentBlack);
     inputGainAttachment.reset(new SliderAttachment(valueTreeState, inputGainParam_ID, inputSlider));
-    inputSlider.onValueChange = [this] { audioProcessor.setInputGain(inputSlider.getValue()); };
     
     addAndMakeVisible(inputLabel);
     inputLabel.attachToComponent(&inputSlider, false);
@@ -100,7 +137,6 @@ KcompAudioProcessorEditor::KcompAudioProcessorEditor(KcompAudioProcessor& p, juc
     thresholdSlider.setSliderStyle(juce::Slider::SliderStyle::LinearVertical);
     thresholdSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::NoTextBox, false, 0, 0);
     thresholdSliderAttachment.reset(new SliderAttachment(valueTreeState, thresholdParam_ID, thresholdSlider));
-    thresholdSlider.onValueChange = [this] { audioProcessor.setThreshold(thresholdSlider.getValue()); };
 
     addAndMakeVisible(thresholdLabel);
     thresholdLabel.attachToComponent(&thresholdSlider, false);
@@ -112,50 +148,116 @@ KcompAudioProcessorEditor::KcompAudioProcessorEditor(KcompAudioProcessor& p, juc
     makeUpGainSlider.setSliderStyle(juce::Slider::SliderStyle::LinearVertical);
     makeUpGainSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::NoTextBox, false, 0, 0);
     makeUpGainAttachment.reset(new SliderAttachment(valueTreeState, makeUpGainParam_ID, makeUpGainSlider));
-    makeUpGainSlider.onValueChange = [this] { audioProcessor.setMakeUpGain(makeUpGainSlider.getValue()); };
 
     addAndMakeVisible(makeUpGainLabel);
     makeUpGainLabel.attachToComponent(&makeUpGainSlider, false);
     makeUpGainLabel.setJustificationType(juce::Justification::centred);
     makeUpGainLabel.setFont(kCompLaf.mainFont);
 
-    //Ratio Buttons
-    addAndMakeVisible(ratio1Button);
-    ratio1Button.setButtonText(juce::String(audioProcessor.getRatioValue(ratioOneParam_ID)));
-    ratio1ButtonAttachment.reset(new ButtonAttachment(valueTreeState, ratioOneParam_ID, ratio1Button));
-    ratio1Button.onClick = [this] { updateRatioState(&ratio1Button, ratioOneParam_ID); };
-    
-    addAndMakeVisible(ratio2Button);
-    ratio2Button.setButtonText(juce::String(audioProcessor.getRatioValue(ratioTwoParam_ID)));
-    ratio2ButtonAttachment.reset(new ButtonAttachment(valueTreeState, ratioTwoParam_ID, ratio2Button));
-    ratio2Button.onClick = [this] { updateRatioState(&ratio2Button, ratioTwoParam_ID); };
-    
-    addAndMakeVisible(ratio3Button);
-    ratio3Button.setButtonText(juce::String(audioProcessor.getRatioValue(ratioThreeParam_ID)));
-    ratio3ButtonAttachment.reset(new ButtonAttachment(valueTreeState, ratioThreeParam_ID, ratio3Button));
-    ratio3Button.onClick = [this] { updateRatioState(&ratio3Button, ratioThreeParam_ID); };
-    
-    addAndMakeVisible(ratio4Button);
-    ratio4Button.setButtonText(juce::String(audioProcessor.getRatioValue(ratioFourParam_ID)));
-    ratio4ButtonAttachment.reset(new ButtonAttachment(valueTreeState, ratioFourParam_ID, ratio4Button));
-    ratio4Button.onClick = [this] { updateRatioState(&ratio4Button, ratioFourParam_ID); };
-    
-    ratio1Button.setConnectedEdges(juce::Button::ConnectedEdgeFlags::ConnectedOnRight);
-    ratio2Button.setConnectedEdges(juce::Button::ConnectedEdgeFlags::ConnectedOnLeft + juce::Button::ConnectedEdgeFlags::ConnectedOnRight);
-    ratio3Button.setConnectedEdges(juce::Button::ConnectedEdgeFlags::ConnectedOnLeft + juce::Button::ConnectedEdgeFlags::ConnectedOnRight);
-    ratio4Button.setConnectedEdges(juce::Button::ConnectedEdgeFlags::ConnectedOnLeft);
-
-    ratio1Button.setClickingTogglesState(true);
-    ratio2Button.setClickingTogglesState(true);
-    ratio3Button.setClickingTogglesState(true);
-    ratio4Button.setClickingTogglesState(true);
+    //Ratio and Knee
+    for (auto* slider : { &ratioSlider, &kneeSlider, &upperThresholdSlider, &upperRatioSlider })
+    {
+        addAndMakeVisible(slider);
+        slider->setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
+        slider->setTextBoxStyle(juce::Slider::TextEntryBoxPosition::TextBoxRight, false, 55, 20);
+        slider->setColour(juce::Slider::ColourIds::textBoxOutlineColourId, juce::Colours::transparentBlack);
+        slider->setColour(juce::Slider::ColourIds::textBoxBackgroundColourId, juce::Colours::transparentBlack);
+    }
 
-    updateRatioState(&ratio1Button, ratioOneParam_ID);
+    ratioSliderAttachment.reset(new SliderAttachment(valueTreeState, ratioParam_ID, ratioSlider));
+    ratioSlider.setTextValueSuffix(":1");
 
     addAndMakeVisible(ratioLabel);
-    ratioLabel.setJustificationType(juce::Justification::centred);
+    ratioLabel.attachToComponent(&ratioSlider, true);
     ratioLabel.setFont(kCompLaf.smallFont);
 
+    kneeSlider.setTooltip("Width of the soft knee around the threshold, 0 is a hard knee.");
+    kneeSliderAttachment.reset(new SliderAttachment(valueTreeState, kneeParam_ID, kneeSlider));
+    kneeSlider.setTextValueSuffix(" dB");
+
+    addAndMakeVisible(kneeLabel);
+    kneeLabel.attachToComponent(&kneeSlider, true);
+    kneeLabel.setFont(kCompLaf.smallFont);
+
+    //Upper Stage
+    addAndMakeVisible(upperStageButton);
+    upperStageButton.setClickingTogglesState(true);
+    upperStageButton.setButtonText("2nd");
+    upperStageButton.setTooltip("Switches to a second ratio further above the threshold, for every band.");
+    upperStageButtonAttachment.reset(new ButtonAttachment(valueTreeState, upperStageParam_ID, upperStageButton));
+
+    upperThresholdSlider.setTooltip("Where the second ratio starts, in dB above the threshold.");
+    upperThresholdSliderAttachment.reset(new SliderAttachment(valueTreeState, upperThresholdParam_ID, upperThresholdSlider));
+    upperThresholdSlider.setTextValueSuffix(" dB");
+
+    upperRatioSlider.setTooltip("The second ratio.");
+    upperRatioSliderAttachment.reset(new SliderAttachment(valueTreeState, upperRatioParam_ID, upperRatioSlider));
+    upperRatioSlider.setTextValueSuffix(":1");
+
+    //Stereo Link
+    addAndMakeVisible(linkButton);
+    linkButton.setClickingTogglesState(true);
+    linkButton.setButtonText("Link");
+    linkButton.setTooltip("Shares one detector between all channels.");
+    linkButtonAttachment.reset(new ButtonAttachment(valueTreeState, linkParam_ID, linkButton));
+
+    addAndMakeVisible(linkAmountSlider);
+    linkAmountSlider.setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
+    linkAmountSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::NoTextBox, false, 0, 0);
+    linkAmountSlider.setTooltip("How far each channel's detector is pulled towards the loudest one while linked. Below 100% wide mixes keep more of their image.");
+    linkAmountSliderAttachment.reset(new SliderAttachment(valueTreeState, linkAmountParam_ID, linkAmountSlider));
+
+    addAndMakeVisible(stereoModeCombo);
+    stereoModeCombo.addItemList({ "L/R", "M/S" }, 1);
+    stereoModeCombo.setTooltip("M/S compresses mid and side instead of left and right. Stereo only.");
+    stereoModeComboAttachment.reset(new ComboBoxAttachment(valueTreeState, stereoModeParam_ID, stereoModeCombo));
+
+    //Meter
+    addAndMakeVisible(meterBallisticsCombo);
+    meterBallisticsCombo.addItemList(LevelMeter::LevelMeterGetter::getBallisticsNames(), 1);
+    meterBallisticsCombo.setTooltip("How the level meter moves. PPM types I/II, VU and K-System; K and VU mark their 0 on the scale.");
+    meterBallisticsComboAttachment.reset(new ComboBoxAttachment(valueTreeState, meterBallisticsParam_ID, meterBallisticsCombo));
+
+    //Lookahead
+    addAndMakeVisible(lookaheadSlider);
+    lookaheadSlider.setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
+    lookaheadSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::TextBoxRight, false, 55, 20);
+    lookaheadSlider.setColour(juce::Slider::ColourIds::textBoxOutlineColourId, juce::Colours::transparentBlack);
+    lookaheadSlider.setColour(juce::Slider::ColourIds::textBoxBackgroundColourId, juce::Colours::transparentBlack);
+    lookaheadSlider.setTooltip("Delays the audio so the detector sees transients before they arrive. Adds latency.");
+    lookaheadSliderAttachment.reset(new SliderAttachment(valueTreeState, lookaheadParam_ID, lookaheadSlider));
+    lookaheadSlider.setTextValueSuffix(" ms");
+
+    addAndMakeVisible(lookaheadLabel);
+    lookaheadLabel.attachToComponent(&lookaheadSlider, true);
+    lookaheadLabel.setFont(kCompLaf.smallFont);
+
+    //Detector
+    addAndMakeVisible(detectorCombo);
+    detectorCombo.addItemList({ "Peak", "RMS", "True Peak" }, 1);
+    detectorCombo.setTooltip("What the envelope follows: sample peaks, RMS over the window, or 4x true peak.");
+    detectorComboAttachment.reset(new ComboBoxAttachment(valueTreeState, detectorParam_ID, detectorCombo));
+
+    addAndMakeVisible(rmsWindowSlider);
+    rmsWindowSlider.setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
+    rmsWindowSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::TextBoxRight, false, 55, 20);
+    rmsWindowSlider.setColour(juce::Slider::ColourIds::textBoxOutlineColourId, juce::Colours::transparentBlack);
+    rmsWindowSlider.setColour(juce::Slider::ColourIds::textBoxBackgroundColourId, juce::Colours::transparentBlack);
+    rmsWindowSlider.setTooltip("RMS window, for the RMS detector.");
+    rmsWindowSliderAttachment.reset(new SliderAttachment(valueTreeState, rmsWindowParam_ID, rmsWindowSlider));
+    rmsWindowSlider.setTextValueSuffix(" ms");
+
+    addAndMakeVisible(topologyCombo);
+    topologyCombo.addItemList({ "Feed-forward", "Feedback", "Hybrid" }, 1);
+    topologyCombo.setTooltip("Feedback: the detector hears the compressor's own output, gentler and gluier. Hybrid blends the two. A sidechain is always feed-forward.");
+    topologyComboAttachment.reset(new ComboBoxAttachment(valueTreeState, topologyParam_ID, topologyCombo));
+
+    addAndMakeVisible(feedbackMixSlider);
+    feedbackMixSlider.setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
+    feedbackMixSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::NoTextBox, false, 0, 0);
+    feedbackMixSlider.setTooltip("Hybrid only: how much of the detector signal is fed back from the output.");
+    feedbackMixSliderAttachment.reset(new SliderAttachment(valueTreeState, feedbackMixParam_ID, feedbackMixSlider));
+
     
     //Attack
     addAndMakeVisible(attackSlider);
@@ -164,7 +266,6 @@ KcompAudioProcessorEditor::KcompAudioProcessorEditor(KcompAudioProcessor& p, juc
     attackSlider.setColour(juce::Slider::ColourIds::textBoxOutlineColourId, juce::Colours::transparentBlack);
     attackSlider.setColour(juce::Slider::ColourIds::textBoxBackgroundColourId, juce::Colours::transparentBlack);
     attackSliderAttachment.reset(new SliderAttachment(valueTreeState, attackParam_ID, attackSlider));
-    attackSlider.onValueChange = [this] { audioProcessor.setAttack(attackSlider.getValue()); };
 
     addAndMakeVisible(attackLabel);
     attackLabel.attachToComponent(&attackSlider, false);
@@ -178,21 +279,86 @@ KcompAudioProcessorEditor::KcompAudioProcessorEditor(KcompAudioProcessor& p, juc
     releaseSlider.setColour(juce::Slider::ColourIds::textBoxOutlineColourId, juce::Colours::transparentBlack);
     releaseSlider.setColour(juce::Slider::ColourIds::textBoxBackgroundColourId, juce::Colours::transparentBlack);
     releaseSliderAttachment.reset(new SliderAttachment(valueTreeState, releaseParam_ID, releaseSlider));
-    releaseSlider.onValueChange = [this] { audioProcessor.setRelease(releaseSlider.getValue()); };
 
     addAndMakeVisible(releaseLabel);
     releaseLabel.attachToComponent(&releaseSlider, false);
     releaseLabel.setJustificationType(juce::Justification::centred);
     releaseLabel.setFont(kCompLaf.mainFont);
 
+    //Auto timing
+    addAndMakeVisible(autoTimingButton);
+    autoTimingButton.setClickingTogglesState(true);
+    autoTimingButton.setButtonText("Auto");
+    autoTimingButton.setTooltip("Program-dependent attack and release. Attack and Release set how fast they are on steady material.");
+    autoTimingButtonAttachment.reset(new ButtonAttachment(valueTreeState, autoTimingParam_ID, autoTimingButton));
+
+    //Multiband, after the controls it re-attaches
+    addAndMakeVisible(bandsCombo);
+    bandsCombo.addItemList({ "1 Band", "2 Bands", "3 Bands", "4 Bands" }, 1);
+    bandsCombo.setTooltip("Splits the signal into bands that are compressed separately.");
+    bandsComboAttachment.reset(new ComboBoxAttachment(valueTreeState, bandsParam_ID, bandsCombo));
+    bandsCombo.onChange = [this] { updateBandControls(); };
+
+    addAndMakeVisible(editBandCombo);
+    editBandCombo.addItemList({ "Band 1", "Band 2", "Band 3", "Band 4" }, 1);
+    editBandCombo.setSelectedItemIndex(0, juce::dontSendNotification);
+    editBandCombo.setTooltip("The band the threshold, ratio, knee, attack and release controls edit.");
+    editBandCombo.onChange = [this] { selectBand(editBandCombo.getSelectedItemIndex()); };
+
+    for (int index = 0; index < KcompEngine<float>::maxBands - 1; ++index)
+    {
+        auto& slider = crossoverSliders[index];
+        addAndMakeVisible(slider);
+        slider.setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
+        slider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::TextBoxRight, false, 65, 20);
+        slider.setColour(juce::Slider::ColourIds::textBoxOutlineColourId, juce::Colours::transparentBlack);
+        slider.setColour(juce::Slider::ColourIds::textBoxBackgroundColourId, juce::Colours::transparentBlack);
+        crossoverSliderAttachments[index].reset(new SliderAttachment(valueTreeState, crossoverParam_IDs[index], slider));
+        slider.setTextValueSuffix(" Hz");
+    }
+
     //Tame
     addAndMakeVisible(tameButton);
     tameButton.setLookAndFeel(&kCompLaf);
     tameButton.setClickingTogglesState(true);
-    tameButton.setToggleState(true, juce::dontSendNotification);
     tameButton.setButtonText("Tame");
     tameButtonAttachment.reset(new ButtonAttachment(valueTreeState, filterParam_ID, tameButton));
-    tameButton.onClick = [this] { audioProcessor.setFilterBypass(tameButton.getToggleState()); };
+
+    addAndMakeVisible(tameFrequencySlider);
+    tameFrequencySlider.setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
+    tameFrequencySlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::TextBoxRight, false, 65, 20);
+    tameFrequencySlider.setColour(juce::Slider::ColourIds::textBoxOutlineColourId, juce::Colours::transparentBlack);
+    tameFrequencySlider.setColour(juce::Slider::ColourIds::textBoxBackgroundColourId, juce::Colours::transparentBlack);
+    tameFrequencySliderAttachment.reset(new SliderAttachment(valueTreeState, tameFrequencyParam_ID, tameFrequencySlider));
+    tameFrequencySlider.setTextValueSuffix(" Hz");
+
+    addAndMakeVisible(tameSlopeCombo);
+    tameSlopeCombo.addItemList({ "12 dB/oct", "24 dB/oct", "36 dB/oct", "48 dB/oct" }, 1);
+    tameSlopeComboAttachment.reset(new ComboBoxAttachment(valueTreeState, tameSlopeParam_ID, tameSlopeCombo));
+
+    addAndMakeVisible(tameTypeCombo);
+    tameTypeCombo.addItemList({ "Low-Pass", "High-Pass" }, 1);
+    tameTypeComboAttachment.reset(new ComboBoxAttachment(valueTreeState, tameTypeParam_ID, tameTypeCombo));
+
+    //Dynamic Tame, only cuts while the tamed band is over its threshold
+    addAndMakeVisible(tameDynamicButton);
+    tameDynamicButton.setClickingTogglesState(true);
+    tameDynamicButton.setButtonText("Dyn");
+    tameDynamicButton.setTooltip("Only cuts what Tame filters out while it's over the Tame threshold (de-esser / anti-boom).");
+    tameDynamicButtonAttachment.reset(new ButtonAttachment(valueTreeState, tameDynamicParam_ID, tameDynamicButton));
+
+    for (auto* slider : { &tameThresholdSlider, &tameRatioSlider })
+    {
+        addAndMakeVisible(slider);
+        slider->setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
+        slider->setTextBoxStyle(juce::Slider::TextEntryBoxPosition::TextBoxRight, false, 65, 20);
+        slider->setColour(juce::Slider::ColourIds::textBoxOutlineColourId, juce::Colours::transparentBlack);
+        slider->setColour(juce::Slider::ColourIds::textBoxBackgroundColourId, juce::Colours::transparentBlack);
+    }
+    tameThresholdSlider.setTooltip("Tame threshold, for Dyn mode.");
+    tameThresholdSliderAttachment.reset(new SliderAttachment(valueTreeState, tameThresholdParam_ID, tameThresholdSlider));
+    tameRatioSlider.setTooltip("Tame ratio, for Dyn mode.");
+    tameRatioSliderAttachment.reset(new SliderAttachment(valueTreeState, tameRatioParam_ID, tameRatioSlider));
     
 
     //DryWet
@@ -200,7 +366,6 @@ KcompAudioProcessorEditor::KcompAudioProcessorEditor(KcompAudioProcessor& p, juc
     dryWetSlider.setSliderStyle(juce::Slider::SliderStyle::RotaryHorizontalVerticalDrag);
     dryWetSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::NoTextBox, false, 45, 20);
     dryWetSliderAttachment.reset(new SliderAttachment(valueTreeState, dryWetParam_ID, dryWetSlider));
-    dryWetSlider.onValueChange = [this] { audioProcessor.setDryWetMix(dryWetSlider.getValue()); };
 
     addAndMakeVisible(dryLabel);
     dryLabel.setFont(kCompLaf.smallFont);
@@ -232,7 +397,6 @@ KcompAudioProcessorEditor::KcompAudioProcessorEditor(KcompAudioProcessor& p, juc
     outputGainSlider.setColour(juce::Slider::ColourIds::textBoxOutlineColourId, juce::Colours::transparentBlack);
     outputGainSlider.setColour(juce::Slider::ColourIds::textBoxBackgroundColourId, juce::Colours::transparentBlack);
     outputGainSliderAttachment.reset(new SliderAttachment(valueTreeState, outputGainParam_ID, outputGainSlider));
-    outputGainSlider.onValueChange = [this] { audioProcessor.setOutputGain(outputGainSlider.getValue()); };
 
     addAndMakeVisible(outputGainLabel);
     outputGainLabel.attachToComponent(&outputGainSlider, false);
@@ -241,6 +405,8 @@ KcompAudioProcessorEditor::KcompAudioProcessorEditor(KcompAudioProcessor& p, juc
 
 
 
+    updateBandControls();
+
     setResizable(true, true);
     setResizeLimits(560, 400, 1260, 900);
     setSize (840, 600);
@@ -256,6 +422,7 @@ KcompAudioProcessorEditor::~KcompAudioProcessorEditor()
         getChildComponent(child)->setLookAndFeel(nullptr);
     }
 
+    oversamplingCostThread.reset();
     logger.deleteAndZero();
 
     subMenus.clear();
@@ -332,8 +499,22 @@ void KcompAudioProcessorEditor::resized()
     titleRect.setBounds(0, 0, area.getWidth(), 100);
 
     debugModeButton.setBounds( 20, 40, 50, 25);
+    meterBallisticsCombo.setBounds(debugModeButton.getX(), debugModeButton.getBottom() + 5, 100, 20);
 
     presetsCombo.setBounds(titleRect.getRight() - 150, getY() + 40, 110, 25);
+    oversamplingCombo.setBounds(presetsCombo.getX() - 70, presetsCombo.getY(), 60, 25);
+    oversamplingFilterCombo.setBounds(oversamplingCombo.getX() - 120, presetsCombo.getY(), 110, 25);
+    bandsCombo.setBounds(oversamplingFilterCombo.getX() - 90, presetsCombo.getY(), 80, 25);
+    editBandCombo.setBounds(bandsCombo.getX() - 90, presetsCombo.getY(), 80, 25);
+    topologyCombo.setBounds(editBandCombo.getX() - 110, presetsCombo.getY(), 100, 25);
+    feedbackMixSlider.setBounds(topologyCombo.getX(), topologyCombo.getBottom() + 5, topologyCombo.getWidth(), 20);
+    stereoModeCombo.setBounds(topologyCombo.getX() - 70, presetsCombo.getY(), 60, 25);
+    linkAmountSlider.setBounds(stereoModeCombo.getX(), stereoModeCombo.getBottom() + 5, stereoModeCombo.getWidth(), 20);
+
+    keyLowPassSlider.setBounds(presetsCombo.getRight() - 160, presetsCombo.getBottom() + 5, 160, 20);
+    keyHighPassSlider.setBounds(keyLowPassSlider.getX() - 170, keyLowPassSlider.getY(), 160, 20);
+    keyListenButton.setBounds(keyHighPassSlider.getX() - 60, keyLowPassSlider.getY(), 50, 20);
+    sidechainButton.setBounds(keyListenButton.getX() - 45, keyLowPassSlider.getY(), 40, 20);
 
 
     controlsBackground = area.reduced(10);
@@ -363,77 +544,190 @@ void KcompAudioProcessorEditor::resized()
     //Left side of Center Section
     inputSlider.setBounds(controlsBackground.getX() + leftIndent, controlsBackground.getY() + space , ratioW + 15, ratioH + 30);
     //tameButton.setBounds(controlsBackground.getX() + leftIndent + 30, controlsBackground.getY() + (space * 4) - 40, ratioW - 40, ratioH / 2);
-    ratioLabel.setBounds(controlsBackground.getX() + leftIndent + 55, controlsBackground.getY() + (space * 3) - 20, (ratioW / 4) + 15, (ratioH / 4) + 5);
-    ratio1Button.setBounds(controlsBackground.getX() + leftIndent + 10 , controlsBackground.getY() + (space * 3) + 5 , ratioW/4, ratioH/4 + 5);
-    ratio2Button.setBounds(ratio1Button.getRight(), controlsBackground.getY() + (space * 3) + 5 , ratioW/4, (ratioH/4) + 5);
-    ratio3Button.setBounds(ratio2Button.getRight(), controlsBackground.getY() + (space * 3) + 5, ratioW/4, (ratioH / 4) + 5);
-    ratio4Button.setBounds(ratio3Button.getRight(), controlsBackground.getY() + (space * 3) + 5, ratioW/4, (ratioH / 4) + 5);
+    upperStageButton.setBounds(controlsBackground.getX() + leftIndent, controlsBackground.getY() + 5, 35, 20);
+    upperThresholdSlider.setBounds(upperStageButton.getRight() + 5, upperStageButton.getY(), ratioW, 20);
+    upperRatioSlider.setBounds(upperThresholdSlider.getX(), upperThresholdSlider.getBottom(), ratioW, 20);
+    ratioSlider.setBounds(controlsBackground.getX() + leftIndent + 10 + (ratioW / 4), controlsBackground.getY() + (space * 3) - 20, ratioW, 20);
+    kneeSlider.setBounds(ratioSlider.getX(), ratioSlider.getBottom() + 5, ratioW, 20);
+    linkButton.setBounds(ratioSlider.getX(), kneeSlider.getBottom() + 13, ratioW / 2, (ratioH / 4) + 5);
+    lookaheadSlider.setBounds(ratioSlider.getX(), linkButton.getBottom() + 5, ratioW, 20);
+    detectorCombo.setBounds(linkButton.getRight() + 5, linkButton.getY(), 85, linkButton.getHeight());
+    rmsWindowSlider.setBounds(lookaheadSlider.getX(), lookaheadSlider.getBottom(), ratioW, 20);
 
     
     attackSlider.setBounds(controlsBackground.getX() + 5, controlsBackground.getY() + (space * 5) - 45, ratioW - 45, ratioH);
     releaseSlider.setBounds(attackSlider.getRight() , controlsBackground.getY() + (space * 5) - 45, ratioW - 45, ratioH);
+    autoTimingButton.setBounds(releaseSlider.getRight(), releaseSlider.getY() + (ratioH / 2) - 10, 40, 20);
 
 
     //Right side of Center Section
     outputGainSlider.setBounds(makeUpGainSlider.getRight() + 50, controlsBackground.getY() + (controlsBackground.getHeight() / 6), (controlsBackground.getHeight()/5) + 20, (controlsBackground.getWidth() /6) + 20);
 
     tameButton.setBounds(makeUpGainSlider.getRight() + 55, outputGainSlider.getBottom() + 15, ratioW - 40, ratioH / 2);
+    tameTypeCombo.setBounds(tameButton.getRight() + 5, tameButton.getY(), 90, tameButton.getHeight() / 2);
+    tameSlopeCombo.setBounds(tameTypeCombo.getX(), tameTypeCombo.getBottom(), 90, tameButton.getHeight() / 2);
+    tameFrequencySlider.setBounds(tameButton.getX(), tameButton.getBottom() + 2, tameButton.getWidth() + 95, 20);
+    tameDynamicButton.setBounds(tameSlopeCombo.getRight() + 5, tameButton.getY(), 40, tameButton.getHeight() / 2);
+    tameThresholdSlider.setBounds(tameFrequencySlider.getX(), tameFrequencySlider.getBottom(), tameFrequencySlider.getWidth(), 20);
+    tameRatioSlider.setBounds(tameThresholdSlider.getX(), tameThresholdSlider.getBottom(), tameThresholdSlider.getWidth(), 20);
 
     dryWetSlider.setBounds(makeUpGainSlider.getRight() + 72, controlsBackground.getY() + (controlsBackground.getHeight() /1.5), (controlsBackground.getHeight() / 5) - 25 , (controlsBackground.getWidth() / 6) - 25);
+    //Crossovers, under the controls
+    auto crossoverWidth = controlsBackground.getWidth() / (KcompEngine<float>::maxBands - 1);
+    for (int index = 0; index < KcompEngine<float>::maxBands - 1; ++index)
+    {
+        crossoverSliders[index].setBounds(controlsBackground.getX() + index * crossoverWidth, controlsBackground.getBottom() + 10, crossoverWidth - 10, 25);
+    }
+
     dryLabel.setBounds(dryWetSlider.getX() -10 , dryWetSlider.getBottom() - 10, 40, 20);
     wetLabel.setBounds(dryWetSlider.getRight() - 25 , dryWetSlider.getBottom() - 10, 40, 20);
 
 
 }
 
-juce::Button& KcompAudioProcessorEditor::getActiveRatio()
+void KcompAudioProcessorEditor::selectBand(int band)
 {
-    //DBG("Called");
-    if (ratio1Button.getToggleState())
+    editBand = band;
+
+    //a slider can only have one attachment, so the old ones go first
+    thresholdSliderAttachment.reset();
+    attackSliderAttachment.reset();
+    releaseSliderAttachment.reset();
+    ratioSliderAttachment.reset();
+    kneeSliderAttachment.reset();
+
+    if (band == 0)
     {
-       // DBG(ratioOneParam_ID);
-        return ratio1Button;
+        thresholdSliderAttachment.reset(new SliderAttachment(valueTreeState, thresholdParam_ID, thresholdSlider));
+        attackSliderAttachment.reset(new SliderAttachment(valueTreeState, attackParam_ID, attackSlider));
+        releaseSliderAttachment.reset(new SliderAttachment(valueTreeState, releaseParam_ID, releaseSlider));
+        ratioSliderAttachment.reset(new SliderAttachment(valueTreeState, ratioParam_ID, ratioSlider));
+        kneeSliderAttachment.reset(new SliderAttachment(valueTreeState, kneeParam_ID, kneeSlider));
     }
-    else if (ratio2Button.getToggleState())
+    else
     {
-       // DBG(ratioTwoParam_ID);
-        return ratio2Button;
+        thresholdSliderAttachment.reset(new SliderAttachment(valueTreeState, bandThresholdParam_IDs[band - 1], thresholdSlider));
+        attackSliderAttachment.reset(new SliderAttachment(valueTreeState, bandAttackParam_IDs[band - 1], attackSlider));
+        releaseSliderAttachment.reset(new SliderAttachment(valueTreeState, bandReleaseParam_IDs[band - 1], releaseSlider));
+        ratioSliderAttachment.reset(new SliderAttachment(valueTreeState, bandRatioParam_IDs[band - 1], ratioSlider));
+        kneeSliderAttachment.reset(new SliderAttachment(valueTreeState, bandKneeParam_IDs[band - 1], kneeSlider));
     }
-    else if (ratio3Button.getToggleState())
+
+    logger->printDebug(juce::String(band + 1), "Editing Band");
+    repaint();
+}
+
+void KcompAudioProcessorEditor::updateBandControls()
+{
+    auto numBands = bandsCombo.getSelectedItemIndex() + 1;
+
+    for (int index = 0; index < KcompEngine<float>::maxBands - 1; ++index)
     {
-       // DBG(ratioThreeParam_ID);
-        return ratio3Button;
+        crossoverSliders[index].setEnabled(index < numBands - 1);
     }
-    else if (ratio4Button.getToggleState())
+
+    for (int band = 0; band < KcompEngine<float>::maxBands; ++band)
     {
-       // DBG(ratioFourParam_ID);
-        return ratio4Button;
+        editBandCombo.setItemEnabled(band + 1, band < numBands);
     }
-    else
+    editBandCombo.setEnabled(numBands > 1);
+
+    if (editBand >= numBands)
     {
-        logger->printDebug("ERROR", "RATIO ERROR");
+        editBandCombo.setSelectedItemIndex(0, juce::dontSendNotification);
+        selectBand(0);
     }
-
 }
 
-
-void KcompAudioProcessorEditor::updateRatioState(juce::Button* activeButton, juce::String ratioID)
+void KcompAudioProcessorEditor::showDebugger(bool shouldBeVisible)
 {
-    ratio1Button.setToggleState(false, juce::dontSendNotification);
-    ratio2Button.setToggleState(false, juce::dontSendNotification);
-    ratio3Button.setToggleState(false, juce::dontSendNotification);
-    ratio4Button.setToggleState(false, juce::dontSendNotification);
+    logger->setDebugMode(shouldBeVisible);
 
+    if (shouldBeVisible && oversamplingCostThread == nullptr)
+    {
+        const auto sampleRate = audioProcessor.getSampleRate() > 0.0 ? audioProcessor.getSampleRate() : 48000.0;
+        oversamplingCostThread = std::make_unique<OversamplingCostThread>(logger, sampleRate, juce::jmax(1, audioProcessor.getTotalNumInputChannels()));
+        oversamplingCostThread->startThread();
+    }
+}
 
-    activeButton->setToggleState(true,juce::dontSendNotification);
-    audioProcessor.setRatio(ratioID);
-    logger->printDebug(ratioID, "Ratio Selected");
-    repaint();
+KcompAudioProcessorEditor::OversamplingCostThread::OversamplingCostThread(SafePointer<Klog> logger, double sampleRate, int numChannels)
+    : juce::Thread("Kcomp Oversampling Cost"), logger(logger), sampleRate(sampleRate), numChannels(numChannels)
+{
 }
 
-void KcompAudioProcessorEditor::showDebugger(bool shouldBeVisible)
+KcompAudioProcessorEditor::OversamplingCostThread::~OversamplingCostThread()
 {
-    logger->setDebugMode(shouldBeVisible);
+    stopThread(2000);
+}
+
+void KcompAudioProcessorEditor::OversamplingCostThread::run()
+{
+    constexpr int blockSize = 512;
+    constexpr int numBlocks = 200;
+
+    juce::AudioBuffer<float> source(numChannels, blockSize), work(numChannels, blockSize);
+    juce::Random random;
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        for (int i = 0; i < blockSize; ++i)
+        {
+            source.setSample(channel, i, (random.nextFloat() * 2.0f - 1.0f) * 0.5f);
+        }
+    }
+
+    juce::String report;
+    report << numChannels << " channels, " << blockSize << " samples @ " << int(sampleRate) << " Hz";
+
+    const auto blockNanoseconds = 1.0e9 * blockSize / sampleRate;
+    for (int type = 0; type < 2; ++type)
+    {
+        for (int order = type == 0 ? 0 : 1; order <= KcompEngine<float>::maxOversamplingOrder; ++order)
+        {
+            if (threadShouldExit())
+            {
+                return;
+            }
+
+            KcompEngine<float>::Parameters params;
+            params.thresholdDb = -24.0f;
+            params.oversamplingOrder = order;
+            params.linearPhaseOversampling = type == 1;
+
+            KcompEngine<float> engine;
+            engine.setParameters(params);
+            engine.prepare({ sampleRate, juce::uint32(blockSize), juce::uint32(numChannels) });
+
+            //the first blocks settle the envelopes and warm the caches
+            auto start = juce::Time::getHighResolutionTicks();
+            for (int block = -numBlocks / 10; block < numBlocks; ++block)
+            {
+                if (block == 0)
+                {
+                    start = juce::Time::getHighResolutionTicks();
+                }
+
+                for (int channel = 0; channel < numChannels; ++channel)
+                {
+                    work.copyFrom(channel, 0, source, channel, 0, blockSize);
+                }
+                engine.process(work);
+            }
+
+            const auto nanoseconds = 1.0e9 * juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start) / numBlocks;
+            report << juce::NewLine::getDefault()
+                   << (1 << order) << "x" << (order == 0 ? juce::String() : (type == 0 ? juce::String(" IIR") : juce::String(" FIR"))) << ": "
+                   << juce::String(nanoseconds / 1000.0, 1) << " us/block, " << juce::String(100.0 * nanoseconds / blockNanoseconds, 2) << " % of real time";
+        }
+    }
+
+    juce::MessageManager::callAsync([logger = logger, report]
+    {
+        if (logger != nullptr)
+        {
+            logger->printDebug(report, "Oversampling Cost");
+        }
+    });
 }
 
 
@@ -24,6 +24,7 @@ public:
 
     typedef juce::AudioProcessorValueTreeState::SliderAttachment SliderAttachment;
     typedef juce::AudioProcessorValueTreeState::ButtonAttachment ButtonAttachment;
+    typedef juce::AudioProcessorValueTreeState::ComboBoxAttachment ComboBoxAttachment;
 
     KcompAudioProcessorEditor(KcompAudioProcessor&, juce::AudioProcessorValueTreeState& vts);
         
@@ -33,9 +34,8 @@ public:
     void paint (juce::Graphics&) override;
     void resized() override;
 
-    juce::Button& getActiveRatio();
-    
-    void updateRatioState(juce::Button*, juce::String);
+    void selectBand(int band);
+    void updateBandControls();
 
     void showDebugger(bool shouldBeVisible);
 
@@ -44,11 +44,6 @@ public:
     
 
 private:
-    
-    enum RadioButtonIds
-    {
-        ratioButtonGroup = 42
-    };
 
     enum PresetsMenuIds
     {
@@ -63,6 +58,25 @@ private:
     juce::TextButton debugModeButton;
     SafePointer<Klog> logger;
 
+    //Times the engine at each oversampling factor once, off the message thread, and prints it to the debug window
+    class OversamplingCostThread : public juce::Thread
+    {
+    public:
+
+        OversamplingCostThread(SafePointer<Klog> logger, double sampleRate, int numChannels);
+        ~OversamplingCostThread() override;
+
+        void run() override;
+
+    private:
+
+        SafePointer<Klog> logger;
+        double sampleRate;
+        int numChannels;
+    };
+
+    std::unique_ptr<OversamplingCostThread> oversamplingCostThread;
+
     juce::Rectangle<int> controlsBackground;
 
     juce::Image titleImage;
@@ -82,6 +96,29 @@ private:
     juce::Array<juce::StringArray*> subMenuStrings{&drumsSubMenuStrings, &bassSubMenuStrings, &vocalsSubMenuStrings, &guitarSubMenuStrings, &keysSubMenuStrings, &userSubMenuStrings};
     juce::OwnedArray<juce::PopupMenu> subMenus;
 
+    juce::ComboBox oversamplingCombo;
+    std::unique_ptr<ComboBoxAttachment> oversamplingComboAttachment;
+    juce::ComboBox oversamplingFilterCombo;
+    std::unique_ptr<ComboBoxAttachment> oversamplingFilterComboAttachment;
+
+    //Multiband, the threshold/ratio/knee/attack/release controls edit the band picked in editBandCombo
+    juce::ComboBox bandsCombo;
+    std::unique_ptr<ComboBoxAttachment> bandsComboAttachment;
+    juce::ComboBox editBandCombo;
+    int editBand{ 0 };
+    juce::Slider crossoverSliders[KcompEngine<float>::maxBands - 1];
+    std::unique_ptr<SliderAttachment> crossoverSliderAttachments[KcompEngine<float>::maxBands - 1];
+
+    //Sidechain key
+    juce::TextButton sidechainButton;
+    std::unique_ptr<ButtonAttachment> sidechainButtonAttachment;
+    juce::TextButton keyListenButton;
+    std::unique_ptr<ButtonAttachment> keyListenButtonAttachment;
+    juce::Slider keyHighPassSlider;
+    std::unique_ptr<SliderAttachment> keyHighPassSliderAttachment;
+    juce::Slider keyLowPassSlider;
+    std::unique_ptr<SliderAttachment> keyLowPassSliderAttachment;
+
     juce::Slider inputSlider; 
     juce::Label inputLabel{juce::String(), "Input"};
     std::unique_ptr<SliderAttachment> inputGainAttachment;
@@ -90,15 +127,21 @@ private:
     juce::Label makeUpGainLabel{juce::String(), "Make-Up Gain"};
     std::unique_ptr <SliderAttachment> makeUpGainAttachment;
 
-    juce::TextButton ratio1Button;
-    juce::TextButton ratio2Button;
-    juce::TextButton ratio3Button;
-    juce::TextButton ratio4Button;
+    juce::Slider ratioSlider;
     juce::Label ratioLabel{juce::String(), "Ratio"};
-    std::unique_ptr<ButtonAttachment> ratio1ButtonAttachment;
-    std::unique_ptr<ButtonAttachment> ratio2ButtonAttachment;
-    std::unique_ptr<ButtonAttachment> ratio3ButtonAttachment;
-    std::unique_ptr<ButtonAttachment> ratio4ButtonAttachment;
+    std::unique_ptr<SliderAttachment> ratioSliderAttachment;
+
+    juce::Slider kneeSlider;
+    juce::Label kneeLabel{ juce::String(), "Knee" };
+    std::unique_ptr<SliderAttachment> kneeSliderAttachment;
+
+    //Upper stage of the transfer curve, shared by every band
+    juce::TextButton upperStageButton;
+    std::unique_ptr<ButtonAttachment> upperStageButtonAttachment;
+    juce::Slider upperThresholdSlider;
+    std::unique_ptr<SliderAttachment> upperThresholdSliderAttachment;
+    juce::Slider upperRatioSlider;
+    std::unique_ptr<SliderAttachment> upperRatioSliderAttachment;
 
     
     juce::Slider thresholdSlider;
@@ -113,8 +156,47 @@ private:
     juce::Label releaseLabel{ juce::String(), "Release" };
     std::unique_ptr <SliderAttachment> releaseSliderAttachment;
 
+    juce::TextButton autoTimingButton;
+    std::unique_ptr<ButtonAttachment> autoTimingButtonAttachment;
+
     juce::TextButton tameButton;
     std::unique_ptr<ButtonAttachment> tameButtonAttachment;
+    juce::Slider tameFrequencySlider;
+    std::unique_ptr<SliderAttachment> tameFrequencySliderAttachment;
+    juce::ComboBox tameSlopeCombo;
+    std::unique_ptr<ComboBoxAttachment> tameSlopeComboAttachment;
+    juce::ComboBox tameTypeCombo;
+    std::unique_ptr<ComboBoxAttachment> tameTypeComboAttachment;
+    juce::TextButton tameDynamicButton;
+    std::unique_ptr<ButtonAttachment> tameDynamicButtonAttachment;
+    juce::Slider tameThresholdSlider;
+    std::unique_ptr<SliderAttachment> tameThresholdSliderAttachment;
+    juce::Slider tameRatioSlider;
+    std::unique_ptr<SliderAttachment> tameRatioSliderAttachment;
+
+    juce::TextButton linkButton;
+    std::unique_ptr<ButtonAttachment> linkButtonAttachment;
+    juce::Slider linkAmountSlider;
+    std::unique_ptr<SliderAttachment> linkAmountSliderAttachment;
+    juce::ComboBox stereoModeCombo;
+    std::unique_ptr<ComboBoxAttachment> stereoModeComboAttachment;
+
+    juce::ComboBox meterBallisticsCombo;
+    std::unique_ptr<ComboBoxAttachment> meterBallisticsComboAttachment;
+
+    //Detector
+    juce::ComboBox detectorCombo;
+    std::unique_ptr<ComboBoxAttachment> detectorComboAttachment;
+    juce::Slider rmsWindowSlider;
+    std::unique_ptr<SliderAttachment> rmsWindowSliderAttachment;
+    juce::ComboBox topologyCombo;
+    std::unique_ptr<ComboBoxAttachment> topologyComboAttachment;
+    juce::Slider feedbackMixSlider;
+    std::unique_ptr<SliderAttachment> feedbackMixSliderAttachment;
+
+    juce::Slider lookaheadSlider;
+    juce::Label lookaheadLabel{ juce::String(), "Look" };
+    std::unique_ptr<SliderAttachment> lookaheadSliderAttachment;
 
     juce::Slider dryWetSlider;
     juce::Label dryWetLabel{ juce::String(), "Dry/Wet Mix" };
@@ -9,6 +9,14 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
+//Lookahead and oversampling change the latency, so only the user sets them, never automation
+template <typename ParameterType>
+struct NonAutomatable : public ParameterType
+{
+    using ParameterType::ParameterType;
+    bool isAutomatable() const override { return false; }
+};
+
 juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout()
 {
     
@@ -29,7 +37,57 @@ juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout()
     juce::NormalisableRange<float> releaseRange = { 0.0f, 4000.0f, 0.01f };
     float defRelease = releaseRange.convertTo0to1(100.0f);
 
-    juce::StringArray ratioStrings{"1.5", "5.0", "10.0", "20.0" };
+    juce::NormalisableRange<float> lookaheadRange = { 0.0f, float(KcompEngine<float>::maxLookaheadMs), 1.0f };
+    float defLookahead = 0.0f;
+
+    juce::NormalisableRange<float> tameFrequencyRange = { 20.0f, 20000.0f, 1.0f };
+    tameFrequencyRange.setSkewForCentre(1000.0f);
+    float defTameFrequency = 10000.0f;
+
+    juce::StringArray tameSlopeStrings{ "12 dB/oct", "24 dB/oct", "36 dB/oct", "48 dB/oct" };
+    juce::StringArray tameTypeStrings{ "Low-Pass", "High-Pass" };
+
+    juce::NormalisableRange<float> tameRatioRange = { 1.0f, 20.0f, 0.1f };
+    tameRatioRange.setSkewForCentre(4.0f);
+    float defTameRatio = 4.0f;
+
+    juce::NormalisableRange<float> ratioRange = { 1.0f, 20.0f, 0.01f };
+    ratioRange.setSkewForCentre(4.0f);
+    float defRatio = 1.5f;
+    float defUpperRatio = 10.0f;
+
+    juce::NormalisableRange<float> kneeRange = { 0.0f, float(KcompTransferCurve<float>::maxKneeDb), 0.1f };
+    float defKnee = 0.0f;
+
+    juce::NormalisableRange<float> upperThresholdRange = { 0.0f, float(KcompTransferCurve<float>::maxUpperThresholdDb), 0.1f };
+    float defUpperThreshold = 12.0f;
+
+    juce::StringArray bandsStrings{ "1", "2", "3", "4" };
+
+    juce::NormalisableRange<float> crossoverRange = { 20.0f, 20000.0f, 1.0f };
+    crossoverRange.setSkewForCentre(1000.0f);
+    float defCrossovers[] = { 120.0f, 1000.0f, 6000.0f };
+
+    //the key filters are off at the ends of their ranges
+    juce::NormalisableRange<float> keyHighPassRange = { 20.0f, 2000.0f, 1.0f };
+    keyHighPassRange.setSkewForCentre(200.0f);
+    float defKeyHighPass = 20.0f;
+
+    juce::NormalisableRange<float> keyLowPassRange = { 1000.0f, 20000.0f, 1.0f };
+    keyLowPassRange.setSkewForCentre(5000.0f);
+    float defKeyLowPass = 20000.0f;
+
+    juce::StringArray detectorStrings{ "Peak", "RMS", "True Peak" };
+
+    juce::NormalisableRange<float> rmsWindowRange = { float(KcompDetector<float>::minWindowMs), float(KcompDetector<float>::maxWindowMs), 0.1f };
+    rmsWindowRange.setSkewForCentre(30.0f);
+    float defRmsWindow = 10.0f;
+
+    juce::StringArray topologyStrings{ "Feed-forward", "Feedback", "Hybrid" };
+    juce::StringArray stereoModeStrings{ "L/R", "M/S" };
+
+    juce::StringArray oversamplingStrings{ "1x", "2x", "4x", "8x" };
+    juce::StringArray oversamplingFilterStrings{ "Low Latency", "Linear Phase" };
 
     juce::NormalisableRange<float> outputGainRange = { juce::Decibels::decibelsToGain<float>(-60.0f), juce::Decibels::decibelsToGain<float>(4.0f), 0.0001f };
     float defOutputGain = 1.0f;
@@ -51,14 +109,66 @@ juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout()
 
     layout.add(std::make_unique<juce::AudioParameterFloat>(attackParam_ID, "Attack", attackRange, defAttack));
     layout.add(std::make_unique<juce::AudioParameterFloat>(releaseParam_ID, "Release", releaseRange, defRelease));
+    layout.add(std::make_unique<juce::AudioParameterBool>(autoTimingParam_ID, "Auto Timing", false));
+    layout.add(std::make_unique<NonAutomatable<juce::AudioParameterFloat>>(lookaheadParam_ID, "Lookahead", lookaheadRange, defLookahead, "ms"));
     layout.add(std::make_unique<juce::AudioParameterFloat>(dryWetParam_ID, "Dry Wet Mix", 0.0f, 1.0f, 1.0f));
     layout.add(std::make_unique<juce::AudioParameterBool>(filterParam_ID, "Filter", false));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(tameFrequencyParam_ID, "Tame Frequency", tameFrequencyRange, defTameFrequency, "Hz"));
+    layout.add(std::make_unique<juce::AudioParameterChoice>(tameSlopeParam_ID, "Tame Slope", tameSlopeStrings, 0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>(tameTypeParam_ID, "Tame Type", tameTypeStrings, 0));
+    layout.add(std::make_unique<juce::AudioParameterBool>(tameDynamicParam_ID, "Dynamic Tame", false));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(tameThresholdParam_ID, "Tame Threshold", thresholdRange, defThreshold, juce::String(), juce::AudioProcessorParameter::genericParameter,
+        [](float value, int) {return juce::String(juce::Decibels::gainToDecibels(value), 1) + " dB"; },
+        [](juce::String text) {return juce::Decibels::decibelsToGain(text.dropLastCharacters(3).getFloatValue()); }));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(tameRatioParam_ID, "Tame Ratio", tameRatioRange, defTameRatio));
 
   
-    layout.add(std::make_unique<juce::AudioParameterBool>(ratioOneParam_ID, "Ratio 1", true));
-    layout.add(std::make_unique<juce::AudioParameterBool>(ratioTwoParam_ID, "Ratio 2", false));
-    layout.add(std::make_unique<juce::AudioParameterBool>(ratioThreeParam_ID, "Ratio 3", false));
-    layout.add(std::make_unique<juce::AudioParameterBool>(ratioFourParam_ID, "Ratio 4", false));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(ratioParam_ID, "Ratio", ratioRange, defRatio, ":1"));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(kneeParam_ID, "Knee", kneeRange, defKnee, "dB"));
+
+    //a second, usually steeper, ratio from upperThreshold above the threshold
+    layout.add(std::make_unique<juce::AudioParameterBool>(upperStageParam_ID, "Upper Stage", false));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(upperThresholdParam_ID, "Upper Threshold", upperThresholdRange, defUpperThreshold, "dB"));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(upperRatioParam_ID, "Upper Ratio", ratioRange, defUpperRatio, ":1"));
+
+    layout.add(std::make_unique<juce::AudioParameterBool>(linkParam_ID, "Stereo Link", false));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(linkAmountParam_ID, "Link Amount", 0.0f, 100.0f, 100.0f, "%"));
+    layout.add(std::make_unique<juce::AudioParameterChoice>(stereoModeParam_ID, "Stereo Mode", stereoModeStrings, 0));
+
+    layout.add(std::make_unique<NonAutomatable<juce::AudioParameterChoice>>(oversamplingParam_ID, "Oversampling", oversamplingStrings, 0));
+    layout.add(std::make_unique<NonAutomatable<juce::AudioParameterChoice>>(oversamplingFilterParam_ID, "Oversampling Filter", oversamplingFilterStrings, 0));
+
+    layout.add(std::make_unique<juce::AudioParameterBool>(sidechainParam_ID, "External Sidechain", false));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(keyHighPassParam_ID, "Key High-Pass", keyHighPassRange, defKeyHighPass, "Hz"));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(keyLowPassParam_ID, "Key Low-Pass", keyLowPassRange, defKeyLowPass, "Hz"));
+    layout.add(std::make_unique<juce::AudioParameterBool>(keyListenParam_ID, "Key Listen", false));
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>(detectorParam_ID, "Detector", detectorStrings, 0));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(rmsWindowParam_ID, "RMS Window", rmsWindowRange, defRmsWindow, "ms"));
+    layout.add(std::make_unique<juce::AudioParameterChoice>(topologyParam_ID, "Topology", topologyStrings, 0));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(feedbackMixParam_ID, "Feedback Mix", 0.0f, 1.0f, 0.5f));
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>(bandsParam_ID, "Bands", bandsStrings, 0));
+
+    //only changes what the meters show
+    layout.add(std::make_unique<juce::AudioParameterChoice>(meterBallisticsParam_ID, "Meter Ballistics", LevelMeter::LevelMeterGetter::getBallisticsNames(), 0));
+
+    for (int index = 0; index < KcompEngine<float>::maxBands - 1; ++index)
+    {
+        const auto number = juce::String(index + 1);
+        const auto bandName = " Band " + juce::String(index + 2);
+
+        layout.add(std::make_unique<juce::AudioParameterFloat>(crossoverParam_IDs[index], "Crossover " + number, crossoverRange, defCrossovers[index], "Hz"));
+
+        layout.add(std::make_unique<juce::AudioParameterFloat>(bandThresholdParam_IDs[index], "Threshold" + bandName, thresholdRange, defThreshold, juce::String(), juce::AudioProcessorParameter::genericParameter,
+            [](float value, int) {return juce::String(juce::Decibels::gainToDecibels(value), 1) + " dB"; },
+            [](juce::String text) {return juce::Decibels::decibelsToGain(text.dropLastCharacters(3).getFloatValue()); }));
+
+        layout.add(std::make_unique<juce::AudioParameterFloat>(bandRatioParam_IDs[index], "Ratio" + bandName, ratioRange, defRatio, ":1"));
+        layout.add(std::make_unique<juce::AudioParameterFloat>(bandKneeParam_IDs[index], "Knee" + bandName, kneeRange, defKnee, "dB"));
+        layout.add(std::make_unique<juce::AudioParameterFloat>(bandAttackParam_IDs[index], "Attack" + bandName, attackRange, defAttack));
+        layout.add(std::make_unique<juce::AudioParameterFloat>(bandReleaseParam_IDs[index], "Release" + bandName, releaseRange, defRelease));
+    }
 
     layout.add(std::make_unique<juce::AudioParameterFloat>(outputGainParam_ID, "Output Gain", outputGainRange, defOutputGain, juce::String(), juce::AudioProcessorParameter::genericParameter,
         [](float value, int) {return juce::String(juce::Decibels::gainToDecibels(value), 1) + " dB"; },
@@ -73,26 +183,74 @@ KcompAudioProcessor::KcompAudioProcessor()
      : AudioProcessor   (BusesProperties()
                         .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
                         .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
+                        .withInput  ("Sidechain", juce::AudioChannelSet::stereo(), false)
                         ),
                         parameters(*this, nullptr, juce::Identifier("KcompParamTree"), createParameterLayout())
 {
     
-   /* inputGainParam = parameters.getRawParameterValue(inputGainParam_ID);
+    inputGainParam = parameters.getRawParameterValue(inputGainParam_ID);
     makeUpGainParam = parameters.getRawParameterValue(makeUpGainParam_ID);
-    ratioOneParam = parameters.getRawParameterValue(ratioOneParam_ID);
-    ratioTwoParam = parameters.getRawParameterValue(ratioTwoParam_ID);
-    ratioThreeParam = parameters.getRawParameterValue(ratioThreeParam_ID);
-    ratioFourParam = parameters.getRawParameterValue(ratioFourParam_ID);
+    ratioParam = parameters.getRawParameterValue(ratioParam_ID);
+    kneeParam = parameters.getRawParameterValue(kneeParam_ID);
+    upperStageParam = parameters.getRawParameterValue(upperStageParam_ID);
+    upperThresholdParam = parameters.getRawParameterValue(upperThresholdParam_ID);
+    upperRatioParam = parameters.getRawParameterValue(upperRatioParam_ID);
     thresholdParam = parameters.getRawParameterValue(thresholdParam_ID);
     attackParam = parameters.getRawParameterValue(attackParam_ID);
     releaseParam = parameters.getRawParameterValue(releaseParam_ID);
+    autoTimingParam = parameters.getRawParameterValue(autoTimingParam_ID);
     dryWetParam = parameters.getRawParameterValue(dryWetParam_ID);
-    filterParam = parameters.getRawParameterValue(filterParam_ID);*/
+    filterParam = parameters.getRawParameterValue(filterParam_ID);
+    tameFrequencyParam = parameters.getRawParameterValue(tameFrequencyParam_ID);
+    tameSlopeParam = parameters.getRawParameterValue(tameSlopeParam_ID);
+    tameTypeParam = parameters.getRawParameterValue(tameTypeParam_ID);
+    tameDynamicParam = parameters.getRawParameterValue(tameDynamicParam_ID);
+    tameThresholdParam = parameters.getRawParameterValue(tameThresholdParam_ID);
+    tameRatioParam = parameters.getRawParameterValue(tameRatioParam_ID);
+    outputGainParam = parameters.getRawParameterValue(outputGainParam_ID);
+    linkParam = parameters.getRawParameterValue(linkParam_ID);
+    linkAmountParam = parameters.getRawParameterValue(linkAmountParam_ID);
+    stereoModeParam = parameters.getRawParameterValue(stereoModeParam_ID);
+    meterBallisticsParam = parameters.getRawParameterValue(meterBallisticsParam_ID);
+    lookaheadParam = parameters.getRawParameterValue(lookaheadParam_ID);
+    oversamplingParam = parameters.getRawParameterValue(oversamplingParam_ID);
+    oversamplingFilterParam = parameters.getRawParameterValue(oversamplingFilterParam_ID);
+    bandsParam = parameters.getRawParameterValue(bandsParam_ID);
+    sidechainParam = parameters.getRawParameterValue(sidechainParam_ID);
+    keyHighPassParam = parameters.getRawParameterValue(keyHighPassParam_ID);
+    keyLowPassParam = parameters.getRawParameterValue(keyLowPassParam_ID);
+    keyListenParam = parameters.getRawParameterValue(keyListenParam_ID);
+    detectorParam = parameters.getRawParameterValue(detectorParam_ID);
+    rmsWindowParam = parameters.getRawParameterValue(rmsWindowParam_ID);
+    topologyParam = parameters.getRawParameterValue(topologyParam_ID);
+    feedbackMixParam = parameters.getRawParameterValue(feedbackMixParam_ID);
+
+    for (int index = 0; index < KcompEngine<float>::maxBands - 1; ++index)
+    {
+        crossoverParams[index] = parameters.getRawParameterValue(crossoverParam_IDs[index]);
+        bandThresholdParams[index] = parameters.getRawParameterValue(bandThresholdParam_IDs[index]);
+        bandRatioParams[index] = parameters.getRawParameterValue(bandRatioParam_IDs[index]);
+        bandKneeParams[index] = parameters.getRawParameterValue(bandKneeParam_IDs[index]);
+        bandAttackParams[index] = parameters.getRawParameterValue(bandAttackParam_IDs[index]);
+        bandReleaseParams[index] = parameters.getRawParameterValue(bandReleaseParam_IDs[index]);
+    }
+
+    //both engines report the gain they apply, the loudness and the true peak of the output to the meter
+    engine.setGainFifo(&gainReductionFifo);
+    doubleEngine.setGainFifo(&gainReductionFifo);
+    levelMeterGetter.setGainFifo(&gainReductionFifo);
+    engine.setLoudnessMeters(levelMeterGetter.getInputLoudnessMeter(), levelMeterGetter.getOutputLoudnessMeter());
+    doubleEngine.setLoudnessMeters(levelMeterGetter.getInputLoudnessMeter(), levelMeterGetter.getOutputLoudnessMeter());
+    engine.setTruePeakMeter(true);
+    doubleEngine.setTruePeakMeter(true);
 
+    updateTransferCurves();
+    startTimerHz(curveUpdateHz);
 }
 
 KcompAudioProcessor::~KcompAudioProcessor()
 {
+    stopTimer();
 }
 
 //==============================================================================
@@ -130,7 +288,7 @@ bool KcompAudioProcessor::isMidiEffect() const
 
 double KcompAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    return tailSeconds.load();
 }
 
 int KcompAudioProcessor::getNumPrograms()
@@ -165,51 +323,32 @@ void KcompAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
     spec.numChannels = getTotalNumOutputChannels();
     spec.maximumBlockSize = samplesPerBlock;
 
-    /*auto& inputGain = kComp.get<inputGain_ID>();*/
-    inputGain.setGainLinear(*parameters.getRawParameterValue(inputGainParam_ID));
-
-    auto& filter = kComp.get<filter_ID>();
-    filter.state = juce::dsp::IIR::Coefficients<float>::makeLowPass(sampleRate, filterFreq);
-
-    auto& comp = kComp.get<compressor_ID>();
-    comp.setAttack(*parameters.getRawParameterValue(attackParam_ID));
-    comp.setRelease(*parameters.getRawParameterValue(releaseParam_ID));
-    comp.setThreshold(*parameters.getRawParameterValue(thresholdParam_ID));
+    //prepare() starts on the newest curves without fading in
+    updateTransferCurves();
 
-    float ratioOneVal = *parameters.getRawParameterValue(ratioOneParam_ID);
-    float ratioTwoVal = *parameters.getRawParameterValue(ratioTwoParam_ID);
-    float ratioThreeVal = *parameters.getRawParameterValue(ratioThreeParam_ID);
-    float ratioFourVal = *parameters.getRawParameterValue(ratioFourParam_ID);    
-
-    if (ratioOneVal > 0.5f)
-    {
-        comp.setRatio(ratioOne);
-    }
-    else if (ratioTwoVal > 0.5f)
-    {
-        comp.setRatio(ratioTwo);
-    }
-    else if (ratioThreeVal > 0.5f)
+    //the host picks the precision before calling this, only that engine needs its buffers
+    if (isUsingDoublePrecision())
     {
-        comp.setRatio(ratioThree);
+        prepareEngine(doubleEngine, spec);
     }
-    else if (ratioFourVal > 0.5f)
+    else
     {
-        comp.setRatio(ratioFour);
+        prepareEngine(engine, spec);
     }
-
-    auto& makeUpGain = kComp.get<makeUpGain_ID>();
-    makeUpGain.setGainLinear(*parameters.getRawParameterValue(makeUpGainParam_ID));
-
-    outputGain.setGainLinear(*parameters.getRawParameterValue(outputGainParam_ID));
-
-    kComp.prepare(spec);
-    dryWet.prepare(spec);
-    dryWet.setMixingRule(juce::dsp::DryWetMixingRule::squareRoot3dB);
+    updateLatency();
 
     
-    levelMeterGetter.resize(spec.numChannels, sampleRate / samplesPerBlock);
+    levelMeterGetter.prepare(int(spec.numChannels), sampleRate);
+
+}
 
+template <typename SampleType>
+void KcompAudioProcessor::prepareEngine(KcompEngine<SampleType>& engineToPrepare, const juce::dsp::ProcessSpec& spec)
+{
+    //start the ramps on the current values instead of gliding in from the defaults
+    engineToPrepare.setChannelLayout(getBus(false, 0)->getCurrentLayout());
+    engineToPrepare.setParameters(getParameterSnapshot<SampleType>());
+    engineToPrepare.prepare(spec);
 }
 
 void KcompAudioProcessor::releaseResources()
@@ -225,10 +364,10 @@ bool KcompAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) co
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Anything from mono up to 7.1.4 or 3rd order ambisonics, the engine links
+    // the detector per channel group (see KcompEngine::setChannelLayout).
+    const auto main = layouts.getMainOutputChannelSet();
+    if (main.isDisabled() || main.size() > KcompEngine<float>::maxChannels)
         return false;
 
     // This checks if the input layout matches the output layout
@@ -237,6 +376,14 @@ bool KcompAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) co
         return false;
    #endif
 
+    // The sidechain is optional. Mono feeds every channel, wider keys can't have
+    // more channels than the main bus, extra main channels read the last key channel.
+    const auto sidechain = layouts.getChannelSet(true, 1);
+    if (! sidechain.isDisabled()
+     && sidechain != juce::AudioChannelSet::mono()
+     && sidechain.size() > main.size())
+        return false;
+
     return true;
   #endif
 }
@@ -244,146 +391,179 @@ bool KcompAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) co
 
 void KcompAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
-    juce::ScopedNoDenormals noDenormals;
-    auto totalNumInputChannels  = getTotalNumInputChannels();
-    auto totalNumOutputChannels = getTotalNumOutputChannels();
-
-    if (buffer.getNumSamples() < 1)
-    {
-        for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
-            buffer.clear(i, 0, buffer.getNumSamples());
-    }
-    
-    juce::dsp::AudioBlock<float> block(buffer);
-    dryWet.pushDrySamples(block);
-    juce::dsp::ProcessContextReplacing<float> context(block);
-
-
-    /*preRMSL = buffer.getRMSLevel(0, buffer.getSample(0, 0), buffer.getNumSamples());
-    preRMSR = buffer.getRMSLevel(1, buffer.getSample(1, 0), buffer.getNumSamples());*/
-
-    inputGain.process(context);
-
-    levelMeterGetter.loadMeterData(buffer);
-
-    kComp.process(context);
-    
-    levelMeterGetter.setReductionLevel(buffer.getMagnitude(0, 0, buffer.getNumSamples()), 0);
-    levelMeterGetter.setReductionLevel(buffer.getMagnitude(1, 0, buffer.getNumSamples()), 1);
-    //levelMeterGetter.setReductionLevel(buffer.getRMSLevel(0, 0, buffer.getNumSamples()), 0);
-    //levelMeterGetter.setReductionLevel(buffer.getRMSLevel(1, 0, buffer.getNumSamples()), 1);
-
-   /* postRMSL = buffer.getRMSLevel(0, buffer.getSample(0, 0), buffer.getNumSamples());
-    postRMSR = buffer.getRMSLevel(1, buffer.getSample(1, 0), buffer.getNumSamples());*/
-
-    dryWet.mixWetSamples(context.getOutputBlock());
-    dryWet.setWetMixProportion(dryWetMix);
-    
-    outputGain.process(context);
-
+    processEngine(buffer, engine, false);
 }
 
-
-void KcompAudioProcessor::setFilterBypass(bool isFilterBypassed)
+void KcompAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
 {
-    kComp.setBypassed<filter_ID>(isFilterBypassed);
+    processEngine(buffer, doubleEngine, false);
 }
 
-void KcompAudioProcessor::setInputGain(double newInputGain)
+//The engine crossfades to the delayed dry signal, then only runs its dry delay
+void KcompAudioProcessor::processBlockBypassed (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
-    /*auto& inputGain = kComp.get<inputGain_ID>();*/
-    inputGain.setGainLinear((float)newInputGain);
+    processEngine(buffer, engine, true);
 }
 
-
-void KcompAudioProcessor::setMakeUpGain(double newGain)
+void KcompAudioProcessor::processBlockBypassed (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
 {
-    auto& makeUp = kComp.get<makeUpGain_ID>();
-    makeUp.setGainLinear((float)newGain);
+    processEngine(buffer, doubleEngine, true);
 }
 
-void KcompAudioProcessor::setRatio(juce::String newRatioID)
+bool KcompAudioProcessor::supportsDoublePrecisionProcessing() const
 {
-    auto& ratio = kComp.get<compressor_ID>();
-    ratio.setRatio(getRatioValue(newRatioID));
-    DBG(newRatioID);
+    return true;
 }
 
-
-float KcompAudioProcessor::getRatioValue(juce::String ratioID)
+template <typename SampleType>
+void KcompAudioProcessor::processEngine(juce::AudioBuffer<SampleType>& buffer, KcompEngine<SampleType>& engineToRun, bool bypassed)
 {
-    if (ratioID == ratioOneParam_ID)
+    juce::ScopedNoDenormals noDenormals;
+    auto totalNumInputChannels  = getTotalNumInputChannels();
+    auto totalNumOutputChannels = getTotalNumOutputChannels();
+
+    if (buffer.getNumSamples() < 1)
     {
-        return ratioOne;
+        for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
+            buffer.clear(i, 0, buffer.getNumSamples());
     }
-    else if (ratioID == ratioTwoParam_ID)
+
+    //the buffer holds the sidechain channels after the main ones
+    auto mainBuffer = getBusBuffer(buffer, true, 0);
+    auto sidechainBuffer = getBusBuffer(buffer, true, 1);
+
+    //the detector reads the sidechain in place
+    juce::dsp::AudioBlock<const SampleType> key;
+    if (sidechainParam->load() > 0.5f && sidechainBuffer.getNumChannels() > 0)
     {
-        return ratioTwo;
+        key = juce::dsp::AudioBlock<const SampleType>(sidechainBuffer);
     }
-    else if (ratioID == ratioThreeParam_ID)
+
+    //offline there's no message thread to keep up with the render, so the curves are built here
+    if (isNonRealtime())
     {
-        return ratioThree;
+        updateTransferCurves();
     }
-    else if (ratioID == ratioFourParam_ID)
+
+    //the snapshot is where automation is by the end of the buffer, the engine glides there sub-block by sub-block
+    auto snapshot = getParameterSnapshot<SampleType>();
+    snapshot.bypassed = bypassed;
+    engineToRun.scheduleParameters(snapshot);
+    engineToRun.process(mainBuffer, key);
+    tailSeconds = engineToRun.getTailSeconds();
+
+    const auto numChannels = mainBuffer.getNumChannels();
+    levelMeterGetter.setBallistics(juce::roundToInt(meterBallisticsParam->load()));
+    levelMeterGetter.loadLevelStats(engineToRun.getInputLevels(), engineToRun.getOutputLevels(), numChannels);
+    levelMeterGetter.loadMeterData(engineToRun.getInputLevels(), numChannels, mainBuffer.getNumSamples(), engineToRun.getOutputTruePeaks());
+    levelMeterGetter.setBandReductions(engineToRun.getBandGains(), engineToRun.getNumBands());
+}
+
+template <typename SampleType>
+typename KcompEngine<SampleType>::Parameters KcompAudioProcessor::getParameterSnapshot() const
+{
+    typename KcompEngine<SampleType>::Parameters snapshot;
+    snapshot.inputGain = inputGainParam->load();
+    snapshot.makeUpGain = makeUpGainParam->load();
+    snapshot.outputGain = outputGainParam->load();
+
+    //the threshold parameter is stored as a linear gain, the compressor wants dB
+    snapshot.thresholdDb = juce::Decibels::gainToDecibels<SampleType>(thresholdParam->load());
+    snapshot.attackMs = attackParam->load();
+    snapshot.releaseMs = releaseParam->load();
+    snapshot.autoTiming = autoTimingParam->load() > 0.5f;
+    snapshot.lookaheadMs = lookaheadParam->load();
+    snapshot.dryWetMix = dryWetParam->load();
+
+    snapshot.tameEnabled = filterParam->load() > 0.5f;
+    snapshot.tameFrequencyHz = tameFrequencyParam->load();
+    snapshot.tameSlope = juce::roundToInt(tameSlopeParam->load()) + 1;
+    snapshot.tameHighPass = tameTypeParam->load() > 0.5f;
+    snapshot.tameDynamic = tameDynamicParam->load() > 0.5f;
+    snapshot.tameThresholdDb = juce::Decibels::gainToDecibels<SampleType>(tameThresholdParam->load());
+    snapshot.tameRatio = tameRatioParam->load();
+    snapshot.linked = linkParam->load() > 0.5f;
+    snapshot.linkAmount = linkAmountParam->load() * 0.01f;
+
+    //choice parameters hold their index
+    snapshot.oversamplingOrder = juce::roundToInt(oversamplingParam->load());
+    snapshot.linearPhaseOversampling = oversamplingFilterParam->load() > 0.5f;
+    snapshot.stereoMode = juce::roundToInt(stereoModeParam->load());
+
+    snapshot.keyHighPassHz = keyHighPassParam->load() > 20.5f ? SampleType(keyHighPassParam->load()) : SampleType();
+    snapshot.keyLowPassHz = keyLowPassParam->load() < 19999.5f ? SampleType(keyLowPassParam->load()) : SampleType();
+    snapshot.keyListen = keyListenParam->load() > 0.5f;
+
+    snapshot.detectorMode = juce::roundToInt(detectorParam->load());
+    snapshot.rmsWindowMs = rmsWindowParam->load();
+    snapshot.topology = juce::roundToInt(topologyParam->load());
+    snapshot.feedbackMix = feedbackMixParam->load();
+
+    //band 1 follows the main controls, the others have their own. Ratio and knee go through the transfer curves.
+    snapshot.numBands = juce::roundToInt(bandsParam->load()) + 1;
+    snapshot.bands[0] = { snapshot.thresholdDb, snapshot.attackMs, snapshot.releaseMs };
+    for (int index = 0; index < KcompEngine<float>::maxBands - 1; ++index)
     {
-        return ratioFour;
-    }
-    else return 1.0f;
-}
+        snapshot.crossoverFrequencies[index] = crossoverParams[index]->load();
 
-void KcompAudioProcessor::setThreshold(double newThreshold)
-{
-    auto& comp = kComp.get<compressor_ID>();
-    comp.setThreshold(juce::Decibels::gainToDecibels<float>(newThreshold));
-    DBG("Threshold: " + juce::String(newThreshold));
+        auto& band = snapshot.bands[index + 1];
+        band.thresholdDb = juce::Decibels::gainToDecibels<SampleType>(bandThresholdParams[index]->load());
+        band.attackMs = bandAttackParams[index]->load();
+        band.releaseMs = bandReleaseParams[index]->load();
+    }
+    return snapshot;
 }
 
-void KcompAudioProcessor::setAttack(double newAttack)
+//Lookahead plus the oversampling filters, the engine delays the dry path by the same amount.
+//Only called from prepareToPlay() and the timer, setLatencySamples() tells the host through updateHostDisplay().
+void KcompAudioProcessor::updateLatency()
 {
-    auto& comp = kComp.get<compressor_ID>();
-    comp.setAttack(newAttack);
-    DBG("Attack: " + juce::String(newAttack));
+    const auto latency = isUsingDoublePrecision() ? doubleEngine.getLatencySamples(getParameterSnapshot<double>())
+                                                  : engine.getLatencySamples(getParameterSnapshot<float>());
+    if (latency != getLatencySamples())
+    {
+        setLatencySamples(latency);
+    }
 }
 
-void KcompAudioProcessor::setRelease(double newRelease)
+void KcompAudioProcessor::timerCallback()
 {
-    auto& comp = kComp.get<compressor_ID>();
-    comp.setRelease(newRelease);
-    DBG("Release: " + juce::String(newRelease));
+    updateTransferCurves();
+    updateLatency();
 }
 
-
-void KcompAudioProcessor::setDryWetMix(double newMix)
+//Rebuilds the tables of the curves whose controls moved, the engines crossfade to them at their next block.
+//Both engines get them, the host can switch precision without a prepareToPlay in between.
+void KcompAudioProcessor::updateTransferCurves()
 {
-    if (newMix > 1)
+    const juce::SpinLock::ScopedTryLockType lock(curveLock);
+    if (! lock.isLocked())
     {
-        dryWetMix = 1.0f;
+        return;
     }
-    else
+
+    for (int band = 0; band < KcompEngine<float>::maxBands; ++band)
     {
-        dryWetMix = newMix;
+        const auto settings = getCurveSettings(band);
+        if (settings != publishedCurves[band])
+        {
+            engine.setTransferCurve(band, settings);
+            doubleEngine.setTransferCurve(band, { settings.ratio, settings.kneeDb, settings.upperStage, settings.upperThresholdDb, settings.upperRatio });
+            publishedCurves[band] = settings;
+        }
     }
-
-    DBG(juce::String(dryWetMix));
-    
-}
-
-void KcompAudioProcessor::setOutputGain(double newOutGain)
-{
-    outputGain.setGainLinear((float)newOutGain);
-}
-
-
-
-
-float KcompAudioProcessor::getPreRMSLevel()
-{
-    return (preRMSL + preRMSR) / 2;
 }
 
-float KcompAudioProcessor::getPostRMSLevel()
+//Band 1 follows the main controls, the upper stage is shared by every band
+KcompTransferCurve<float>::Settings KcompAudioProcessor::getCurveSettings(int band) const
 {
-    return (postRMSL + postRMSR) / 2;
+    KcompTransferCurve<float>::Settings settings;
+    settings.ratio = band == 0 ? ratioParam->load() : bandRatioParams[band - 1]->load();
+    settings.kneeDb = band == 0 ? kneeParam->load() : bandKneeParams[band - 1]->load();
+    settings.upperStage = upperStageParam->load() > 0.5f;
+    settings.upperThresholdDb = upperThresholdParam->load();
+    settings.upperRatio = upperRatioParam->load();
+    return settings;
 }
 
 LevelMeter::LevelMeterGetter* KcompAudioProcessor::getLevelMeterGetter()
@@ -391,11 +571,6 @@ LevelMeter::LevelMeterGetter* KcompAudioProcessor::getLevelMeterGetter()
     return &levelMeterGetter;
 }
 
-juce::NormalisableRange<float>* KcompAudioProcessor::getMinMax()
-{
-    return &minMax;
-}
-
 //==============================================================================
 bool KcompAudioProcessor::hasEditor() const
 {
@@ -416,6 +591,44 @@ void KcompAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
     
 }
 
+//Sessions from before the continuous ratio have four ratio buttons
+static void convertLegacyRatios(juce::XmlElement& state)
+{
+    const juce::String buttonIDs[] = { "ratioOne", "ratioTwo", "ratioThree", "ratioFour" };
+    const float legacyRatios[] = { 1.5f, 5.0f, 10.0f, 20.0f };
+
+    if (state.getChildByAttribute("id", buttonIDs[0]) == nullptr)
+    {
+        return;
+    }
+
+    auto setValue = [&state](const juce::String& paramID, float value)
+    {
+        auto* param = state.getChildByAttribute("id", paramID);
+        if (param == nullptr)
+        {
+            param = state.createNewChildElement("PARAM");
+            param->setAttribute("id", paramID);
+        }
+        param->setAttribute("value", value);
+    };
+
+    //the first button that's on wins, like it did on the audio thread
+    auto ratio = legacyRatios[0];
+    for (int index = 3; index >= 0; --index)
+    {
+        if (auto* button = state.getChildByAttribute("id", buttonIDs[index]))
+        {
+            if (button->getDoubleAttribute("value") > 0.5)
+            {
+                ratio = legacyRatios[index];
+            }
+            state.removeChildElement(button, true);
+        }
+    }
+    setValue(ratioParam_ID, ratio);
+}
+
 void KcompAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
     std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
@@ -424,6 +637,7 @@ void KcompAudioProcessor::setStateInformation (const void* data, int sizeInBytes
     {
         if (xmlState->hasTagName(parameters.state.getType())) 
         {
+            convertLegacyRatios(*xmlState);
             parameters.replaceState(juce::ValueTree::fromXml(*xmlState));
         }
     } 
@@ -10,6 +10,8 @@
 
 #include <JuceHeader.h>
 #include "LevelMeter.h"
+#include "KcompEngine.h"
+
 //==============================================================================
 /**
 */
@@ -18,28 +20,52 @@ const juce::String makeUpGainParam_ID = "makeUpGain";
 const juce::String thresholdParam_ID = "threshold";
 const juce::String attackParam_ID = "attack";
 const juce::String releaseParam_ID = "release";
+const juce::String autoTimingParam_ID = "autoTiming";
 const juce::String filterParam_ID = "filter";
+const juce::String tameFrequencyParam_ID = "tameFrequency";
+const juce::String tameSlopeParam_ID = "tameSlope";
+const juce::String tameTypeParam_ID = "tameType";
+const juce::String tameDynamicParam_ID = "tameDynamic";
+const juce::String tameThresholdParam_ID = "tameThreshold";
+const juce::String tameRatioParam_ID = "tameRatio";
 const juce::String dryWetParam_ID = "dryWet";
-const juce::String ratioOneParam_ID = "ratioOne";
-const juce::String ratioTwoParam_ID = "ratioTwo";
-const juce::String ratioThreeParam_ID = "ratioThree";
-const juce::String ratioFourParam_ID = "ratioFour";
+const juce::String ratioParam_ID = "ratio";
+const juce::String kneeParam_ID = "knee";
+const juce::String upperStageParam_ID = "upperStage";
+const juce::String upperThresholdParam_ID = "upperThreshold";
+const juce::String upperRatioParam_ID = "upperRatio";
 const juce::String outputGainParam_ID = "outputGain";
-
-
-class KcompAudioProcessor  : public juce::AudioProcessor
+const juce::String linkParam_ID = "link";
+const juce::String linkAmountParam_ID = "linkAmount";
+const juce::String stereoModeParam_ID = "stereoMode";
+const juce::String lookaheadParam_ID = "lookahead";
+const juce::String oversamplingParam_ID = "oversampling";
+const juce::String oversamplingFilterParam_ID = "oversamplingFilter";
+const juce::String bandsParam_ID = "bands";
+const juce::String sidechainParam_ID = "sidechain";
+const juce::String keyHighPassParam_ID = "keyHighPass";
+const juce::String keyLowPassParam_ID = "keyLowPass";
+const juce::String keyListenParam_ID = "keyListen";
+const juce::String detectorParam_ID = "detector";
+const juce::String rmsWindowParam_ID = "rmsWindow";
+const juce::String meterBallisticsParam_ID = "meterBallistics";
+const juce::String topologyParam_ID = "topology";
+const juce::String feedbackMixParam_ID = "feedbackMix";
+
+//multiband: one crossover between each pair of bands, and the settings of bands 2 to 4 (band 1 uses the main controls)
+const juce::String crossoverParam_IDs[] = { "crossoverOne", "crossoverTwo", "crossoverThree" };
+const juce::String bandThresholdParam_IDs[] = { "thresholdBandTwo", "thresholdBandThree", "thresholdBandFour" };
+const juce::String bandRatioParam_IDs[] = { "ratioBandTwo", "ratioBandThree", "ratioBandFour" };
+const juce::String bandKneeParam_IDs[] = { "kneeBandTwo", "kneeBandThree", "kneeBandFour" };
+const juce::String bandAttackParam_IDs[] = { "attackBandTwo", "attackBandThree", "attackBandFour" };
+const juce::String bandReleaseParam_IDs[] = { "releaseBandTwo", "releaseBandThree", "releaseBandFour" };
+
+
+class KcompAudioProcessor  : public juce::AudioProcessor,
+                             private juce::Timer
 {
 public:
 
-    enum ChainIDs
-    {
-        /*inputGain_ID,*/
-        filter_ID,
-        compressor_ID,
-        makeUpGain_ID,
-       /* wetDry_ID*/
-    };
-
     //==============================================================================
     KcompAudioProcessor();
     ~KcompAudioProcessor() override;
@@ -53,28 +79,13 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
-
-
-    void setFilterBypass(bool);
-    void setInputGain(double);
-    void setMakeUpGain(double);
-    void setRatio(juce::String);
-    float getRatioValue(juce::String);
-    
-    void setThreshold(double);
-    void setAttack(double);
-    void setRelease(double);
-
-    void setDryWetMix(double);
-    
-    void setOutputGain(double);
-
-    float getPreRMSLevel();
-    float getPostRMSLevel();
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    void processBlockBypassed (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlockBypassed (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
 
     LevelMeter::LevelMeterGetter* getLevelMeterGetter();
-    
-    juce::NormalisableRange<float>* getMinMax();
+
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override;
@@ -100,39 +111,81 @@ public:
     juce::String getStateForDebug();
 
 private:
+
+    //float and double hosts run the same code, each with its own engine
+    template <typename SampleType>
+    void prepareEngine(KcompEngine<SampleType>& engineToPrepare, const juce::dsp::ProcessSpec& spec);
+    template <typename SampleType>
+    void processEngine(juce::AudioBuffer<SampleType>& buffer, KcompEngine<SampleType>& engineToRun, bool bypassed);
+    template <typename SampleType>
+    typename KcompEngine<SampleType>::Parameters getParameterSnapshot() const;
+    void updateLatency();
+
+    //The transfer curve tables and the latency are updated here instead of on the audio thread
+    void timerCallback() override;
+    void updateTransferCurves();
+    KcompTransferCurve<float>::Settings getCurveSettings(int band) const;
     
+    //the gain the engine applied, read by the meter on the message thread
+    KcompGainFifo gainReductionFifo;
     LevelMeter::LevelMeterGetter levelMeterGetter;
 
     juce::AudioProcessorValueTreeState parameters;
 
-    using Gain = juce::dsp::Gain<float>;
-    using Filter = juce::dsp::ProcessorDuplicator<juce::dsp::IIR::Filter<float>, juce::dsp::IIR::Coefficients<float>>;
-    using Comp = juce::dsp::Compressor<float>;
-
-    Gain inputGain;
-
-    juce::dsp::ProcessorChain<Filter, Comp, Gain> kComp;
-
-    Gain outputGain;
-    juce::dsp::DryWetMixer<float> dryWet;
-
-    
-    float ratioOne{ 1.5f };
-    float ratioTwo{ 5.0f };
-    float ratioThree{ 10.0f };
-    float ratioFour{ 20.0f };
-
-    float dryWetMix{ 1.0f };
-
-    float filterFreq = 10000.0f;
-
-    float preRMSL;
-    float preRMSR;
-
-    juce::NormalisableRange<float>minMax;
-
-    float postRMSL;
-    float postRMSR;
+    //read once per block on the audio thread, the APVTS keeps them up to date from the GUI and host automation
+    std::atomic<float>* inputGainParam = nullptr;
+    std::atomic<float>* makeUpGainParam = nullptr;
+    std::atomic<float>* thresholdParam = nullptr;
+    std::atomic<float>* attackParam = nullptr;
+    std::atomic<float>* releaseParam = nullptr;
+    std::atomic<float>* autoTimingParam = nullptr;
+    std::atomic<float>* filterParam = nullptr;
+    std::atomic<float>* tameFrequencyParam = nullptr;
+    std::atomic<float>* tameSlopeParam = nullptr;
+    std::atomic<float>* tameTypeParam = nullptr;
+    std::atomic<float>* tameDynamicParam = nullptr;
+    std::atomic<float>* tameThresholdParam = nullptr;
+    std::atomic<float>* tameRatioParam = nullptr;
+    std::atomic<float>* dryWetParam = nullptr;
+    std::atomic<float>* ratioParam = nullptr;
+    std::atomic<float>* kneeParam = nullptr;
+    std::atomic<float>* upperStageParam = nullptr;
+    std::atomic<float>* upperThresholdParam = nullptr;
+    std::atomic<float>* upperRatioParam = nullptr;
+    std::atomic<float>* outputGainParam = nullptr;
+    std::atomic<float>* linkParam = nullptr;
+    std::atomic<float>* linkAmountParam = nullptr;
+    std::atomic<float>* stereoModeParam = nullptr;
+    std::atomic<float>* meterBallisticsParam = nullptr;
+    std::atomic<float>* lookaheadParam = nullptr;
+    std::atomic<float>* oversamplingParam = nullptr;
+    std::atomic<float>* oversamplingFilterParam = nullptr;
+    std::atomic<float>* bandsParam = nullptr;
+    std::atomic<float>* sidechainParam = nullptr;
+    std::atomic<float>* keyHighPassParam = nullptr;
+    std::atomic<float>* keyLowPassParam = nullptr;
+    std::atomic<float>* keyListenParam = nullptr;
+    std::atomic<float>* detectorParam = nullptr;
+    std::atomic<float>* rmsWindowParam = nullptr;
+    std::atomic<float>* topologyParam = nullptr;
+    std::atomic<float>* feedbackMixParam = nullptr;
+    std::atomic<float>* crossoverParams[KcompEngine<float>::maxBands - 1]{};
+    std::atomic<float>* bandThresholdParams[KcompEngine<float>::maxBands - 1]{};
+    std::atomic<float>* bandRatioParams[KcompEngine<float>::maxBands - 1]{};
+    std::atomic<float>* bandKneeParams[KcompEngine<float>::maxBands - 1]{};
+    std::atomic<float>* bandAttackParams[KcompEngine<float>::maxBands - 1]{};
+    std::atomic<float>* bandReleaseParams[KcompEngine<float>::maxBands - 1]{};
+
+    KcompEngine<float> engine;
+    KcompEngine<double> doubleEngine;
+
+    //the host may ask for the tail from any thread
+    std::atomic<double> tailSeconds{ 0.0 };
+
+    //the curves each engine was last given, whoever holds the lock is the only one publishing
+    static constexpr int curveUpdateHz = 30;
+    juce::SpinLock curveLock;
+    KcompTransferCurve<float>::Settings publishedCurves[KcompEngine<float>::maxBands];
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (KcompAudioProcessor)